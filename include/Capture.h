@@ -0,0 +1,104 @@
+/**
+ * @file Capture.h
+ * @author Doug Fajardo
+ * @brief Record both wheels at the control tick rate, for download afterwards
+ * @version 0.1
+ * @date 2025-09-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Step responses need the encoder counts at every control tick, far more
+ * than periodic reports can carry while the robot runs. A capture keeps
+ * one Record per sample in a ring in PSRAM (CAPTURE_PSRAM_BYTES when the
+ * board has it, else CAPTURE_SRAM_BYTES of internal RAM), and sends
+ * nothing until it is done:
+ *
+ *   (1) arm()     - with a trigger: now, or the next motion command (MOVE...),
+ *                   a divider (one sample every <divider> control ticks),
+ *                   how many samples to keep from before the trigger,
+ *                   and how many to take from the trigger on.
+ *   (2) the control loop adds a sample every <divider> ticks. Before the
+ *       trigger the ring just wraps, keeping the latest ones.
+ *   (3) when the samples after the trigger are all in, it is done, and
+ *       read() gets the records in time order, in chunks.
+ *
+ * Record layout (little-endian, CAPTURE_RECORD_SIZE bytes, as the host decodes it):
+ *   uint32 timeUs      esp_timer time, low 32 bits
+ *   int32  count[2]    encoder counts, left and right (low 32 bits of the accumulated count)
+ *   int16  duty[2]     ln298 pulse width, -100..100 %
+ *   int16  output[2]   PID output, in 1/100 %
+ *
+ * The control loop's task is the only writer of the ring. The other
+ * calls are for the command task; read() only works once it is done,
+ * when nothing writes the ring any more.
+ */
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+#define CAPTURE_RECORD_SIZE   20
+
+class Capture
+{
+    public:
+        struct Record
+        {
+            uint32_t timeUs;
+            int32_t  count[2];
+            int16_t  duty[2];
+            int16_t  output[2];
+        };
+
+        enum State { CAPTURE_IDLE, CAPTURE_ARMED, CAPTURE_RUNNING, CAPTURE_DONE };
+        enum Trigger { TRIGGER_NOW, TRIGGER_MOTION };
+
+        struct Status
+        {
+            State    state;
+            uint32_t records;       // records that read() can return
+            uint32_t triggerIndex;  // index (for read()) of the first record at or after the trigger
+            uint32_t triggerUs;     // esp_timer time of the trigger, low 32 bits
+            uint32_t divider;
+            uint32_t capacity;      // records the ring holds
+        };
+
+    private:
+        Record  *ring;
+        uint32_t capacity;
+        bool     inPsram;
+
+        // Set by arm(), while nothing is recording
+        Trigger  trigger;
+        uint32_t divider;
+        uint32_t preSamples;
+        uint32_t postSamples;
+
+        // Control loop task only (once armed)
+        uint32_t written;        // samples written since arm()
+        uint32_t triggeredAt;    // <written> when the trigger came
+        uint32_t triggerUs;
+        uint32_t tickCount;      // ticks since the last sample
+
+        std::atomic<int>  state;
+        std::atomic<bool> triggerRequested;
+        std::atomic<bool> stopRequested;
+
+        uint32_t firstRecord();  // ring index (unwrapped) of the first record read() returns
+
+    public:
+        Capture();
+        ~Capture();
+        bool allocate();         // get the ring, false if there is no memory
+        bool arm(Trigger _trigger, uint32_t _divider, uint32_t pre, uint32_t post);
+        void triggerOnMotion();  // a motion command came (any task)
+        void stop();             // finish now, with what was recorded
+
+        bool sampleDue();        // control loop: true if this tick is to be recorded
+        void add(const Record &rec);
+
+        Status getStatus();
+        bool   isInPsram() { return(inPsram); }
+        int    read(uint32_t index, Record *out, int maxRecords);  // records copied, -1 if not done
+
+        static int encodeBase64(const uint8_t *data, int length, char *text);
+};
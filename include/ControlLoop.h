@@ -0,0 +1,87 @@
+/**
+ * @file ControlLoop.h
+ * @author Doug Fajardo
+ * @brief One clock for the speed checks, PIDs and motor outputs of all the wheels
+ * @version 0.1
+ * @date 2025-09-10
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Without it each wheel has a SpeedTimer and a PIDtimer, with unrelated
+ * phases, so a PID works on a speed of random age and the two wheels
+ * are measured at different times. The control loop stops those timers
+ * and, on every tick of its own esp_timer, in this order:
+ *   (1) samples every wheel's encoder count, back to back, with one timestamp
+ *   (2) updates every wheel's speed
+ *   (3) runs every wheel's PID (PIDX::ComputeCore())
+ *   (4) writes every wheel's motor duty (ln298)
+ * so each PID works on a speed that is fresh from the same tick, both
+ * wheels are measured over the same interval, and the time from
+ * sensing to actuating is just the work of one tick.
+ *
+ * The rate (ticks per second) is the one tunable: CONTROL_RATE_HZ at start,
+ * CONTROL_RATE_MIN_HZ to CONTROL_RATE_MAX_HZ with setRate(). The PIDs'
+ * sample time follows it.
+ *
+ * At the end of a tick, if a capture is armed (see Capture.h), it records
+ * both wheels' counts, duties and PID outputs from that tick.
+ */
+#pragma once
+#include "config.h"
+#include "esp_timer.h"
+#include "SeqLock.h"
+#include "DEV_QuadDecoder.h"
+#include "DEV_Pid.h"
+#include "DEV_ln298.h"
+#include "Capture.h"
+#include <atomic>
+
+#define MAX_CONTROL_WHEELS 2
+
+class ControlLoop
+{
+    public:
+        struct TickStats
+        {
+            uint32_t ticks;        // ticks since start (or resetStats())
+            uint32_t overruns;     // ticks whose work took longer than the period
+            uint32_t lastRunUs;    // time the latest tick's work took
+            uint32_t maxRunUs;
+            uint32_t maxJitterUs;  // largest difference between a tick interval and the period
+        };
+
+    private:
+        struct Wheel
+        {
+            DEV_QuadDecoder *quad;
+            DEV_Pid         *pid;
+            DEV_LN298       *ln298;
+        };
+        Wheel wheels[MAX_CONTROL_WHEELS];
+        int   wheelCount;
+        esp_timer_handle_t tickTimerhandle;
+
+        Mailbox<uint32_t>  periodUs;       // setRate() -> tick()
+        uint32_t           appliedWrites;  // tick() only: periodUs.writes() the wheels were last set for
+        time_t             lastTickUs;     // tick() only: start of the previous tick, 0 = none
+        TickStats          stats;          // tick() only
+        SeqLock<TickStats> published;      // tick() -> getStats()
+        std::atomic<bool>  resetRequested; // resetStats() asks tick() to clear its stats
+
+        static void tick_cb(void *arg);
+        void tick();
+        void captureTick(time_t now);
+
+    public:
+        Capture capture;   // arm/stop/read from the command task, filled by tick()
+
+        ControlLoop();
+        ~ControlLoop();
+        bool addWheel(DEV_QuadDecoder *quad, DEV_Pid *pid, DEV_LN298 *ln298);  // call before start()
+        void start(uint32_t rateHz);
+        bool setRate(uint32_t rateHz);  // false if out of range
+        uint32_t getRate();
+        uint32_t getPeriodUs();
+        TickStats getStats();
+        void resetStats();
+};
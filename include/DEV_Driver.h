@@ -23,6 +23,7 @@
 // #include "PID_v1.h"
 #include "DEV_Pid.h"
 #include "DefDevice.h"
+#include "ControlLoop.h"
 
 #define MAX_MOTOR_COUNT 2
 class DEV_Driver:public DefDevice
@@ -35,21 +36,41 @@ private:
         
     DEV_MotorControl  *leftMtr;
     DEV_MotorControl  *rightMtr;
+    ControlLoop       *control;   // one tick for both wheels' speed, PID and output
     
     // COMMAND SET: 
-    ProcessStatus cmdMOV(int argcnt, char *argv[]);   // FWD  <speed> <dir> (if no dir, then straight ahead)
-    ProcessStatus cmdSTOP(int argcnt, char *argv[]);  // Stop - setting stop rate.
-    ProcessStatus cmdSPEED(int argcnt, char *argv[]); // Set speed (used by joystick)
-    ProcessStatus cmdROTATION(int argcnt, char *argv[]);  // Set rotation rate (used by joystick)
-    ProcessStatus cmdDrift(int argcnt, char *argv[]);   // disable drivers
+    ProcessStatus cmdMOV(int argcnt, const ParamSpan *argv, DPacket &reply);   // FWD  <speed> <dir> (if no dir, then straight ahead)
+    ProcessStatus cmdSTOP(int argcnt, const ParamSpan *argv, DPacket &reply);  // Stop - setting stop rate.
+    ProcessStatus cmdSPEED(int argcnt, const ParamSpan *argv, DPacket &reply); // Set speed (used by joystick)
+    ProcessStatus cmdROTATION(int argcnt, const ParamSpan *argv, DPacket &reply);  // Set rotation rate (used by joystick)
+    ProcessStatus cmdDrift(int argcnt, const ParamSpan *argv, DPacket &reply);   // disable drivers
+    ProcessStatus cmdCtlRate(int argcnt, const ParamSpan *argv, DPacket &reply);  // CRAT <hz> control loop rate
+    ProcessStatus cmdCtlTicks(int argcnt, const ParamSpan *argv, DPacket &reply); // CTIK control loop tick statistics
+    ProcessStatus cmdCapture(int argcnt, const ParamSpan *argv, DPacket &reply);  // CAPT arm, stop or report a capture
+    ProcessStatus cmdCaptureGet(int argcnt, const ParamSpan *argv, DPacket &reply); // CGET <index> download capture records
+
+    // Driver commands, in alphabetical order (see CommandTable.h)
+    static constexpr CommandEntry<ProcessStatus (DEV_Driver::*)(int, const ParamSpan *, DPacket &)> commandTable[] =
+    {
+        { CommandKey("CAPT"), &DEV_Driver::cmdCapture    },
+        { CommandKey("CGET"), &DEV_Driver::cmdCaptureGet },
+        { CommandKey("CRAT"), &DEV_Driver::cmdCtlRate    },
+        { CommandKey("CTIK"), &DEV_Driver::cmdCtlTicks   },
+        { CommandKey("DRFT"), &DEV_Driver::cmdDrift      },
+        { CommandKey("MOVE"), &DEV_Driver::cmdMOV        },
+        { CommandKey("ROTA"), &DEV_Driver::cmdROTATION   },
+        { CommandKey("SPED"), &DEV_Driver::cmdSPEED      },
+        { CommandKey("STOP"), &DEV_Driver::cmdSTOP       },
+    };
+    static_assert(CommandTableSorted(commandTable), "Driver commands must be in alphabetical order");
 
 
 public:
     DEV_Driver(const char * name, Node *_Node);
     ~DEV_Driver();
     void setup(MotorControl_config_t *left_cfg, MotorControl_config_t *right_cfg); // Instantiate all the subtasks...
-    ProcessStatus  ExecuteCommand () override;  // Override this method to handle custom commands
-    ProcessStatus  DoPeriodic() override;       
+    ProcessStatus  ExecuteCommand (CPacket &command, DPacket &reply) override;  // Override this method to handle custom commands
+    ProcessStatus  DoPeriodic(DPacket &packet) override;       
 
     void setMotion(int speed, int _rotation);
 };
\ No newline at end of file
@@ -106,6 +106,12 @@
  * 
  *              WRITER:   set taskIsWriting.  If readerCount>0, then unset taskIsWriting and wait.
  *                 (when write is done, unset taskIsWriting).
+ *
+ *  9/02/2025 DEF Ver 3.2.0
+ *         The readings, their timestamp and the read counter are published together
+ *         through a SeqLock (see SeqLock.h) instead of a spinlock that disabled interrupts:
+ *         the read task never waits, and readers always get all 6 values from one reading.
+ *         The read interval is handed to the read task through a Mailbox.
  */
 
 #pragma once
@@ -117,8 +123,9 @@
 #include "FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "SeqLock.h"
 
-#define INA3221Version "3.1.0"
+#define INA3221Version "3.2.0"
 
 
 
@@ -126,16 +133,19 @@ class DEV_INA3221: public Adafruit_INA3221, public DefDevice
 {
 private:
     int i2cAddr;
-    static portMUX_TYPE INA3221_Data_Access_Spinlock;
-    time_t dts_msec;   // Timestamp When the data was last updated
-    float dataReadings[6];  // The values read from the INA3221. The 1st three (0..2) are
-                            //  Voltages for channles 0..2,  The last three (3,4,5) are
-                            //  the Currents for channels 0..2.
- 
-    unsigned long long readCounter;  // How many times have we read data?
+    struct Readings
+    {
+        float dataReadings[6];           // The values read from the INA3221. The 1st three (0..2) are
+                                         //  Voltages for channles 0..2,  The last three (3,4,5) are
+                                         //  the Currents for channels 0..2.
+        time_t dts_msec;                 // Timestamp When the data was last updated
+        unsigned long long readCounter;  // How many times have we read data?
+    };
+    SeqLock<Readings> readings;     // Written by readDataTask() only
+
     int noOfSamplesPerReading;      // How many samples does INA3221 average per data point?
     time_t sampleTimeUs;           // how long for each sample? (INA3321 parameter uSecs)
-    time_t sampleReadIntervalMs;  // How between data readings? (ticks)
+    Mailbox<time_t> sampleReadIntervalMs;  // How between data readings? (Msecs, read by readDataTask())
     time_t updateSampleReadInterval(time_t timeInMsecs);   // set the data reading interval, tell subtask
 
     // Locks and subtask
@@ -155,7 +165,8 @@ private:
     public:
         INA3221DeviceChannel(const char *inName, DEV_INA3221 *_me, int dataPtNo);
         ~INA3221DeviceChannel();
-        ProcessStatus DoPeriodic() override; // Override this method for processing your device periodically
+        ProcessStatus DoPeriodic(DPacket &packet) override; // Override this method for processing your device periodically
+        bool SampleField(int field, DPacket &packet) override;  // 0 = the reading (for subscriptions)
     };
      // = = = = = = = = = = = = = = = = = = = = = = = = = 
 
@@ -163,18 +174,29 @@ public:
     DEV_INA3221(const char *inName, int _i2CAddr, Node *myNode, TwoWire *theWire);
     ~DEV_INA3221();
     bool initStatusOk;                   // True if init was okay. false if any error
-    ProcessStatus DoPeriodic() override; // Override this method for processing your device periodically
+    ProcessStatus DoPeriodic(DPacket &packet) override; // Override this method for processing your device periodically
+    bool SampleField(int field, DPacket &packet) override;  // 1 = read count, 2..7 = the readings (for subscriptions)
     // ProcessStatus DoImmediate()    override;
-    ProcessStatus ExecuteCommand() override;
-    ProcessStatus gpowerCommand();
-    ProcessStatus setAveragingModeCommand();
-    ProcessStatus setTimePerSampleCommand();
-    ProcessStatus setSampleRateCommand();
+    ProcessStatus ExecuteCommand(CPacket &command, DPacket &reply) override;
+    ProcessStatus gpowerCommand(CPacket &command, DPacket &reply);
+    ProcessStatus setAveragingModeCommand(CPacket &command, DPacket &reply);
+    ProcessStatus setTimePerSampleCommand(CPacket &command, DPacket &reply);
+    ProcessStatus setSampleRateCommand(CPacket &command, DPacket &reply);
 
-    ProcessStatus setAvgCount(int noOfSamples);
-    ProcessStatus setConvTime(int _time);
+    ProcessStatus setAvgCount(int noOfSamples, DPacket &reply);
+    ProcessStatus setConvTime(int _time, DPacket &reply);
     ProcessStatus setSampleRate();
 
     void getDataReading(int idx, float *dta, unsigned long *timeStamp);
     friend class INA3221DeviceChannel;
+
+private:
+    // INA3221 commands, in alphabetical order (see CommandTable.h)
+    static constexpr CommandEntry<CommandHandler<DEV_INA3221>> commandTable[] =
+    {
+        { CommandKey("RATE"), &DEV_INA3221::setSampleRateCommand    },
+        { CommandKey("SAVG"), &DEV_INA3221::setAveragingModeCommand },
+        { CommandKey("STIM"), &DEV_INA3221::setTimePerSampleCommand },
+    };
+    static_assert(CommandTableSorted(commandTable), "INA3221 commands must be in alphabetical order");
 };
@@ -53,13 +53,21 @@ class DEV_MotorControl: public DefDevice
         void setup( MotorControl_config_t *cfg, const char *prefix);
         ~DEV_MotorControl();
 
-        ProcessStatus  DoPeriodic() override;
-        ProcessStatus  ExecuteCommand() override;
-        ProcessStatus cmdSetSpeed(int argCnt, char **argv);
+        ProcessStatus  DoPeriodic(DPacket &packet) override;
+        ProcessStatus  ExecuteCommand(CPacket &command, DPacket &reply) override;
+        ProcessStatus cmdSetSpeed(int argCnt, const ParamSpan *argv, DPacket &reply);
 
         // Operations - make it go
         void setSpeed(dist_t ratemm_sec);
         void setDrift();
         void setStop(int stopRate);  // rate is 0..100%
 
+    private:
+        // Motor control commands, in alphabetical order (see CommandTable.h)
+        static constexpr CommandEntry<ProcessStatus (DEV_MotorControl::*)(int, const ParamSpan *, DPacket &)> commandTable[] =
+        {
+            { CommandKey("MSPD"), &DEV_MotorControl::cmdSetSpeed },
+        };
+        static_assert(CommandTableSorted(commandTable), "Motor control commands must be in alphabetical order");
+
 };
\ No newline at end of file
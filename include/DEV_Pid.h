@@ -15,6 +15,7 @@
 #include "esp_timer.h"
 #include "DEV_QuadDecoder.h"
 #include "DEV_ln298.h"
+#include "SeqLock.h"
 
 
 class DEV_Pid : public DefDevice
@@ -25,15 +26,26 @@ class DEV_Pid : public DefDevice
         DEV_LN298       *ln298;   // pointer to the devuce we sebd the output to.
         esp_timer_handle_t pidTimerhandle;
         time_t          mySampleTime;
+        bool            controlLoopClock;   // a control loop calls computeOutput()/applyOutput(), no PIDtimer
 
     public:
         PIDX *pid;
         char *name;
 
         // The PID device requires we have our own storage for these...
+        //   They belong to computeOutput(); other tasks use the Mailbox and SeqLock below.
         double setPoint; // the value we want
         double actual;   // the actual value
         double output;   // what to set the motor (ln298) to
+
+        struct PidState
+        {
+            double setPoint;
+            double actual;
+            double output;
+        };
+        Mailbox<double>   requestedSpeed;  // setSpeed() -> computeOutput()
+        SeqLock<PidState> state;           // computeOutput() -> reports, one consistent snapshot
   
         double kp;
         double ki;
@@ -43,11 +55,16 @@ class DEV_Pid : public DefDevice
              DEV_QuadDecoder *_quad, DEV_LN298 *_ln298);
         ~DEV_Pid();
         static void timer_callback(void *arg);
-        ProcessStatus DoPeriodic() override;
+        bool computeOutput();        // these two run on the PID clock's task only
+        void applyOutput();
+        void clockFromControlLoop();
+        void setLoopPeriod(time_t periodUs);
+        ProcessStatus DoPeriodic(DPacket &packet) override;
+        bool SampleField(int field, DPacket &packet) override;  // 1 = setpoint, 2 = actual, 3 = output
         // ProcessStatus  DoImmediate    () override;
-        ProcessStatus ExecuteCommand() override;
+        ProcessStatus ExecuteCommand(CPacket &command, DPacket &reply) override;
 
-        ProcessStatus cmdSetSpeed(); // external command to directly 
+        ProcessStatus cmdSetSpeed(CPacket &command, DPacket &reply); // external command to directly 
                                      // set the 'setpoint' or 
                                      // desired speed. Same units as
                                      // used by QUAD.
@@ -56,18 +73,31 @@ class DEV_Pid : public DefDevice
                                      // or desired speed. Same units as
                                      // used by QUAD.
 
-        ProcessStatus cmdSetP();     // set the P Parameter
+        ProcessStatus cmdSetP(CPacket &command, DPacket &reply);     // set the P Parameter
         void setP(double _kp);
 
-        ProcessStatus cmdSetI();
+        ProcessStatus cmdSetI(CPacket &command, DPacket &reply);
         void setI(double _kp);
 
-        ProcessStatus cmdSetD();
+        ProcessStatus cmdSetD(CPacket &command, DPacket &reply);
         void setD(double _kp);
 
-        ProcessStatus cmdSetMode();
+        ProcessStatus cmdSetMode(CPacket &command, DPacket &reply);
         void setMode(bool modeIsAuto);
 
-        ProcessStatus cmdSetSTime();
+        ProcessStatus cmdSetSTime(CPacket &command, DPacket &reply);
         void setSampleClock(time_t intervalMs);
+
+    private:
+        // PID commands, in alphabetical order (see CommandTable.h)
+        static constexpr CommandEntry<CommandHandler<DEV_Pid>> commandTable[] =
+        {
+            { CommandKey("SETD"), &DEV_Pid::cmdSetD     },
+            { CommandKey("SETI"), &DEV_Pid::cmdSetI     },
+            { CommandKey("SETP"), &DEV_Pid::cmdSetP     },
+            { CommandKey("SMOD"), &DEV_Pid::cmdSetMode  },
+            { CommandKey("SPED"), &DEV_Pid::cmdSetSpeed },
+            { CommandKey("STIM"), &DEV_Pid::cmdSetSTime },
+        };
+        static_assert(CommandTableSorted(commandTable), "PID commands must be in alphabetical order");
 };
\ No newline at end of file
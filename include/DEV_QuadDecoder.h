@@ -11,10 +11,12 @@
 #pragma once
 #include <Arduino.h>
 #include "config.h"
-#include "config.h"
 #include "DefDevice.h"
 #include "ESP32Encoder.h"
 #include "esp_timer.h"
+#include "SeqLock.h"
+#include "Observer.h"
+#include <atomic>
 
 class DEV_QuadDecoder : public DefDevice
 {
@@ -22,9 +24,34 @@ class DEV_QuadDecoder : public DefDevice
     ESP32Encoder  *myEncoder;
     pulse_t pulsesPerRev;
     double wheelDiam;
-    pulse_t last_position;
+    pulse64_t last_position;
     time_t last_timecheck;
-    double last_speed;
+    SeqLock<double> last_speed;       // written by updateSpeed() only
+    std::atomic<bool> resetRequested; // resetPosition() asks sampleCount() to restart the estimate
+    bool restartPending;              // sampleCount() -> updateSpeed()
+    bool controlLoopClock;            // a control loop calls sampleCount()/updateSpeed(), no SpeedTimer
+    pulse_t  raw_count;               // encoder count at the last sampleCount(), low 32 bits
+    pulse64_t sample_position;        // accumulated count, taken by sampleCount(), used by updateSpeed()
+    uint32_t sample_edges;
+    uint32_t sample_edgeUs;
+    time_t   sample_time;
+    double last_periodSpeed;          // edge-period estimate, kept between speed checks
+    volatile uint32_t edgeUs;         // esp_timer time (low 32 bits) of the latest encoder edge, set by edge_isr()
+    volatile uint32_t edgeCount;      // encoder edges seen by edge_isr()
+    uint32_t last_edgeUs;             // edgeUs used by the previous speed check
+    uint32_t last_edgeCount;
+    pulse64_t last_edgePosition;      // accumulated count right after that edge
+    static void edge_isr(void *arg);
+    Observer observer;                // position/velocity/acceleration, counts (speed clock's task only)
+    time_t   observerTime;            // esp_timer time the observer is at
+    struct ObserverNoise
+    {
+        double process;               // counts^2/sec^5
+        double measurement;           // counts^2
+    };
+    Mailbox<ObserverNoise> observerNoise;   // QOBS -> updateObserver()
+    uint32_t observerNoiseWrites;     // observerNoise.writes() last applied
+    void updateObserver(pulse64_t pos_now, pulse_t pos_diff, bool newEdge, uint32_t edge_at, time_t now);
     time_t currentSpdCheckRate;
     double pulsesToDist;  // converts pulse count to engineering units 
     static void update_speed_cb(void *arg);
@@ -32,20 +59,62 @@ class DEV_QuadDecoder : public DefDevice
     double *getSpeedPointer();
     
 
+    public:
+    struct Position
+    {
+        pulse64_t count;      // accumulated encoder count since start (or resetPosition())
+        double    distance;   // count * pulsesToDist, as getPosition() returns it
+    };
+    struct Estimate
+    {
+        double position;      // same units as getPosition()
+        double velocity;      // same units as getSpeed()
+        double acceleration;  // velocity units per mSec
+    };
+
+    private:
+    SeqLock<Estimate> estimate;       // updateObserver() -> getEstimate()
+    SeqLock<Position> position;       // sampleCount() -> getPosition(), getCount()
+
     public:
     DEV_QuadDecoder( const char * InName);
     ~DEV_QuadDecoder();
     void setup(MotorControl_config_t*cfg);
-    ProcessStatus  ExecuteCommand () override;    // Override this method to handle custom commands
-    ProcessStatus  DoPeriodic() override;         // Override this method to periodically send reports
+    ProcessStatus  ExecuteCommand (CPacket &command, DPacket &reply) override;  // Override this method to handle custom commands
+    ProcessStatus  DoPeriodic(DPacket &packet) override;         // Override this method to periodically send reports
+    bool           SampleField(int field, DPacket &packet) override;  // 0 = position, 1 = speed, 3 = velocity, 4 = acceleration
 
-    ProcessStatus qsetCommand();
-    ProcessStatus qsckCommand();
+    ProcessStatus qsetCommand(CPacket &command, DPacket &reply);
+    ProcessStatus qsckCommand(CPacket &command, DPacket &reply);
+    ProcessStatus qrstCommand(CPacket &command, DPacket &reply);
+    ProcessStatus qobsCommand(CPacket &command, DPacket &reply);
+    ProcessStatus qestCommand(CPacket &command, DPacket &reply);
     void setPhysParams(pulse_t pulseCnt, double diam);
 
     void setSpeedCheckInterval(time_t interval);
-    double getPosition();
-    double getSpeed();
+    void clockFromControlLoop();
+    void setLoopPeriod(time_t periodUs);
+    void sampleCount(time_t now);   // these two run on the speed clock's task only
+    void updateSpeed();
+    pulse64_t getSampledCount(); // count taken by the latest sampleCount() (speed clock's task)
+    pulse64_t getCount();       // accumulated count, as of the latest sampleCount()
+    double getPosition();       // getCount() in distance units, converted once per sample
+    double getSpeed();          // speed check estimate (edge period / count delta)
+    double getVelocity();       // observer estimate: smoother, for the PID
+    Estimate getEstimate();
+    void   setObserverNoise(double processNoise, double measurementNoise);
     void   resetPosition();
+
+    private:
+    // QUAD commands, in alphabetical order (see CommandTable.h)
+    static constexpr CommandEntry<CommandHandler<DEV_QuadDecoder>> commandTable[] =
+    {
+        { CommandKey("QEST"), &DEV_QuadDecoder::qestCommand },
+        { CommandKey("QOBS"), &DEV_QuadDecoder::qobsCommand },
+        { CommandKey("QRST"), &DEV_QuadDecoder::qrstCommand },
+        { CommandKey("QSCK"), &DEV_QuadDecoder::qsckCommand },
+        { CommandKey("QSET"), &DEV_QuadDecoder::qsetCommand },
+    };
+    static_assert(CommandTableSorted(commandTable), "QUAD commands must be in alphabetical order");
 };
 
@@ -41,14 +41,27 @@ class DEV_LN298 : public DefDevice
         void setupLN298(MotorControl_config_t *cfg);
         ~DEV_LN298();
         bool isDisabled();    // is the motor disabled?
-        ProcessStatus  ExecuteCommand () override;
-        ProcessStatus  DoPeriodic()  override;
-        ProcessStatus  setPulseWidthCommand();
+        ProcessStatus  ExecuteCommand (CPacket &command, DPacket &reply) override;
+        ProcessStatus  DoPeriodic(DPacket &packet)  override;
+        bool           SampleField(int field, DPacket &packet) override;  // 1 = pulse width (for subscriptions)
+        ProcessStatus  setPulseWidthCommand(CPacket &command, DPacket &reply);
         bool setPulseWidth(int pcnt); // Set the pulse width (0..100)
         int getPulseWidth();       // What pulse width was last set?
         void setReportStatus(bool enaFlag);
-        ProcessStatus enable(bool isRemoteCmd=false);
-        ProcessStatus disable(bool isRemoteCmd=false);
-        ProcessStatus hardStop(bool isRemoteCmd=false);
+        ProcessStatus enable(DPacket *reply=nullptr);
+        ProcessStatus disable(DPacket *reply=nullptr);
+        ProcessStatus hardStop(DPacket *reply=nullptr);
+        ProcessStatus enableCommand(CPacket &command, DPacket &reply);
+        ProcessStatus disableCommand(CPacket &command, DPacket &reply);
+
+    private:
+        // LN298 commands, in alphabetical order (see CommandTable.h)
+        static constexpr CommandEntry<CommandHandler<DEV_LN298>> commandTable[] =
+        {
+            { CommandKey("DISA"), &DEV_LN298::disableCommand       },
+            { CommandKey("ENAB"), &DEV_LN298::enableCommand        },
+            { CommandKey("SPWM"), &DEV_LN298::setPulseWidthCommand },
+        };
+        static_assert(CommandTableSorted(commandTable), "LN298 commands must be in alphabetical order");
 
 };
\ No newline at end of file
@@ -0,0 +1,48 @@
+/**
+ * @file Observer.h
+ * @author Doug Fajardo
+ * @brief Kalman observer of a wheel's position, velocity and acceleration
+ * @version 0.1
+ * @date 2025-09-14
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * A count difference over one short tick is mostly quantization noise
+ * (one count more or less is a big change in speed), and over a long tick
+ * it lags. This filter tracks position, velocity and acceleration with a
+ * constant-acceleration model, and corrects it with each encoder count:
+ *
+ *   processNoise (q)     - how quickly the acceleration may change, as the
+ *                          spectral density of jerk, in counts^2/sec^5.
+ *                          Larger follows changes faster, but is noisier.
+ *   measurementNoise (r) - variance of a count reading, in counts^2.
+ *                          Quantization alone is 1/12.
+ *
+ * All units inside are counts and seconds. One update is a few dozen
+ * multiplies, so it can run every control tick.
+ */
+#pragma once
+
+#define OBSERVER_INIT_VARIANCE  1.0e12   // velocity and acceleration variance after reset(): unknown
+
+class Observer
+{
+    private:
+        double x[3];      // position (counts), velocity (counts/sec), acceleration (counts/sec^2)
+        double P[3][3];   // covariance of x
+        double q;         // process noise, counts^2/sec^5
+        double r;         // measurement noise, counts^2
+
+    public:
+        Observer(double processNoise, double measurementNoise);
+        void reset(double position);
+        void setNoise(double processNoise, double measurementNoise);
+        void update(double measuredPosition, double dtSec);  // predict(), then correct()
+        void predict(double dtSec);
+        void correct(double measuredPosition);
+        void limitVelocity(double maxAbs);
+
+        double position()     { return(x[0]); }
+        double velocity()     { return(x[1]); }
+        double acceleration() { return(x[2]); }
+};
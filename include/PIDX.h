@@ -55,6 +55,8 @@ class PIDX
 										  //   once it is set in the constructor.
     void SetSampleTime(int);              // * sets the frequency, in Milliseconds, with which 
                                           //   the PID calculation is performed.  default is 100
+    void SetSampleTimeUs(unsigned long);  // * same, in Microseconds, for periods that are not
+                                          //   whole milliseconds
 										  
 										  
 										  
@@ -88,6 +90,7 @@ class PIDX
 	double outputSum, lastInput;
 
 	unsigned long SampleTime;
+	unsigned long SampleTimeUs;   // SampleTime in microseconds, used for the gain scaling
 	double outMin, outMax;
 	bool inAuto, pOnE;
 };
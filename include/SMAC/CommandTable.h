@@ -0,0 +1,103 @@
+//=========================================================
+//
+//     FILE : CommandTable.h
+//
+//  PROJECT : SMAC Framework
+//              │
+//              └── Firmware
+//                    │
+//                    └── Node
+//
+//    NOTES : Table-driven command dispatch:
+//
+//            █ A 4-char command is packed into a uint32_t key with CommandKey().
+//              The first char is the most significant byte, so sorting by key sorts
+//              the commands alphabetically.  Lower case letters are folded to upper case.
+//
+//              The Node packs the incoming command once into the CPacket's <key>.
+//
+//            █ Each class declares its commands in a static constexpr table of
+//              { key, member handler } entries, listed in alphabetical order.
+//              A CommandHandler receives the command and the DPacket for its reply:
+//
+//                ProcessStatus MyDevice::CmdZero (CPacket &command, DPacket &reply);
+//
+//                static constexpr CommandEntry<CommandHandler<MyDevice>> commandTable[] =
+//                {
+//                  { CommandKey ("CALI"), &MyDevice::CmdCalibrate },
+//                  { CommandKey ("ZERO"), &MyDevice::CmdZero      },
+//                };
+//                static_assert (CommandTableSorted (commandTable), "MyDevice commands must be in alphabetical order");
+//
+//            █ FindCommand() binary searches a table for a key, so the cost of dispatch is
+//              about log2(N) integer compares no matter how many commands a class has.
+//              It returns NULL if the command is not in the table.
+//
+//   AUTHOR : Bill Daniels
+//            Copyright 2021-2025, D+S Tech Labs, Inc.
+//            All Rights Reserved
+//
+//=========================================================
+
+#ifndef COMMANDTABLE_H
+#define COMMANDTABLE_H
+
+//--- Includes --------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+#include "common.h"
+
+//--- Command Keys ----------------------------------------
+
+constexpr uint32_t CommandChar (char c)
+{
+  return (uint32_t)(uint8_t)((c >= 'a' && c <= 'z') ? c - ('a' - 'A') : c);
+}
+
+constexpr uint32_t CommandKey (const char *command)
+{
+  return (CommandChar (command[0]) << 24) | (CommandChar (command[1]) << 16) |
+         (CommandChar (command[2]) <<  8) |  CommandChar (command[3]);
+}
+
+//--- Command Tables --------------------------------------
+
+template <class T>
+using CommandHandler = ProcessStatus (T::*) (CPacket &command, DPacket &reply);
+
+template <typename Handler>
+struct CommandEntry
+{
+  uint32_t  key;
+  Handler   handler;
+};
+
+template <typename Handler, size_t N>
+constexpr bool CommandTableSorted (const CommandEntry<Handler> (&table)[N], size_t i = 1)
+{
+  // Keys must be strictly increasing (sorted, no duplicates)
+  return (i >= N) || (table[i-1].key < table[i].key && CommandTableSorted (table, i + 1));
+}
+
+template <typename Handler, size_t N>
+const CommandEntry<Handler> * FindCommand (const CommandEntry<Handler> (&table)[N], uint32_t key)
+{
+  size_t  low = 0, high = N;
+
+  while (low < high)
+  {
+    size_t mid = (low + high) / 2;
+
+    if (table[mid].key < key)
+      low = mid + 1;
+    else if (table[mid].key > key)
+      high = mid;
+    else
+      return &table[mid];
+  }
+
+  return NULL;
+}
+
+#endif
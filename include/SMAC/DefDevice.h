@@ -9,9 +9,11 @@
  * 
  * This superclass adds the following to the SMAC 'Device'
  * class -
- *  (1) scanParam - parses a string into a list of '|' separated 
- *      tokens (null-temrinated strings).  The result is available 
- *      in the 'arglist[n]', where n is the index of each token (0...5).
+ *  (1) scanParam - picks up the list of '|' separated tokens the
+ *      Node found in the command's params (read-only pointer+length
+ *      spans, not null-terminated).  The result is available in the
+ *      'arglist[n]', where n is the index of each token (0...MAX_PARAM_TOKENS-1).
+ *      It also remembers the reply packet for the error messages of (2).
  *  
  *  (2) Functions for parsing and decoding a token into various numeric
  *      types.
@@ -19,24 +21,25 @@
 #pragma once
 #include "common.h"
 #include "Device.h"
+#include "CommandTable.h"
 
-// This is the max number of arguments allowed. It defines the size of 
-//   the arglist array, so should be kept to a rasonable size.
-#define  DEFDEVICE_MAX_ARGS  5
 class DefDevice : public Device
 {
     private:
         ProcessStatus   argCountCheck(int argno, const char* msg);
         
     protected:
-        char *arglist[DEFDEVICE_MAX_ARGS];
-        int argCount;
-        int   scanParam();  // scan the parameter list
-        bool  isCommand(const char *cmd);
+        const ParamSpan *arglist = nullptr;  // the command's tokens (see CPacket), valid during ExecuteCommand()
+        int argCount = 0;
+        DPacket *argReply = nullptr;  // where the get... functions put error messages
+        int   scanParam(const CPacket &command, DPacket &reply);  // scan the parameter list
+        bool  isCommand(const CPacket &command, const char *cmd);
 
         ProcessStatus   getUInt8(int arg, uint8_t *result, const char *msg);
         ProcessStatus   getLLint(int arg, long long  *result, const char *msg);
+        ProcessStatus   getUint16(int arg, uint16_t *result, const char *msg);
         ProcessStatus   getUint32(int arg, uint32_t *result, const char *msg);
+        ProcessStatus   getInt16(int arg,  int16_t *result, const char *msg);
         ProcessStatus   getInt32(int arg,  int32_t *result, const char *msg);
         ProcessStatus   getInt  (int arg,  int   *result,  const char *msg);
         ProcessStatus   getDouble(int arg, double *result, const char *msg);
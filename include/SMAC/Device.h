@@ -23,39 +23,132 @@
 //                as little delay as possible between operations.
 //
 //              ∙ A Periodic Process is an operation to be performed at a periodic rate such as reading a
-//                sensor once per second or minute.  Minimum rate is 1/hr.  Maximum rate is 20/sec.
+//                sensor once per second or minute.  Minimum rate is 1/hr.  Maximum rate is 1000/sec.
 //
 //              ∙ You define your Immediate Process by overriding the virtual DoImmediate() method.
 //
 //              ∙ You define your Periodic Process by overriding the virtual DoPeriodic() method.
 //
-//              ∙ The rate of calls to DoPeriodic() is set in "calls per hour" (1 - 72,000)
-//                It defaults to 3600 (one call per second).
+//              ∙ The rate of calls to DoPeriodic() is set in "calls per hour" (1 - 3,600,000)
+//                or in Hz (up to MAX_PERIODIC_RATE_HZ).  It defaults to 3600 (one call per second)
+//                and is kept as a period in microseconds.
 //
 //                      1 = one sample per hour   (the slowest data rate)
 //                     60 = one sample per minute (for example, a temperature plot for a day)
 //                   3600 = one sample per second (default)
-//                  72000 = 20 samples per second (recommended fastest data rate)
+//                  72000 = 20 samples per second
+//                3600000 = 1000 samples per second (the fastest data rate, for control telemetry)
 //
-//                Use the SRAT command in ExecuteCommand() to set the periodic rate.
+//                Use the SRAT (calls per hour) or SRHZ (Hz) command to set the periodic rate.
+//                At high rates pair it with report on change (SDBD), the radio cannot carry
+//                a report per call from many Devices.
 //
-//              ∙ If either process has data to return, it should populate the global <DataPacket> timestamp
-//                and value fields, then return one of the <ProcessStatus> enums, usually SUCCESS_DATA.
+//              ∙ The Node's Scheduler calls DoPeriodic() only when this Device is due, at a
+//                drift-free rate (see Scheduler.h).  Once added to a Node, a Device should use
+//                EnablePeriodic() rather than setting <periodicEnabled> so it is (re)scheduled.
 //
-//                The global <DataPacket> holds outgoing node/device data and has the following three fields:
+//              ∙ DoPeriodic() can read the deadline it was called for with ScheduledTimeUs().
+//                It is on an exact period grid, so it makes a jitter-free sample timestamp.
 //
-//                  char           *deviceID   : pointer to the 2-char deviceID (00-99)
+//              ∙ A Device that falls a full period or more behind follows its SchedulePolicy (SPOL):
+//                SCHEDULE_SKIP (default) drops the missed calls and stays on the period grid,
+//                SCHEDULE_CATCH_UP makes the missed calls back to back (up to MAX_CATCH_UP_PERIODS).
+//
+//              ∙ If no Device has Immediate Processing enabled, the Node sleeps between deadlines,
+//                so Devices without an Immediate Process should clear <immediateEnabled>.
+//
+//              ∙ Both processes are handed the DPacket to fill in (see common.h).  It belongs to the
+//                caller for this one call, so processes on different tasks never share a packet.
+//                If a process has data to return, it should populate the packet's timestamp and
+//                value fields, then return one of the <ProcessStatus> enums, usually SUCCESS_DATA.
+//
+//                A DPacket holds outgoing node/device data and has the following three fields:
+//
+//                  char           deviceID[]  : the 2-char deviceID (00-99), filled in by the Node
 //                  unsigned long  timestamp   : timestamp when value was aquired (usually millis())
 //                  char           value[..]   : variable length value string (including NULL terminating char)
 //                                               this can be a numerical value or a text message
 //
-//                <DataPacket.value> must be NULL terminated!
+//                <value> must be NULL terminated!
+//
+//              ∙ Periodic telemetry should instead use the packet's typed field helpers:
+//
+//                  packet.ClearFields ();
+//                  packet.AddFloatField (position);
+//                  packet.AddFloatField (speed);
+//                  packet.AddTextField  (name);
+//
+//                The Node renders typed fields as "field|field|..." in ASCII mode (the same text
+//                a sprintf would have made) or packs them little-endian in binary mode, so no
+//                float formatting is done at all when the Relayer has selected binary frames.
+//                Text fields point at the caller's chars, which must outlive the call.
+//
+//              ∙ RunPeriodic() does not call DoPeriodic() while the radio is behind, or while the Node's
+//                rate limits (SLIM) would drop its report anyway (TxBackpressure()), so a skipped report
+//                costs nothing.  A DoPeriodic() that does more than report (control work, say) must
+//                always run: set <periodicReportOnly> false.
+//                The rate limits treat a Device's reports as telemetry, unless it is a safety or status
+//                Device that calls SetTrafficClass (TRAFFIC_STATUS) (or is sent STCL|S).  Status reports
+//                keep going out after telemetry has been cut back, and command responses always do.
+//
+//              ∙ Periodic reports made of typed fields can be sent only when they change (SDBD command).
+//                A report then goes out when a numeric field has moved more than its deadband since
+//                the last report sent, a text field has changed, or the heartbeat (the longest
+//                silence allowed) has passed.  The rest are dropped by RunPeriodic() and counted.
+//                Value string reports and the replies to DOPP are always sent.
+//
+//              ∙ The Interface can also subscribe to single typed fields of a Device at their own rates
+//                (the Node's SSUB command).  The Node samples them with SampleField(), which adds the
+//                current value of one field, numbered by its position in the DoPeriodic() report:
+//
+//                  bool MyDevice::SampleField (int field, DPacket &packet)
+//                  {
+//                    switch (field)
+//                    {
+//                      case 0:  packet.AddFloatField (position);  return true;
+//                      case 1:  packet.AddFloatField (speed);     return true;
+//                    }
+//                    return false;
+//                  }
+//
+//                SampleField() runs on the Node's task (under the <taskLock> of a Device on its own task),
+//                so it should only read the latest values, never do the work of the process.
+//
+//              ∙ Code outside the processes (a timer callback, another task) can report at any time
+//                by filling in its own DPacket and calling SubmitReport (packet).  The Node's Run()
+//                task sends it.
+//
+//            █ A Device may run its processes on its own FreeRTOS task, pinned to a core, instead of the
+//              Node's Run() task.  Call RunOnTask() before adding the Device to its Node:
+//
+//                  motor->RunOnTask (1, 5);   // control on core 1 at priority 5
+//                  power->RunOnTask (0);      // slow I2C sensor on core 0 with WiFi
+//                  node->AddDevice (motor);
+//
+//              ∙ The task is started by the Node's first Run().  It has its own Scheduler and sleeps
+//                until its next deadline, so a slow DoPeriodic() no longer delays the other Devices.
+//
+//              ∙ Its reports go through SubmitReport(), so they are copied into the Node's report queue
+//                and sent by the Node's Run() task.  Text fields must therefore point at chars that stay
+//                put (names, literals), not at a buffer the next process rewrites.  A report that finds
+//                the queue full is dropped and counted.
+//
+//              ∙ Commands run on the Node's task, but hold this Device's <taskLock>, so they never
+//                run at the same time as DoPeriodic() or DoImmediate().
+//
+//              ∙ Immediate Processing on a Device task runs once per RTOS tick, so the idle task on
+//                that core (and its watchdog) still gets to run.
+//
+//            █ Every DoImmediate(), DoPeriodic() and ExecuteCommand() call is made through RunImmediate(),
+//              RunPeriodic() or RunCommand(), which time it into this Device's <profiles> (see Profile.h).
+//              The Node's GPRF command reports them.
 //
 //            █ All Devices can execute custom commands by overriding the virtual ExecuteCommand() method.
 //
 //              ∙ Both Nodes and Devices can receive commands from the User Interface (SMAC Interface)
 //
 //              ∙ ExecuteCommand() is the method called when a command is received targeted for this Device.
+//                It is handed the parsed command (a CPacket) and the DPacket for its reply.
 //                A command string holds the incoming command data and has the following four fields
 //                separated with the '|' char:
 //
@@ -78,13 +171,28 @@
 //                DOPP = Do Periodic Process          : Perform the periodic process one time, returns true or false
 //                GRAT = Get Rate                     : Get the current periodic process rate for this device in calls per hour:
 //                SRAT = Set Rate                     : Set the periodic process rate for this device in procs per hour
+//                GRHZ = Get Rate in Hz               : <reply> value = RATEHZ=calls per second
+//                SRHZ = Set Rate in Hz               : params = calls per second (up to MAX_PERIODIC_RATE_HZ)
+//                SPOL = Set Schedule Policy          : params = S (skip missed calls) or C (catch up), none reports it
+//                                                      <reply> value = POLICY=S or POLICY=C
 //                GDVR = Get Device Version           : Get the current version of this Device's firmware
+//                STCL = Set Traffic Class            : params = S (status) or T (telemetry, default), none reports it
+//                                                      <reply> value = TCLASS=S or TCLASS=T
+//                SDBD = Set Deadband                 : params = heartbeatMs|deadband0|deadband1|... (one per typed field)
+//                                                      Periodic reports are sent only on change, or after heartbeatMs of
+//                                                      silence.  Missing deadbands are 0 (any change), a negative one
+//                                                      ignores its field.  SDBD|0 reports every period (default).
+//                                                      <reply> value = DBAND=heartbeatMs|suppressed|deadband0|...
+//
+//              ∙ Built-in commands are dispatched through <commandTable> by their packed
+//                command <key> (see CommandTable.h).
 //
 //              ∙ Your child Device class can override ExecuteCommand() to handle custom commands,
-//                for example, CALI for a calibrate function.
+//                for example, CALI for a calibrate function.  Declare them in your own sorted
+//                command table and look them up with FindCommand() (see CommandTable.h).
 //
 //                Child Device classes should first call this base class's ExecuteCommand() to handle the built-in Device commands:
-//                  Device::ExecuteCommand(...)
+//                  Device::ExecuteCommand (command, reply)
 //                If the command is not handled by this base class, you can handle the command in your derived class.
 //
 //   AUTHOR : Bill Daniels
@@ -99,6 +207,18 @@
 //--- Includes --------------------------------------------
 
 #include "common.h"
+#include "CommandTable.h"
+#include "Scheduler.h"
+#include "Profile.h"
+#include "TokenBucket.h"
+#include <esp_timer.h>
+
+//--- Defines ---------------------------------------------
+
+#define DEFAULT_DEVICE_TASK_PRIORITY     2  // Above the loop() task (1)
+#define DEFAULT_DEVICE_TASK_STACK     4096  // Bytes
+#define MAX_PERIODIC_RATE_HZ          1000  // Fastest DoPeriodic() rate
+#define MAX_CATCH_UP_PERIODS             4  // SCHEDULE_CATCH_UP skips instead once this far behind
 
 
 //=========================================================
@@ -113,12 +233,91 @@ class Device
     char           version[MAX_VERSION_LENGTH] = "";    // A version number for this Node's firmware (yyyy.mm.dd<a-z>)
     bool           immediateEnabled = true;             // true to have DoImmediate called continuously (as fast as possible)
     bool           periodicEnabled  = true;             // true to have DoPeriodic called at the process period
-    unsigned long  processPeriod    = 1000L;            // milliseconds; default is 1 process per second
-    unsigned long  nextPeriodicTime = 0L;               // Next time to do the periodic process
+    bool           periodicReportOnly = true;           // false if DoPeriodic does more than report: it is then never skipped
+    int64_t        processPeriodUs  = 1000000;          // microseconds; default is 1 process per second
+    int64_t        nextPeriodicTime = 0;                // esp_timer time (uSecs) of the next periodic process
+    int64_t        periodicDeadline = 0;                // esp_timer time (uSecs) the current DoPeriodic() was due
+    SchedulePolicy schedulePolicy   = SCHEDULE_SKIP;    // What to do about missed periods (SPOL)
+    TrafficClass   trafficClass     = TRAFFIC_TELEMETRY;  // How the Node's rate limits treat its reports (STCL)
+    Scheduler      *scheduler       = NULL;             // Set by the parent Node when "added"
+    int            heapIndex        = -1;               // Position in the scheduler's heap (-1 = not scheduled)
     unsigned long  timestamp;                           // Timestamp of last data sample
     unsigned long  now;
     ProcessStatus  pStatus;
 
+    // Device task (see RunOnTask())
+    int                 taskCore      = -1;    // Core the task is pinned to (-1 = run on the Node's task)
+    UBaseType_t         taskPriority  = DEFAULT_DEVICE_TASK_PRIORITY;
+    uint32_t            taskStackSize = DEFAULT_DEVICE_TASK_STACK;
+    TaskHandle_t        task          = NULL;
+    SemaphoreHandle_t   taskLock      = NULL;  // Held by the task while it runs a process and by the Node while it runs a command
+    esp_timer_handle_t  taskTimer     = NULL;  // One-shot timer that wakes the task at its next deadline
+    unsigned long       taskResults   = 0L;    // Reports queued for the Node
+    unsigned long       taskDrops     = 0L;    // Reports dropped because the report queue was full
+
+    Profile        profiles[NUM_PROFILE_KINDS];  // Call timing, indexed by ProfileKind
+
+    // Report on change (see SDBD)
+    unsigned long  heartbeatMs       = 0L;   // Longest silence between periodic reports (0 = report every period)
+    float          deadbands[MAX_DATA_FIELDS] = {};  // Change a field needs to be reported (< 0 = ignore the field)
+    DField         lastFields[MAX_DATA_FIELDS];      // The last periodic report sent (text fields as a hash)
+    int            lastNumFields     = -1;   // -1 = send the next report whatever it holds
+    int64_t        lastReportUs      = 0;
+    unsigned long  reportsSuppressed = 0L;
+
+    bool           ReportChanged (const DPacket &packet);  // Is this periodic report worth sending?
+
+    static void    TaskMain    (void *arg);       // Body of a Device task
+    void           RunTaskPass ();                // Run due processes on the Device task, then sleep
+    void           QueueResult (ProcessStatus status, DPacket &packet);
+
+    void           EnablePeriodic (bool enable);  // Start/stop Periodic Processing (use this, not <periodicEnabled>, once added)
+    int64_t        ScheduledTimeUs ();            // The deadline DoPeriodic() was called for (esp_timer uSecs)
+    void           RestartPeriodic ();            // Start a new rate from now
+
+    bool           TxBackpressure ();                // true while this Device's reports would be dropped
+    bool           SubmitReport   (DPacket &packet);  // Send a report from any task (see NOTES above)
+
+    // Built-in Device command handlers
+    ProcessStatus  CmdDisableImmediate (CPacket &command, DPacket &reply);  // DIIP
+    ProcessStatus  CmdDisablePeriodic  (CPacket &command, DPacket &reply);  // DIPP
+    ProcessStatus  CmdDoImmediate      (CPacket &command, DPacket &reply);  // DOIP
+    ProcessStatus  CmdDoPeriodic       (CPacket &command, DPacket &reply);  // DOPP
+    ProcessStatus  CmdEnableImmediate  (CPacket &command, DPacket &reply);  // ENIP
+    ProcessStatus  CmdEnablePeriodic   (CPacket &command, DPacket &reply);  // ENPP
+    ProcessStatus  CmdGetName          (CPacket &command, DPacket &reply);  // GDNA
+    ProcessStatus  CmdGetVersion       (CPacket &command, DPacket &reply);  // GDVR
+    ProcessStatus  CmdGetRate          (CPacket &command, DPacket &reply);  // GRAT
+    ProcessStatus  CmdGetRateHz        (CPacket &command, DPacket &reply);  // GRHZ
+    ProcessStatus  CmdSetDeadband      (CPacket &command, DPacket &reply);  // SDBD
+    ProcessStatus  CmdSetName          (CPacket &command, DPacket &reply);  // SDNA
+    ProcessStatus  CmdSetSchedulePolicy (CPacket &command, DPacket &reply);  // SPOL
+    ProcessStatus  CmdSetRate          (CPacket &command, DPacket &reply);  // SRAT
+    ProcessStatus  CmdSetRateHz        (CPacket &command, DPacket &reply);  // SRHZ
+    ProcessStatus  CmdSetTrafficClass  (CPacket &command, DPacket &reply);  // STCL
+
+    // Built-in Device commands, in alphabetical order (see CommandTable.h)
+    static constexpr CommandEntry<CommandHandler<Device>> commandTable[] =
+    {
+      { CommandKey ("DIIP"), &Device::CmdDisableImmediate },
+      { CommandKey ("DIPP"), &Device::CmdDisablePeriodic  },
+      { CommandKey ("DOIP"), &Device::CmdDoImmediate      },
+      { CommandKey ("DOPP"), &Device::CmdDoPeriodic       },
+      { CommandKey ("ENIP"), &Device::CmdEnableImmediate  },
+      { CommandKey ("ENPP"), &Device::CmdEnablePeriodic   },
+      { CommandKey ("GDNA"), &Device::CmdGetName          },
+      { CommandKey ("GDVR"), &Device::CmdGetVersion       },
+      { CommandKey ("GRAT"), &Device::CmdGetRate          },
+      { CommandKey ("GRHZ"), &Device::CmdGetRateHz        },
+      { CommandKey ("SDBD"), &Device::CmdSetDeadband      },
+      { CommandKey ("SDNA"), &Device::CmdSetName          },
+      { CommandKey ("SPOL"), &Device::CmdSetSchedulePolicy },
+      { CommandKey ("SRAT"), &Device::CmdSetRate          },
+      { CommandKey ("SRHZ"), &Device::CmdSetRateHz        },
+      { CommandKey ("STCL"), &Device::CmdSetTrafficClass  },
+    };
+    static_assert (CommandTableSorted (commandTable), "Device commands must be in alphabetical order");
+
   public:
     Device (const char *inName);
 
@@ -129,13 +328,36 @@ class Device
     bool           IsPPEnabled ();                // Is Periodic Processing enabled?
     unsigned long  GetRate     ();                // Return the periodic data rate of this Device
     void           SetRate     (double newRate);  // Set the periodic process rate (# per hour)
+    double         GetRateHz   ();                // Return the periodic data rate in calls per second
+    void           SetRateHz   (double newRate);  // Set the periodic process rate in Hz (up to MAX_PERIODIC_RATE_HZ)
+    void           SetSchedulePolicy (SchedulePolicy policy);
+    TrafficClass   GetTrafficClass ();
+    void           SetTrafficClass (TrafficClass newClass);  // TRAFFIC_STATUS or TRAFFIC_TELEMETRY (default)
     const char *   GetVersion  ();                // Return the current version of this Device
 
-    ProcessStatus  RunPeriodic ();  // No need to use this method. It is called by the Node.
+    void           SetScheduler (Scheduler *inScheduler);  // No need to use this method. It is called by the Node.
+
+    void           RunOnTask  (int core, UBaseType_t priority = DEFAULT_DEVICE_TASK_PRIORITY,
+                               uint32_t stackSize = DEFAULT_DEVICE_TASK_STACK);  // Call before AddDevice()
+    bool           IsOnTask   ();                              // Does this Device run on its own task?
+    bool           StartTask  ();                              // Called by the Node
+    void           LockTask   ();                              // Called by the Node around commands
+    void           UnlockTask ();
+    int            GetTaskStats (char *text);                  // DTASK=... for GTSK, returns length
+
+    ProcessStatus  RunImmediate (DPacket &packet);                  // DoImmediate(), timed
+    ProcessStatus  RunPeriodic  (DPacket &packet);                  // DoPeriodic(), timed
+    ProcessStatus  RunCommand   (CPacket &command, DPacket &reply);  // ExecuteCommand() under the task lock, timed
+    bool           RunSample    (int field, DPacket &packet);       // SampleField() under the task lock
+    int            GetProfile   (ProfileKind kind, char *text);     // DPROF=... for GPRF, returns length (0 if never called)
+    void           ResetProfiles ();
+
+    virtual ProcessStatus  DoImmediate    (DPacket &packet);                  // Override this method for processing your device continuously
+    virtual ProcessStatus  DoPeriodic     (DPacket &packet);                  // Override this method for processing your device periodically
+    virtual ProcessStatus  ExecuteCommand (CPacket &command, DPacket &reply);  // Override this method to handle custom commands
+    virtual bool           SampleField    (int field, DPacket &packet);       // Override this method to allow field subscriptions
 
-    virtual ProcessStatus  DoImmediate    ();  // Override this method for processing your device continuously
-    virtual ProcessStatus  DoPeriodic     ();  // Override this method for processing your device periodically
-    virtual ProcessStatus  ExecuteCommand ();  // Override this method to handle custom commands
+    friend class Scheduler;
 };
 
 #endif
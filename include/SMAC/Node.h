@@ -33,25 +33,175 @@
 //              ∙ ExecuteCommand() is only called when it receives a command targeted for this Node
 //                or a Device connected to this Node.
 //
-//                The global <CommandPacket> holds incoming command data and has the following three fields:
+//                The <command> CPacket holds incoming command data and has the following fields:
 //
-//                  int  deviceIndex  : deviceID as an integer (0-99)
-//                  char command[..]  : 4-char command (usually capital letters)
-//                  char params[..]   : variable length parameter string
+//                  int        deviceIndex  : deviceID as an integer (0-99)
+//                  char       command[..]  : 4-char command (usually capital letters)
+//                  const char *params      : variable length parameter string (read only)
+//                  ParamSpan  tokens[..]   : <params> split on '|' as pointer+length spans, <numTokens> of them
+//
+//                <params> and <tokens> are read in place from the command's CommandBuffer slot,
+//                so they are only valid until ExecuteCommand() returns.
+//
+//                Any response goes in the <reply> DPacket.
 //
 //              ∙ This Node base class handles the following built-in (reserved) Node commands:
 //
 //                SNNA = Set Node Name
-//                GNOI = Get Node Info   : <DataPacket> value = name|version|macAddress|numDevices
-//                GDEI = Get Device Info : <DataPacket> value = name|version|ipEnabled|ppEnabled|rate
+//                GNOI = Get Node Info   : <reply> value = name|version|macAddress|numDevices
+//                GDEI = Get Device Info : <reply> value = name|version|ipEnabled|ppEnabled|rate
 //                PING = Check if still alive and connected; responds with "PONG"
 //                BLIN = Quickly blink the Node's status LED to indicate communication or location
 //                GNVR = Get Node Firmware Version
 //                RSET = Reset this Node's processor using esp_restart()
 //
+//            █ Received commands wait in <CommandBuffer>, a fixed ring of slots (see RingBuffer.h), until
+//              Run() drains them.  A command that finds it full, or is too long for a slot, is dropped
+//              and counted.
+//
+//                GCBS = Get Command Buffer Stats : <reply> value = CBSTAT=depth|pushed|popped|overflowDrops|oversizeDrops
+//
+//            █ Each call to Run() first drains queued commands, up to <maxCommandsPerRun> commands
+//              or <commandBudgetUs> microseconds (whichever comes first), then runs the Devices.
+//
+//                GCDS = Get Command Drain Stats  : <reply> value = CDSTAT=max|budget|passes|maxPerPass|runHighWater|rxHighWater|limitStops|budgetStops
+//                                                  GCDS|R also resets the statistics
+//                SCDP = Set Command Drain Policy : params = maxCommandsPerPass|budgetMicroseconds (0 = no limit)
+//
+//            █ In ASCII format each DPacket is sent as "nn|dd|timestamp|value" for SMAC_Interface.js.
+//              In binary format it is sent as a Data Frame (see DATA_FRAME_MARKER in common.h): a fixed
+//              8-byte header with the node/device IDs and a 32-bit timestamp, then the typed fields
+//              in little-endian order.  A Relayer that understands Data Frames selects them with SDPF|B.
+//
+//                SDPF = Set Data Packet Format   : params = A (ASCII Data Strings, default) or B (binary Data Frames)
+//                                                  <reply> value = DPFMT=A or DPFMT=B
+//
+//            █ With batching on, records are packed into one ESP-NOW frame (up to MAX_MESSAGE_LENGTH)
+//              which is sent when the next record does not fit, or at the end of the Run() pass in
+//              which its oldest record has waited the deadline.  See DATA_BATCH_MARKER in common.h.
+//
+//                GBST = Get Batch Stats          : <reply> value = BSTAT=frames|records|sizeFlushes|deadlineFlushes|
+//                                                  then the number of frames that carried 1, 2, ... 8+ records
+//                                                  GBST|R also resets the statistics
+//                SBAT = Set Batching             : params = deadline in microseconds (0 = off, default)
+//                                                  <reply> value = BATCH=deadline
+//
+//            █ Periodic Processing is run by a deadline-ordered Scheduler (see Scheduler.h), so only
+//              the Devices that are due are visited.  When no Device has Immediate Processing enabled,
+//              Run() sleeps until the next deadline, a command arrives or a Device task queues a report
+//              (the ESP-NOW receive callback and Device tasks send the Run() task a notification),
+//              instead of spinning.
+//
+//                GSCH = Get Scheduler Stats      : <reply> value = SCHED=scheduled|runs|avgLateUs|maxLateUs|overruns|
+//                                                  idleWaits|commandWakes|idleMs
+//                                                  GSCH|R also resets the statistics
+//                SIDL = Set Idle Wait            : params = longest Run() may sleep in mSecs (0 = never sleep)
+//                                                  <reply> value = IDLE=mSecs
+//
+//            █ Devices that asked for their own task (see Device::RunOnTask()) are started by the first
+//              Run() and are left out of the Node's Immediate and Periodic Processing.  Their reports
+//              arrive through SubmitReport() and are sent by Run() right after the queued commands.
+//
+//                GTSK = Get Task Stats           : For each Device on its own task, <reply> value =
+//                                                  DTASK=core|priority|freeStackBytes|queued|dropped|runs|maxLateUs
+//
+//            █ Frames are not sent by the task that made them.  TransmitFrame() copies each frame into
+//              a queue that a sender task (on the WiFi core) drains, so a busy radio never stalls Run().
+//              The sender keeps at most TX_MAX_IN_FLIGHT frames inside ESP-NOW, waiting for the send
+//              callback to report each one delivered or failed.  A frame that finds the queue full is
+//              dropped and counted.  While the queue is nearly full, Device reports are skipped before
+//              they are built (see Node::TxBackpressure() and Device::RunPeriodic()).
+//
+//                GTXS = Get Transmit Stats       : <reply> value = TXSTAT=queued|delivered|failed|sendErrors|queueFull|
+//                                                  callbackTimeouts|inFlightHighWater|queueHighWater|backpressureSkips
+//                                                  GTXS|R also resets the statistics
+//
+//            █ Built-in commands are dispatched through <commandTable> by their packed
+//              <command.key> (see CommandTable.h) instead of string compares.
+//
+//            █ There are no global packets.  Each command, process run and Device task report works
+//              in its own CPacket/DPacket on the stack of the task that runs it, so the Node task, the
+//              Device tasks and the sender task never share a packet.  SendDataPacket() encodes into
+//              the Node's own <dataString> and may only be called from the Run() task; any other task
+//              hands its packet to SubmitReport(), which copies it into <ReportQueue> (Node.cpp) and
+//              wakes Run() to send it.
+//
+//            █ Run() profiles itself and every Device (see Profile.h): each DoImmediate(), DoPeriodic()
+//              and ExecuteCommand() call, the period from one Run() pass to the next, and the busy part
+//              of each pass (everything but the sleep).
+//
+//                GPRF = Get Profiles             : For each Device and kind of call it has made, <reply> value =
+//                                                  DPROF=kind|count|minUs|avgUs|maxUs|h0|...|h15  (kind = I, P or C)
+//                                                  then for the Node, NPROF=L|... (Run() period) and NPROF=B|... (busy)
+//                                                  h<n> counts calls of 2^n to 2^(n+1)-1 uSecs (h0 < 2 uSecs)
+//                                                  GPRF|R also resets the profiles
+//                SPRF = Set Profile Reporting    : params = seconds between unrequested GPRF reports (0 = off, default)
+//                                                  <reply> value = PROFRPT=seconds
+//                                                  The NPROF reports of a GPRF carry the deviceID it was sent to;
+//                                                  unrequested ones carry NODE_DEVICE_ID (99), which no Device has.
+//
+//            █ A command may start with a correlation ID, "#id|dd|CCCC|params" (id = 0 to 4294967295).
+//              Its response then ends with "|#id" (an extra text field for typed responses), and the
+//              Node keeps a CommandTrace of when the command was received (CommandReceived()),
+//              dequeued, dispatched to its handler, finished, and handed to ESP-NOW by the sender task.
+//              The last TRACE_LENGTH traces are kept, and each stage is profiled (see Profile.h).
+//
+//                GTRC = Get Command Traces       : For each kept trace, oldest first, <reply> value =
+//                                                  TRACE=id|queueUs|parseUs|handlerUs|transmitUs|totalUs
+//                                                  ('-' until the response has been sent), then for each stage
+//                                                  TRSTG=stage|count|minUs|avgUs|maxUs|h0|...|h15
+//                                                  (stage = Q, P, H, T or E as in TraceStage)
+//                                                  GTRC|R also clears the traces and stage profiles
+//
+//            █ Instead of a Device's whole periodic report, the Interface can subscribe to single typed fields
+//              at their own rates, for example the speed of one wheel at 100 Hz and one INA3221 current at 10 Hz.
+//              Run() samples the due fields with Device::SampleField() (see Device.h), without running the
+//              Device's processes, and sends the samples of each Device as one record of typed fields:
+//
+//                SUBV|fieldMask|value|value|...   (bit n of fieldMask set = field n is in the record)
+//
+//              The values are in field order, and the timestamp is when they were sampled.  A Device with more than
+//              MAX_DATA_FIELDS-2 fields due gets more records.  Turn the Device's own reports off (DIPP) to
+//              send only what is subscribed.
+//
+//                GSUB = Get Subscriptions        : For each subscription, <reply> value = SUB=dd|field|rateHz
+//                                                  then SUBS=subscriptions|records|samples
+//                                                  GSUB|R also resets the statistics
+//                SSUB = Subscribe                : params = dd|field|rateHz  (up to MAX_PERIODIC_RATE_HZ, 0 = unsubscribe)
+//                                                  SSUB|dd unsubscribes all fields of Device dd, SSUB alone all of them
+//                                                  <reply> value = SUBS=subscriptions|records|samples
+//                                                  An ERR reply leaves the subscriptions as they were
+//
+//            █ Outbound traffic can be held to an airtime budget (see TokenBucket.h), so telemetry from many
+//              fast Devices cannot starve command responses.  Every record has a TrafficClass: anything sent
+//              while a command runs is a response, the Node's own reports are status, and Device reports are
+//              what the Device's class says (telemetry unless set with STCL, subscriptions are telemetry).
+//              Each frame is charged its length plus AIRTIME_FRAME_OVERHEAD bytes, and each record one record.
+//              Responses always go out, status while the buckets are not empty, and telemetry only while they
+//              hold more than TELEMETRY_RESERVE_PERCENT.  A record that is not admitted is dropped before it is
+//              formatted, and a Device report is skipped before it is even built (TxBackpressure()).
+//
+//                GLIM = Get Rate Limit Stats     : <reply> value = LSTAT=byteTokens|recordTokens|sentR|sentS|sentT|
+//                                                  droppedR|droppedS|droppedT|skipped  (skipped = by TxBackpressure())
+//                                                  GLIM|R also resets the statistics
+//                SLIM = Set Rate Limits          : params = bytesPerSecond|recordsPerSecond (0 = no limit, default)
+//                                                  <reply> value = RLIM=bytesPerSecond|recordsPerSecond
+//
+//            █ On the bench, a host program tethered by USB can carry the same commands and data frames over
+//              the Serial port instead of ESP-NOW (see SerialLink.h), at USB speed and with no radio loss.
+//              Outbound frames only move to it with SXPT|S (sent over either transport), and back with
+//              SXPT|E; receiving a command never changes where frames go.  Nothing else changes: batching,
+//              data formats and rate limits apply to either transport.  A serial frame needs no send
+//              callback, so it counts as delivered once it is written.
+//              At startup the Node PINGs over ESP-NOW; a host on the serial link sends a PONG frame, then 00|SXPT|S.
+//
+//                SXPT = Set Transport            : params = E (ESP-NOW, default) or S (serial link), none = unchanged
+//                                                  <reply> value = XPORT=E|S|framesIn|framesOut|badFrames|writeErrors
+//                                                  (sent on the new transport), SXPT|R resets the serial link counts
+//
 //            █ A child Node class can override ExecuteCommand() to handle custom commands.
 //              It should first call this base class's ExecuteCommand() to handle the built-in Node commands:
-//                Node::ExecuteCommand()
+//                Node::ExecuteCommand (command, reply)
 //
 //  WARNING : Some Espressif ESP32 boards do not allow the use of Analog Channel 2 (ADC2) with Wifi.
 //            Since Nodes use WiFi, do not use ADC2 pins as analog inputs.
@@ -71,7 +221,84 @@
 
 //--- Includes ---------------------------------------------
 
+#include <esp_timer.h>
+#include <atomic>
 #include "Device.h"
+#include "SerialLink.h"
+
+//--- Defines ----------------------------------------------
+
+#define DEFAULT_MAX_COMMANDS_PER_RUN     8  // Commands drained per Run() pass (0 = no limit)
+#define DEFAULT_COMMAND_BUDGET_US     2000  // Microseconds of command processing per Run() pass (0 = no limit)
+#define DEFAULT_BATCH_DEADLINE_US        0  // Longest a record may wait in a batch (0 = batching off)
+#define BATCH_HISTOGRAM_SIZE             8  // Records-per-frame buckets: 1, 2, ... 8 or more
+#define DEFAULT_MAX_IDLE_WAIT_MS        20  // Longest Run() sleeps waiting for work (0 = never sleep)
+#define MIN_IDLE_WAIT_US               100  // Shorter waits spin instead of sleeping
+#define REPORT_QUEUE_LENGTH             16  // Reports from other tasks waiting to be sent by Run()
+#define TX_QUEUE_LENGTH                 16  // Frames waiting for the sender task
+#define TX_MAX_IN_FLIGHT                 4  // Frames handed to ESP-NOW that have no send callback yet
+#define TX_CALLBACK_TIMEOUT_MS          50  // Waits for a send callback longer than this are counted (callbackTimeouts)
+#define TX_BACKPRESSURE_LEVEL           12  // Queued frames at which Devices are asked to hold off reports
+#define TX_TASK_CORE                     0  // The sender task runs with WiFi
+#define TX_TASK_PRIORITY                 3
+#define TX_TASK_STACK                 3072  // Bytes
+#define TRACE_LENGTH                    16  // Command traces kept for GTRC (at most 16, see TxFrame)
+#define MAX_SUBSCRIPTIONS               16  // Field subscriptions (SSUB)
+#define SUBSCRIPTION_TAG            "SUBV"  // First field of a subscription record
+#define DEFAULT_LIMIT_BYTES_PER_SEC      0  // Airtime bytes per second (0 = no limit, see SLIM)
+#define DEFAULT_LIMIT_RECORDS_PER_SEC    0  // Records per second (0 = no limit)
+#define AIRTIME_FRAME_OVERHEAD          64  // Airtime bytes an ESP-NOW frame costs besides its data (preamble, headers)
+
+//--- Types ------------------------------------------------
+
+// Where the Node's frames go (SXPT)
+enum Transport
+{
+  TRANSPORT_ESPNOW,  // E : esp_now_send() to the Relayer
+  TRANSPORT_SERIAL   // S : SerialLink, the USB tether
+};
+
+typedef struct TxFrame
+{
+  uint8_t   length;
+  uint8_t   transport;  // Transport selected when the frame was queued
+  uint16_t  traces;     // Bit n set = carries the response of the command in <traces[n]>
+  uint32_t  traceSerial;  // Node's <traceSerial> when the records were made (see SendFrame())
+  uint8_t   data[MAX_MESSAGE_LENGTH];
+} TxFrame;
+
+// Where a traced command spent its time (GTRC)
+enum TraceStage
+{
+  TRACE_QUEUE,     // Q : received -> dequeued  (waiting in <CommandBuffer>)
+  TRACE_PARSE,     // P : dequeued -> dispatched
+  TRACE_HANDLER,   // H : dispatched -> handler done  (including a Device task's lock)
+  TRACE_TRANSMIT,  // T : handler done -> handed to ESP-NOW  (encoding, batching, transmit queue)
+  TRACE_TOTAL,     // E : received -> handed to ESP-NOW
+  NUM_TRACE_STAGES
+};
+
+// Times are uSecs after <receivedUs>
+typedef struct CommandTrace
+{
+  uint32_t               id;
+  int64_t                receivedUs;  // Stamped by CommandReceived()
+  uint32_t               dequeuedUs;
+  uint32_t               dispatchedUs;
+  uint32_t               doneUs;
+  std::atomic<uint32_t>  serial;      // Node's <traceSerial> for this command, new each time the slot is taken
+  std::atomic<uint32_t>  sentUs;      // Set by the sender task, 0 until the response is sent
+  bool                   profiled;    // Transmit and total stages added to <traceProfiles>
+} CommandTrace;
+
+// One field of one Device, sampled at its own rate (SSUB)
+typedef struct Subscription
+{
+  int      deviceIndex;
+  int      field;     // Position of the typed field in the Device's periodic report
+  int64_t  periodUs;
+  int64_t  nextUs;    // esp_timer time of the next sample
+} Subscription;
 
 
 //==========================================================
@@ -83,25 +310,189 @@ class Node
   private:
     int  deviceIndex = 0;
 
+    void RunCommands          ();  // Drain the <CommandBuffer> within the drain policy
+    void ExecuteCommandString ();  // Parse and execute <commandString>, send any response
+    static void SplitParams   (CPacket &command);  // Record the '|' token spans of <command.params>
+    int  EncodeAscii          (const DPacket &packet);  // Build <packet>'s Data String in <dataString>, returns length
+    int  EncodeBinary         (const DPacket &packet);  // Build <packet>'s binary Data Frame in <dataString>, returns length
+    void AddToBatch           (int length, uint16_t traces, uint32_t traceSerial);  // Append the record in <dataString> to <batchFrame>
+    void FlushBatch           ();            // Send <batchFrame> if it holds any records
+    void CheckBatchDeadline   ();            // Flush <batchFrame> if its oldest record is due
+    void TransmitFrame        (const uint8_t *frame, int length, int records, uint16_t traces, uint32_t traceSerial);  // Queue a frame for the sender task
+    void SendFrame            (const uint8_t *frame, int length, uint16_t traces, uint32_t traceSerial, Transport transport);  // Hand a frame to <transport>
+    void StartSender          ();            // Create <TxQueue> and the sender task
+    static void SenderMain    (void *arg);   // Body of the sender task
+    void WaitForWork          ();            // Sleep until the next deadline or command
+    void StartDeviceTasks     ();            // Start the tasks of Devices that asked for one
+    void SendTaskResults      ();            // Send the reports queued through SubmitReport()
+    void SendProfiles         (int index);   // Send the GPRF reports, the Node's as Device <index>
+    void CheckProfileReport   ();            // Send the GPRF reports when SPRF says they are due
+    void SendSubscriptions    ();            // Sample the subscribed fields that are due and send them
+    void SendSamples          (DPacket &packet, int index, uint32_t fieldMask);  // Send a SUBV record for Device <index>
+    void SendRecord           (DPacket &packet, TrafficClass trafficClass);      // SendDataPacket() for a known class
+    TrafficClass ClassOf      (const DPacket &packet);  // The TrafficClass <packet> is sent as
+    int  StartTrace           (uint32_t id, int64_t dequeuedAt);  // Open the next CommandTrace, returns its slot
+    void ProfileSentTraces    ();            // Add the sent traces' transmit and total times to <traceProfiles>
+
   protected:
     char           nodeID[ID_SIZE+1];                 // This unique ID (00-19) is assigned at construction
+    int            nodeNumber = 0;                    // nodeID as an integer, for binary Data Frames
+    DataFormat     dataFormat = ASCII_FORMAT;         // Selected by the SDPF command
     char           name[MAX_NAME_LENGTH+1] = "Node";  // A display name to show in the SMAC Interface
     char           version[MAX_VERSION_LENGTH] = "";  // A version number for this Node's firmware (yyyy.mm.dd<a-z>)
     char           macAddressString[18] = "Not set";  // MAC address as a Hex string (xx:xx:xx:xx:xx:xx)
     Device         *devices[MAX_DEVICES];             // Holds the array of Devices for this Node
     int            numDevices = 0;                    // Number of added Devices
-    char           *commandString;                    // Command string from buffer
-    ProcessStatus  pStatus;
+    const char     *commandString;                    // Command string, read in place from <CommandBuffer>
+    char           dataString[MAX_MESSAGE_LENGTH];    // The encoded record being sent (Run() task only)
+
+    // Command drain policy and statistics
+    int            maxCommandsPerRun   = DEFAULT_MAX_COMMANDS_PER_RUN;
+    unsigned long  commandBudgetUs     = DEFAULT_COMMAND_BUDGET_US;
+    unsigned long  drainPasses         = 0L;  // Run() passes that found commands waiting
+    int            drainMaxPerPass     = 0;   // Most commands executed in one pass
+    int            drainDepthHighWater = 0;   // Deepest <CommandBuffer> seen at the start of a pass
+    unsigned long  drainLimitStops     = 0L;  // Passes that stopped on <maxCommandsPerRun> with commands left
+    unsigned long  drainBudgetStops    = 0L;  // Passes that stopped on <commandBudgetUs> with commands left
+
+    // Data batching and statistics
+    unsigned long  batchDeadlineUs     = DEFAULT_BATCH_DEADLINE_US;
+    uint8_t        batchFrame[MAX_MESSAGE_LENGTH];
+    DataFormat     batchFormat         = ASCII_FORMAT;
+    int            batchLength         = 0;
+    int            batchRecords        = 0;
+    uint16_t       batchTraces         = 0;   // Traces of the batched records
+    uint32_t       batchTraceSerial    = 0;   // <traceSerial> when the last traced record was batched
+    int64_t        batchStartUs        = 0;
+    unsigned long  framesSent          = 0L;
+    unsigned long  recordsSent         = 0L;
+    unsigned long  sizeFlushes         = 0L;  // Batches sent because the next record did not fit
+    unsigned long  deadlineFlushes     = 0L;  // Batches sent because <batchDeadlineUs> expired
+    unsigned long  recordsPerFrame[BATCH_HISTOGRAM_SIZE] = {};
+
+    // Periodic scheduling and idle statistics
+    Scheduler           scheduler;
+    esp_timer_handle_t  wakeTimer      = NULL;  // One-shot timer that ends a sleep at the next deadline
+    unsigned long  maxIdleWaitMs       = DEFAULT_MAX_IDLE_WAIT_MS;
+    unsigned long  idleWaits           = 0L;  // Times Run() went to sleep
+    unsigned long  notifyWakes         = 0L;  // Sleeps ended early by an incoming command
+    int64_t        idleUs              = 0;   // Total time asleep
+
+    // Run() profiling (the Devices keep their own)
+    Profile        loopProfile;                // Start of one Run() pass to the next
+    Profile        busyProfile;                // Each pass up to the sleep
+    int64_t        lastRunStartUs      = 0;
+    unsigned long  profileReportSecs   = 0L;  // 0 = only report on GPRF
+    int64_t        nextProfileReportUs = 0;
+
+    // Command tracing (GTRC)
+    CommandTrace   traces[TRACE_LENGTH];
+    int            nextTrace           = 0;   // Slot the next traced command takes
+    int            numTraces           = 0;
+    int            currentTrace        = -1;  // Slot of the command being executed, -1 if not traced
+    uint32_t       traceSerial         = 0;   // Counts the traces started, tells a reused slot apart
+    Profile        traceProfiles[NUM_TRACE_STAGES];
+
+    // Field subscriptions (SSUB), sorted by Device then field
+    Subscription   subscriptions[MAX_SUBSCRIPTIONS];
+    int            numSubscriptions    = 0;
+    int64_t        nextSubscriptionUs  = INT64_MAX;  // Earliest <nextUs> of the subscriptions
+    unsigned long  subscriptionRecords = 0L;  // SUBV records sent
+    unsigned long  subscriptionSamples = 0L;  // Field values sent in them
+
+    // Outbound rate limits (SLIM, the buckets are in Node.cpp)
+    bool           executingCommand    = false;  // Everything sent now is a command response
+    unsigned long  limitBytesPerSec    = DEFAULT_LIMIT_BYTES_PER_SEC;
+    unsigned long  limitRecordsPerSec  = DEFAULT_LIMIT_RECORDS_PER_SEC;
+    unsigned long  limitSent[NUM_TRAFFIC_CLASSES]  = {};  // Records admitted, by TrafficClass
+    unsigned long  limitDrops[NUM_TRAFFIC_CLASSES] = {};  // Records dropped by the rate limits
+
+    // The USB tether, if main.cpp gave one (the selected Transport is in Node.cpp)
+    SerialLink     *serialLink         = NULL;
+
+    // Transmit pipeline statistics (the send callback's counters are in Node.cpp)
+    TaskHandle_t   txTask              = NULL;
+    unsigned long  txQueued            = 0L;  // Frames accepted by TransmitFrame()
+    unsigned long  txQueueFull         = 0L;  // Frames dropped because the transmit queue was full
+    unsigned long  txSendErrors        = 0L;  // esp_now_send() calls that returned an error
+    unsigned long  txTimeouts          = 0L;  // TX_CALLBACK_TIMEOUT_MS waits for a free slot
+    int            txQueueHighWater    = 0;
+    int            txInFlightHighWater = 0;
+
+    // Built-in Node command handlers
+    ProcessStatus  CmdBlink          (CPacket &command, DPacket &reply);  // BLIN
+    ProcessStatus  CmdGetBatchStats  (CPacket &command, DPacket &reply);  // GBST
+    ProcessStatus  CmdGetBufferStats (CPacket &command, DPacket &reply);  // GCBS
+    ProcessStatus  CmdGetDrainStats  (CPacket &command, DPacket &reply);  // GCDS
+    ProcessStatus  CmdGetDeviceInfo  (CPacket &command, DPacket &reply);  // GDEI
+    ProcessStatus  CmdGetLimitStats  (CPacket &command, DPacket &reply);  // GLIM
+    ProcessStatus  CmdGetNodeInfo    (CPacket &command, DPacket &reply);  // GNOI
+    ProcessStatus  CmdGetVersion     (CPacket &command, DPacket &reply);  // GNVR
+    ProcessStatus  CmdGetProfiles    (CPacket &command, DPacket &reply);  // GPRF
+    ProcessStatus  CmdGetSchedulerStats (CPacket &command, DPacket &reply);  // GSCH
+    ProcessStatus  CmdGetSubscriptions  (CPacket &command, DPacket &reply);  // GSUB
+    ProcessStatus  CmdGetTraces      (CPacket &command, DPacket &reply);  // GTRC
+    ProcessStatus  CmdGetTaskStats   (CPacket &command, DPacket &reply);  // GTSK
+    ProcessStatus  CmdGetTxStats     (CPacket &command, DPacket &reply);  // GTXS
+    ProcessStatus  CmdPing           (CPacket &command, DPacket &reply);  // PING
+    ProcessStatus  CmdReset          (CPacket &command, DPacket &reply);  // RSET
+    ProcessStatus  CmdSetBatching    (CPacket &command, DPacket &reply);  // SBAT
+    ProcessStatus  CmdSetDrainPolicy (CPacket &command, DPacket &reply);  // SCDP
+    ProcessStatus  CmdSetDataFormat  (CPacket &command, DPacket &reply);  // SDPF
+    ProcessStatus  CmdSetIdleWait    (CPacket &command, DPacket &reply);  // SIDL
+    ProcessStatus  CmdSetRateLimits  (CPacket &command, DPacket &reply);  // SLIM
+    ProcessStatus  CmdSetNodeName    (CPacket &command, DPacket &reply);  // SNNA
+    ProcessStatus  CmdSetProfileReport (CPacket &command, DPacket &reply);  // SPRF
+    ProcessStatus  CmdSubscribe      (CPacket &command, DPacket &reply);  // SSUB
+    ProcessStatus  CmdSetTransport   (CPacket &command, DPacket &reply);  // SXPT
+
+    // Built-in Node commands, in alphabetical order (see CommandTable.h)
+    static constexpr CommandEntry<CommandHandler<Node>> commandTable[] =
+    {
+      { CommandKey ("BLIN"), &Node::CmdBlink          },
+      { CommandKey ("GBST"), &Node::CmdGetBatchStats  },
+      { CommandKey ("GCBS"), &Node::CmdGetBufferStats },
+      { CommandKey ("GCDS"), &Node::CmdGetDrainStats  },
+      { CommandKey ("GDEI"), &Node::CmdGetDeviceInfo  },
+      { CommandKey ("GLIM"), &Node::CmdGetLimitStats  },
+      { CommandKey ("GNOI"), &Node::CmdGetNodeInfo    },
+      { CommandKey ("GNVR"), &Node::CmdGetVersion     },
+      { CommandKey ("GPRF"), &Node::CmdGetProfiles    },
+      { CommandKey ("GSCH"), &Node::CmdGetSchedulerStats },
+      { CommandKey ("GSUB"), &Node::CmdGetSubscriptions  },
+      { CommandKey ("GTRC"), &Node::CmdGetTraces      },
+      { CommandKey ("GTSK"), &Node::CmdGetTaskStats   },
+      { CommandKey ("GTXS"), &Node::CmdGetTxStats     },
+      { CommandKey ("PING"), &Node::CmdPing           },
+      { CommandKey ("RSET"), &Node::CmdReset          },
+      { CommandKey ("SBAT"), &Node::CmdSetBatching    },
+      { CommandKey ("SCDP"), &Node::CmdSetDrainPolicy },
+      { CommandKey ("SDPF"), &Node::CmdSetDataFormat  },
+      { CommandKey ("SIDL"), &Node::CmdSetIdleWait    },
+      { CommandKey ("SLIM"), &Node::CmdSetRateLimits  },
+      { CommandKey ("SNNA"), &Node::CmdSetNodeName    },
+      { CommandKey ("SPRF"), &Node::CmdSetProfileReport },
+      { CommandKey ("SSUB"), &Node::CmdSubscribe      },
+      { CommandKey ("SXPT"), &Node::CmdSetTransport   },
+    };
+    static_assert (CommandTableSorted (commandTable), "Node commands must be in alphabetical order");
 
   public:
     Node (const char *inName, int inNodeID);
 
     void          AddDevice (Device *device);  // Call this method to add Devices
-    void          SendDataPacket ();           // Send the global <DataPacket> structure to the Relayer Module
+    void          SendDataPacket (DPacket &packet);  // Send <packet> to the Relayer Module (Run() task only)
     void          Run ();                      // Run this Node; called from the loop() method of main.cpp
     const char *  GetVersion ();               // Return the current version of this Node
 
-    virtual ProcessStatus  ExecuteCommand ();  // Override this method in a child Node class
+    void          UseSerialLink (SerialLink *link);  // Take commands from <link>, and let SXPT|S send frames on it
+
+    static void   CommandReceived (const uint8_t *commandString, int commandLength, Transport source);  // Queue a received command
+    static void   Wake ();                     // Wake Run() if it is sleeping (any task)
+    static bool   SubmitReport (const DPacket &packet);  // Queue <packet> for Run() to send (any task), false if full
+    static bool   TxBackpressure (TrafficClass trafficClass = TRAFFIC_TELEMETRY);  // Should an optional report be skipped?
+
+    virtual ProcessStatus  ExecuteCommand (CPacket &command, DPacket &reply);  // Override this method in a child Node class
 };
 
 #endif
@@ -0,0 +1,72 @@
+//=========================================================
+//
+//     FILE : Profile.h
+//
+//  PROJECT : SMAC Framework
+//              │
+//              └── Firmware
+//                    │
+//                    └── Node
+//
+//    NOTES : Hot-path timing statistics:
+//
+//            █ A Profile collects the durations (uSecs, from esp_timer_get_time()) of one
+//              kind of call: count, min, average, max and a log2 histogram.
+//
+//              Bucket 0 counts calls under 2 uSecs, bucket n counts 2^n to 2^(n+1)-1 uSecs,
+//              and the last bucket counts everything from 2^(PROFILE_HISTOGRAM_SIZE-1) up.
+//
+//            █ Each Device keeps one Profile per ProfileKind (see Device::RunImmediate(),
+//              RunPeriodic() and RunCommand()), and the Node keeps one for its Run() period
+//              and one for the busy part of each pass.  See the GPRF and SPRF Node commands.
+//
+//            █ A Profile is not locked.  Only the task that runs the calls may Record(); a Device
+//              on its own task records and reads its Profiles while holding its <taskLock>.
+//
+//   AUTHOR : Bill Daniels
+//            Copyright 2021-2025, D+S Tech Labs, Inc.
+//            All Rights Reserved
+//
+//=========================================================
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+//--- Includes --------------------------------------------
+
+#include <stdint.h>
+
+//--- Defines ---------------------------------------------
+
+#define PROFILE_HISTOGRAM_SIZE  16  // log2 uSec buckets: <2, 2-3, 4-7, ... 32768 and up
+
+//--- Types -----------------------------------------------
+
+enum ProfileKind
+{
+  PROFILE_IMMEDIATE,  // DoImmediate()
+  PROFILE_PERIODIC,   // DoPeriodic()
+  PROFILE_COMMAND,    // ExecuteCommand()
+  NUM_PROFILE_KINDS
+};
+
+
+//=========================================================
+//  class Profile
+//=========================================================
+
+class Profile
+{
+  public:
+    unsigned long  count   = 0L;
+    uint32_t       minUs   = UINT32_MAX;
+    uint32_t       maxUs   = 0;
+    uint64_t       totalUs = 0;
+    unsigned long  histogram[PROFILE_HISTOGRAM_SIZE] = {};
+
+    void  Record (int64_t us);     // Add one call that took <us> uSecs
+    void  Reset  ();
+    int   Format (char *text);     // count|minUs|avgUs|maxUs|h0|h1|...  returns length
+};
+
+#endif
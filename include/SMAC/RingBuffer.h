@@ -4,7 +4,27 @@
 //
 //  PROJECT : Any
 //
-//    NOTES : Implements a LIFO or Circular FIFO Stack.
+//    NOTES : Implements a lock-free, allocation-free
+//            Circular FIFO of strings for exactly one
+//            producer task and one consumer task.
+//
+//            █ Every slot is preallocated and ELEMENT_SIZE bytes long,
+//              so pushing never calls malloc() and popping never calls free().
+//
+//            █ The producer (e.g. the ESP-NOW receive callback) only writes
+//              tailIndex and the producer counters; the consumer (e.g. Node::Run)
+//              only writes headIndex and popCount.  Both indexes are atomic
+//              and free-running, so no lock or critical section is needed.
+//
+//            █ The consumer reads the oldest string in place with PeekString()
+//              and hands the slot back with ReleaseString().  The pointer from
+//              PeekString() is valid until ReleaseString() is called.
+//
+//            █ Each slot also carries a 64-bit stamp given to PushString() (the receive
+//              time, for the Node's command tracing), read back with PeekStamp().
+//
+//            █ A push into a full buffer is dropped and counted (overflowCount).
+//              A string too long for a slot is dropped and counted (oversizeCount).
 //
 //   AUTHOR : Bill Daniels
 //            Copyright 1992-2025, D+S Tech Labs, Inc.
@@ -15,17 +35,17 @@
 #ifndef RINGBUFFER_H
 #define RINGBUFFER_H
 
-//--- Defines ---------------------------------------------
+//--- Includes --------------------------------------------
 
-#define MAX_ELEMENTS  20
+#include <stdint.h>
+#include <atomic>
 
-//--- Types -----------------------------------------------
+//--- Defines ---------------------------------------------
 
-enum BufferType
-{
-  FIFO,
-  LIFO
-};
+#define MAX_ELEMENTS   32  // Number of slots (must be a power of 2)
+#define ELEMENT_SIZE  251  // Bytes per slot including NULL terminator (ESP-NOW max message + 1)
+
+static_assert ((MAX_ELEMENTS & (MAX_ELEMENTS - 1)) == 0, "MAX_ELEMENTS must be a power of 2");
 
 
 //=========================================================
@@ -35,19 +55,31 @@ enum BufferType
 class RingBuffer
 {
   protected:
-    BufferType  bufferType;
-    int         numElements;
-    int         headIndex;
-    int         tailIndex;
-    char        *elements[MAX_ELEMENTS];
+    char                   elements[MAX_ELEMENTS][ELEMENT_SIZE];
+    int64_t                stamps[MAX_ELEMENTS];
+    std::atomic<uint32_t>  headIndex;      // Next slot to pop  (consumer only)
+    std::atomic<uint32_t>  tailIndex;      // Next slot to push (producer only)
+    std::atomic<uint32_t>  pushCount;      // Strings accepted  (producer only)
+    std::atomic<uint32_t>  overflowCount;  // Strings dropped because the buffer was full (producer only)
+    std::atomic<uint32_t>  oversizeCount;  // Strings dropped because they did not fit a slot (producer only)
+    std::atomic<uint32_t>  popCount;       // Strings released (consumer only)
+    std::atomic<uint32_t>  highWater;      // Deepest the buffer has been after a push (producer, reset by consumer)
 
   public:
-    RingBuffer (BufferType inBufferType);
-   ~RingBuffer ();
+    RingBuffer ();
+
+    int          GetNumElements   ();
+    bool         PushString       (const char *newElement, int length, int64_t stamp = 0);  // Producer side
+    const char  *PeekString       ();                                    // Consumer side, NULL if empty
+    int64_t      PeekStamp        ();                                    // Consumer side, the peeked string's stamp
+    void         ReleaseString    ();                                    // Consumer side, frees the peeked slot
 
-    int    GetNumElements ();
-    void   PushString     (const char *newElement);
-    char  *PopString      ();
+    uint32_t     GetPushCount     ();
+    uint32_t     GetPopCount      ();
+    uint32_t     GetOverflowCount ();
+    uint32_t     GetOversizeCount ();
+    uint32_t     GetHighWater     ();
+    void         ResetHighWater   ();
 };
 
 
@@ -0,0 +1,93 @@
+//=========================================================
+//
+//     FILE : Scheduler.h
+//
+//  PROJECT : SMAC Framework
+//              │
+//              └── Firmware
+//                    │
+//                    └── Node
+//
+//    NOTES : Periodic Device scheduler:
+//
+//            █ Devices with Periodic Processing enabled are kept in a min-heap
+//              keyed on their next deadline (esp_timer microseconds, which do
+//              not wrap), so the Node only visits Devices that are due and
+//              knows exactly how long it may sleep.
+//
+//            █ Deadlines advance by whole periods (in microseconds) from the
+//              previous deadline, not from the time DoPeriodic() happened to
+//              run, so the rate does not drift.  A Device that falls a full
+//              period or more behind is counted as an overrun, then follows
+//              its SchedulePolicy:
+//
+//              ∙ SCHEDULE_SKIP     : the missed calls are skipped and the next
+//                                    deadline is the next one on the period grid
+//              ∙ SCHEDULE_CATCH_UP : the missed calls are made back to back,
+//                                    unless MAX_CATCH_UP_PERIODS or more were
+//                                    missed, then it skips
+//
+//            █ Devices join the heap through Add() (ENPP, SRAT, AddDevice)
+//              and leave through Remove() (DIPP).  A Device that clears
+//              <periodicEnabled> directly is dropped the next time it
+//              reaches the top of the heap.
+//
+//            █ Only the task that owns the Scheduler may call these methods: the Node's Run()
+//              task, or a Device's own task (see Device::RunOnTask()).  Commands for a Device on
+//              its own task reach its Scheduler while holding the Device's <taskLock>.
+//
+//   AUTHOR : Bill Daniels
+//            Copyright 2021-2025, D+S Tech Labs, Inc.
+//            All Rights Reserved
+//
+//=========================================================
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+//--- Includes --------------------------------------------
+
+#include "common.h"
+
+class Device;
+
+//--- Types -----------------------------------------------
+
+enum SchedulePolicy
+{
+  SCHEDULE_SKIP,      // Drop missed periods, keep the phase (default)
+  SCHEDULE_CATCH_UP   // Run missed periods back to back
+};
+
+
+//=========================================================
+//  class Scheduler
+//=========================================================
+
+class Scheduler
+{
+  private:
+    Device  *heap[MAX_DEVICES];  // heap[0] has the earliest deadline
+    int     heapSize = 0;
+
+    void    Place    (Device *device, int index);
+    void    SiftUp   (int index);
+    void    SiftDown (int index);
+
+  public:
+    // Timing statistics
+    unsigned long  runs      = 0L;  // Periodic processes run
+    unsigned long  overruns  = 0L;  // Runs that were a full period or more late
+    int64_t        totalLate = 0;   // Sum of run lateness (uSecs)
+    int64_t        maxLate   = 0;   // Worst run lateness (uSecs)
+
+    void      Add          (Device *device);             // Schedule <device> to run now, then every period
+    void      Remove       (Device *device);             // Stop scheduling <device>
+    Device *  NextDue      (int64_t now);                // The earliest Device due at <now>, or NULL
+    void      Advance      (Device *device, int64_t now);  // Move the due Device to its next deadline
+    int64_t   NextDeadline ();                           // Earliest deadline, INT64_MAX if none
+    int       GetNumScheduled ();
+    void      ResetStats   ();
+};
+
+#endif
@@ -0,0 +1,112 @@
+//=========================================================
+//
+//     FILE : SerialLink.h
+//
+//  PROJECT : SMAC Framework
+//              │
+//              └── Firmware
+//                    │
+//                    └── Node
+//
+//    NOTES : Framed SMAC transport over the Serial port (USB-CDC on boards with native USB):
+//
+//            █ On the bench, with the Node tethered by USB, a host program can carry the whole
+//              SMAC command/data protocol over the console port instead of ESP-NOW.  USB-CDC runs
+//              at USB speed whatever SERIAL_BAUDRATE says, so tuning sessions get far more telemetry
+//              bandwidth than the radio, and bench measurements see no radio loss.
+//
+//            █ Each frame is COBS encoded (Consistent Overhead Byte Stuffing), so it holds no 0x00,
+//              and is sent between 0x00 delimiters:
+//
+//                0x00  COBS( type | payload | crcLo | crcHi )  0x00
+//
+//              type    = SERIAL_FRAME_COMMAND ('C', host -> Node) or SERIAL_FRAME_DATA ('D', Node -> host)
+//              payload = exactly what would go over ESP-NOW: a command string ("dd|CCCC|params" or "PONG"),
+//                        or a Data String, binary Data Frame or batch (see common.h)
+//              crc     = CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) of type and payload, little-endian
+//
+//              A frame that is malformed, too long, has a bad CRC or an unknown type is dropped and counted.
+//
+//            █ Anything outside a frame is console text.  Text lines (ending in '\n', '\r' is ignored)
+//              go to the <textHandler> given to Start(), so the Set MAC tool keeps working, and a host
+//              decoder skips the Debugging prints the Node writes between its frames.
+//
+//            █ A reader task takes all the bytes waiting with one bulk read, instead of one Serial.read()
+//              per char, and sleeps SERIAL_LINK_POLL_MS when there are none.  Command frames go to
+//              Node::CommandReceived(), like ESP-NOW commands.
+//
+//            █ Send() writes a whole frame with one Serial.write(), so prints from other tasks never
+//              land inside it.  Only the Node's sender task calls it.
+//
+//   AUTHOR : Bill Daniels
+//            Copyright 2021-2025, D+S Tech Labs, Inc.
+//            All Rights Reserved
+//
+//=========================================================
+
+#ifndef SERIALLINK_H
+#define SERIALLINK_H
+
+//--- Includes --------------------------------------------
+
+#include <Arduino.h>
+#include "common.h"
+
+//--- Defines ---------------------------------------------
+
+#define SERIAL_FRAME_COMMAND       'C'  // Frame type: command string, host -> Node
+#define SERIAL_FRAME_DATA          'D'  // Frame type: data frame, Node -> host
+#define SERIAL_FRAME_MAX_LENGTH    (1 + MAX_MESSAGE_LENGTH + 2)  // type + payload + CRC, before encoding
+#define SERIAL_FRAME_MAX_ENCODED   (SERIAL_FRAME_MAX_LENGTH + SERIAL_FRAME_MAX_LENGTH/254 + 1)
+#define SERIAL_LINK_READ_SIZE      256  // Most bytes taken by one bulk read
+#define SERIAL_LINK_POLL_MS          1  // Reader task sleep when no bytes are waiting
+#define SERIAL_LINK_TASK_CORE        1
+#define SERIAL_LINK_TASK_PRIORITY    2
+#define SERIAL_LINK_TASK_STACK    3072  // Bytes
+
+//--- Types -----------------------------------------------
+
+typedef void (*TextHandler) (const char *line);  // Receives each console text line
+
+
+//=========================================================
+//  class SerialLink
+//=========================================================
+
+class SerialLink
+{
+  private:
+    // Reader task only
+    uint8_t        rxFrame[SERIAL_FRAME_MAX_ENCODED];  // Encoded bytes of the frame being received
+    int            rxLength     = 0;
+    bool           inFrame      = false;  // Between the opening and closing 0x00
+    bool           rxOverflow   = false;  // The frame being received is too long, skip to its end
+    char           textLine[SERIAL_MAX_LENGTH];
+    int            textLength   = 0;
+    TextHandler    textHandler  = NULL;
+    TaskHandle_t   readerTask   = NULL;
+
+    // Sender task only
+    uint8_t        txFrame[SERIAL_FRAME_MAX_ENCODED + 2];  // Encoded frame and its delimiters
+
+    static void  ReaderMain   (void *arg);  // Body of the reader task
+    void         Receive      (const uint8_t *bytes, int count);
+    void         ReceiveText  (char c);
+    void         ReceiveFrame ();           // Decode, check and dispatch <rxFrame>
+
+  public:
+    unsigned long  framesIn     = 0L;  // Good frames received
+    unsigned long  framesOut    = 0L;  // Frames written
+    unsigned long  badFrames    = 0L;  // Frames dropped: malformed, too long, bad CRC or unknown type
+    unsigned long  writeErrors  = 0L;  // Frames Serial.write() did not take whole
+
+    bool  Start      (TextHandler handler);  // Start the reader task
+    bool  Send       (uint8_t type, const uint8_t *payload, int length);  // Write one frame (one task only)
+    void  ResetStats ();
+
+    static uint16_t  Crc16  (const uint8_t *data, int length, uint16_t crc = 0xFFFF);
+    static int       Encode (const uint8_t *data, int length, uint8_t *encoded);  // Returns encoded length
+    static int       Decode (const uint8_t *encoded, int length, uint8_t *data);  // Returns length, -1 if malformed
+};
+
+#endif
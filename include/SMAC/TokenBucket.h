@@ -0,0 +1,81 @@
+//=========================================================
+//
+//     FILE : TokenBucket.h
+//
+//  PROJECT : SMAC Framework
+//              │
+//              └── Firmware
+//                    │
+//                    └── Node
+//
+//    NOTES : Outbound rate limiting:
+//
+//            █ A TokenBucket refills at <rate> tokens per second, up to <capacity>
+//              (the burst it allows, LIMIT_BURST_MS worth of tokens).  The Node keeps
+//              one of airtime bytes and one of records (see Node::SendDataPacket()).
+//
+//            █ Traffic is admitted by TrafficClass, not by cost.  Whatever is admitted
+//              is charged afterwards, when its size is known, so the tokens can go
+//              negative (never more than that charge below -capacity) and the lower
+//              classes wait for the debt to be paid back:
+//
+//              ∙ TRAFFIC_RESPONSE  : always admitted (command responses)
+//              ∙ TRAFFIC_STATUS    : admitted while the bucket is not empty
+//              ∙ TRAFFIC_TELEMETRY : admitted while the bucket holds more than
+//                                    TELEMETRY_RESERVE_PERCENT of its capacity,
+//                                    which is kept for the classes above
+//
+//            █ A bucket with a <rate> of 0 does not limit anything.
+//
+//            █ Only the Node's Run() task refills or charges a bucket.  Other tasks
+//              may call Admits() (a single word read) to skip a report before they
+//              format it (see Node::TxBackpressure()).
+//
+//   AUTHOR : Bill Daniels
+//            Copyright 2021-2025, D+S Tech Labs, Inc.
+//            All Rights Reserved
+//
+//=========================================================
+
+#ifndef TOKENBUCKET_H
+#define TOKENBUCKET_H
+
+//--- Includes --------------------------------------------
+
+#include <stdint.h>
+
+//--- Defines ---------------------------------------------
+
+#define LIMIT_BURST_MS              100  // A bucket holds this long of its rate
+#define TELEMETRY_RESERVE_PERCENT    25  // Part of a bucket telemetry may not use
+
+//--- Types -----------------------------------------------
+
+enum TrafficClass
+{
+  TRAFFIC_RESPONSE,   // R : Command responses
+  TRAFFIC_STATUS,     // S : Safety and status reports, the Node's own reports
+  TRAFFIC_TELEMETRY,  // T : Periodic data and subscriptions (default for Devices)
+  NUM_TRAFFIC_CLASSES
+};
+
+
+//=========================================================
+//  class TokenBucket
+//=========================================================
+
+class TokenBucket
+{
+  public:
+    unsigned long   rate     = 0L;    // Tokens per second (0 = no limit)
+    float           capacity = 0.0f;
+    volatile float  tokens   = 0.0f;
+    int64_t         lastUs   = 0;     // esp_timer time of the last Refill()
+
+    void  SetRate (unsigned long perSecond);         // Starts full
+    void  Refill  (int64_t nowUs);
+    bool  Admits  (TrafficClass trafficClass) const;
+    void  Charge  (float used);
+};
+
+#endif
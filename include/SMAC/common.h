@@ -50,35 +50,116 @@
 #define MAX_NODES                20  // Maximum number of ESP-NOW peers
 #define MAX_DEVICES             100  // Maximum number of Devices that can connect to a Node
 #define ID_SIZE                   2  // Size of nodeID and deviceID
+#define NODE_DEVICE_ID           99  // deviceID of the Node's own unrequested reports (no Device gets it)
 #define MAX_NAME_LENGTH          32
 #define MAX_MESSAGE_LENGTH      250  // Max message size for ESP-NOW protocol
 #define MAC_SIZE                  6  // Size of ESP32 MAC Address
 #define MAX_VALUE_LENGTH        240
 #define MAX_PARAMS_LENGTH       240
+#define MAX_PARAM_TOKENS         10  // Max '|' separated params split out for a CPacket (SDBD takes 9)
 #define MIN_COMMAND_LENGTH        7  // Minimum Input Command String: dd|cccc
 #define COMMAND_SIZE              4
+#define MAX_DATA_FIELDS           8  // Max typed fields in one DPacket
+#define MAX_TEXT_FIELD_LENGTH    63  // Max chars of one text field in a binary Data Frame
+
+//--- Binary Data Frame ---
+// A binary Data Frame starts with DATA_FRAME_MARKER, which can never be the first
+// char of an ASCII Data String (those start with the 2-digit nodeID).
+// All multi-byte values are little-endian.
+//
+//   byte 0     : DATA_FRAME_MARKER
+//   byte 1     : nodeID   (0-19)
+//   byte 2     : deviceID (0-99)
+//   byte 3     : number of fields (0 = the rest of the frame is the value string, not NULL terminated)
+//   bytes 4-7  : timestamp (uint32)
+//   bytes 8... : fields, each a 1-byte DataFieldType followed by
+//                4 bytes for INT32/UINT32/FLOAT, or a 1-byte length and the chars for TEXT
+#define DATA_FRAME_MARKER      0xDB
+#define DATA_FRAME_HEADER_SIZE    8
+
+//--- Batched Frames ---
+// When batching is on (SBAT command), several records share one ESP-NOW frame:
+//   ASCII  : Data Strings separated with '\n', one NULL terminator at the end
+//   Binary : DATA_BATCH_MARKER, a 1-byte record count, then each record as a
+//            1-byte length followed by a Data Frame
+#define DATA_BATCH_MARKER      0xDC
+#define DATA_BATCH_HEADER_SIZE    2
 
 //--- Types -----------------------------------------------
 
+enum DataFieldType : uint8_t
+{
+  FIELD_INT32  = 1,
+  FIELD_UINT32 = 2,
+  FIELD_FLOAT  = 3,
+  FIELD_TEXT   = 4
+};
+
+typedef struct DField
+{
+  DataFieldType  type;
+  union
+  {
+    int32_t      i32;
+    uint32_t     u32;
+    float        f32;
+    const char   *text;  // Must stay valid until the packet is sent (names, literals)
+  };
+} DField;
+
+// A DPacket is one outgoing report.  There is no global packet: whoever makes a
+// report owns its DPacket (usually on the stack) and hands it to the Node, so
+// any number of tasks can build reports at the same time.
 typedef struct DPacket
 {
   char           deviceID[ID_SIZE + 1];
   unsigned long  timestamp;
-  char           value[MAX_VALUE_LENGTH + 1];
+  char           value[MAX_VALUE_LENGTH + 1];  // Used when numFields is 0
+  int            numFields;                    // > 0 means <fields> holds the data instead of <value>
+  DField         fields[MAX_DATA_FIELDS];
+
+  // Typed field helpers: the Node renders typed fields as "field|field|..." in ASCII
+  // mode or packs them little-endian in binary mode (see DATA_FRAME_MARKER).
+  void  ClearFields   ()                  { numFields = 0; }
+  void  AddIntField   (int32_t value)     { if (numFields < MAX_DATA_FIELDS) { fields[numFields].type = FIELD_INT32;  fields[numFields++].i32  = value; } }
+  void  AddUIntField  (uint32_t value)    { if (numFields < MAX_DATA_FIELDS) { fields[numFields].type = FIELD_UINT32; fields[numFields++].u32  = value; } }
+  void  AddFloatField (float value)       { if (numFields < MAX_DATA_FIELDS) { fields[numFields].type = FIELD_FLOAT;  fields[numFields++].f32  = value; } }
+  void  AddTextField  (const char *text)  { if (numFields < MAX_DATA_FIELDS) { fields[numFields].type = FIELD_TEXT;   fields[numFields++].text = text;  } }
 } DPacket;
 
+enum DataFormat
+{
+  ASCII_FORMAT,   // nn|dd|timestamp|value  (default, what SMAC_Interface.js reads)
+  BINARY_FORMAT   // Binary Data Frame (see DATA_FRAME_MARKER)
+};
+
+// One '|' separated token of a command's params, read in place.
+// It is NOT NULL terminated, so stop at <length> (strtol() and friends stop at the '|' anyway).
+typedef struct ParamSpan
+{
+  const char  *text;
+  uint8_t     length;
+} ParamSpan;
+
+// A CPacket is one incoming command, parsed by the Node and passed to
+// ExecuteCommand() along with the DPacket for its reply.
+// Nothing is copied: <params> and <tokens> point into the command's slot in the
+// CommandBuffer, which stays put (and must not be written) until ExecuteCommand() returns.
 typedef struct CPacket
 {
-  int   deviceIndex;
-  char  command[COMMAND_SIZE + 1];
-  char  params[MAX_PARAMS_LENGTH + 1];
+  int         deviceIndex;
+  char        command[COMMAND_SIZE + 1];
+  uint32_t    key;         // <command> packed with CommandKey() for table dispatch
+  const char  *params;     // Everything after dd|CCCC| ("" if none), NULL terminated
+  int         numTokens;   // <params> split on '|', the last token holds the rest if there are more
+  ParamSpan   tokens[MAX_PARAM_TOKENS];
 } CPacket;
 
 enum ProcessStatus
 {
-  SUCCESS_DATA,    // Process performed successfully, send <DataPacket> to Relayer
+  SUCCESS_DATA,    // Process performed successfully, send the DPacket to Relayer
   SUCCESS_NODATA,  // Process performed successfully, no data to send to Relayer
-  FAIL_DATA,       // Process failed, error code or message stored in value field of <DataPacket>, send <DataPacket> to Relayer
+  FAIL_DATA,       // Process failed, error code or message stored in value field of the DPacket, send it to Relayer
   FAIL_NODATA,     // Process failed, no data to send to Relayer
   NOT_HANDLED      // Command was not handled by base class ExecuteCommand(), child Node or Device class should handle the command
 };
@@ -89,8 +170,5 @@ extern bool        Debugging;
 extern esp_err_t   ESPNOW_Result;
 extern uint8_t     RelayerMAC[];
 extern RingBuffer  *CommandBuffer;
-extern DPacket     DataPacket;
-extern CPacket     CommandPacket;
-extern char        DataString[];
 
 #endif
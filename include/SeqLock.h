@@ -0,0 +1,130 @@
+/**
+ * @file SeqLock.h
+ * @author Doug Fajardo
+ * @brief Lock-free snapshots of control state shared between tasks
+ * @version 0.1
+ * @date 2025-09-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Both classes have ONE writer task and any number of reader tasks.
+ * The writer never waits and never disables interrupts; a reader that
+ * catches a write in progress copies the value again. T is copied
+ * as a whole, so a reader always gets every member from the same write
+ * (no torn doubles, no setpoint from one write and output from another).
+ *
+ *   SeqLock<T> - one copy of T. A reader waits out a write in progress,
+ *       so use it when a reader can not preempt the writer on its core
+ *       (the writer is the higher priority task, or the same task).
+ *       Example: the speed the esp_timer task writes and the loop reads.
+ *
+ *   Mailbox<T> - two copies of T. The writer fills the one readers are
+ *       not pointed at, then flips, so a reader never waits on a write in
+ *       progress. Use it when the reader may preempt the writer.
+ *       Example: a setpoint a command writes and the control timer reads.
+ *
+ * T must be trivially copyable (plain numbers and structs of them).
+ */
+#pragma once
+#include <atomic>
+#include <stdint.h>
+#include <type_traits>
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - -
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock<T> needs a trivially copyable T");
+
+    private:
+        std::atomic<uint32_t> sequence{0};   // odd while a write is in progress
+        T value{};
+
+    public:
+        SeqLock() {}
+        SeqLock(const T &initial) : value(initial) {}
+
+        /**
+         * @brief Publish a new value (writer task only, never waits)
+         */
+        void write(const T &newValue)
+        {
+            uint32_t seq = sequence.load(std::memory_order_relaxed);
+            sequence.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            value = newValue;
+            sequence.store(seq + 2, std::memory_order_release);
+        }
+
+        /**
+         * @brief Return a consistent copy of the latest value (any task)
+         */
+        T read() const
+        {
+            T copy;
+            uint32_t before, after;
+            do
+            {
+                before = sequence.load(std::memory_order_acquire);
+                copy = value;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = sequence.load(std::memory_order_relaxed);
+            } while ((before & 1) || (before != after));
+            return(copy);
+        }
+};
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - -
+template <typename T>
+class Mailbox
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Mailbox<T> needs a trivially copyable T");
+
+    private:
+        std::atomic<uint32_t> sequence{0};   // writes so far; slots[sequence & 1] is the latest
+        T slots[2] = {};
+
+    public:
+        Mailbox() {}
+        Mailbox(const T &initial) { slots[0] = initial; }
+
+        /**
+         * @brief Publish a new value (writer task only, never waits)
+         */
+        void write(const T &newValue)
+        {
+            uint32_t seq = sequence.load(std::memory_order_relaxed);
+            slots[(seq + 1) & 1] = newValue;   // the slot readers are not pointed at
+            sequence.store(seq + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Return a consistent copy of the latest value (any task)
+         *   Copies again only if the writer published meanwhile, since its
+         *   next write after that goes into the slot being copied. A write
+         *   still in progress is in the other slot, so it is never waited on.
+         */
+        T read() const
+        {
+            T copy;
+            uint32_t before, after;
+            do
+            {
+                before = sequence.load(std::memory_order_acquire);
+                copy = slots[before & 1];
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = sequence.load(std::memory_order_relaxed);
+            } while (before != after);
+            return(copy);
+        }
+
+        /**
+         * @brief Number of writes so far, to tell if there is a new value
+         */
+        uint32_t writes() const
+        {
+            return(sequence.load(std::memory_order_acquire));
+        }
+};
@@ -32,6 +32,7 @@ extern xSemaphoreHandle I2CMutex;
 //     from _timeval.h (ESP32 idf?)
 // DISTANCE:
 typedef int32_t pulse_t;
+typedef int64_t pulse64_t;   // accumulated position, does not wrap (see DEV_QuadDecoder::sampleCount())
 typedef double  dist_t;
 
 // Robot Dimensions (in mm)
@@ -77,7 +78,26 @@ typedef double  dist_t;
 // Default scaling for quad and PID controller
 #define QUAD_PULSES_PER_REV   600
 #define SPEED_CHECK_INTERVAL_mSec 50
+// Speed estimation blend (see DEV_QuadDecoder::update_speed_cb()), in counts per speed check
+#define QUAD_BLEND_LOW_COUNTS     4   // at or below: edge-period estimate only
+#define QUAD_BLEND_HIGH_COUNTS   16   // at or above: count-delta estimate only
+#define QUAD_STOP_TIMEOUT_uSec  500000 // no encoder edge for this long means stopped
+// Speed observer (see Observer.h and DEV_QuadDecoder::updateObserver()), in counts and seconds
+#define QUAD_OBS_PROCESS_NOISE  1.0e5  // jerk density, counts^2/sec^5: ~45 mSec to follow a step
+#define QUAD_OBS_MEASURE_NOISE  (1.0/12.0) // variance of a count, counts^2 (quantization)
+#define QUAD_OBS_BOUND_COUNTS     2.0  // no edge for t: |velocity| <= this many counts / t
+#define QUAD_OBS_CELL_MARGIN      0.25 // counts the estimate may stray past the count's boundaries
 #define PID_SAMPLE_TIME_ms    1000.0
+// Control loop (see ControlLoop.h): speed checks, PIDs and motor outputs on one tick.
+//   While it runs, SPEED_CHECK_INTERVAL_mSec and PID_SAMPLE_TIME_ms are not used.
+#define CONTROL_RATE_HZ        200
+#define CONTROL_RATE_MIN_HZ      1
+#define CONTROL_RATE_MAX_HZ   1000
+// Capture (see Capture.h): both wheels recorded at the control tick rate, downloaded afterwards
+#define CAPTURE_PSRAM_BYTES   (1024*1024) // ring size with BOARD_HAS_PSRAM: 52428 records
+#define CAPTURE_SRAM_BYTES    (16*1024)   // without PSRAM, in internal RAM: 819 records
+#define CAPTURE_CHUNK_RECORDS    7        // records per CGET reply: 188 base64 chars, so a traced reply
+                                          //   still fits one text frame (checked in DEV_Driver.cpp)
 #define DEFAULT_Kp              50.0
 #define DEFAULT_Ki               0.0
 #define DEFAULT_Kd               0.0
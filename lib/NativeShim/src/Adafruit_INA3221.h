@@ -0,0 +1,32 @@
+/**
+ * @file Adafruit_INA3221.h
+ * @brief Native shim - INA3221 that reports a steady, slightly noisy supply.
+ */
+#pragma once
+#include "Arduino.h"
+#include "Wire.h"
+
+typedef enum {
+    INA3221_AVG_1_SAMPLE = 0, INA3221_AVG_4_SAMPLES, INA3221_AVG_16_SAMPLES, INA3221_AVG_64_SAMPLES,
+    INA3221_AVG_128_SAMPLES, INA3221_AVG_256_SAMPLES, INA3221_AVG_512_SAMPLES, INA3221_AVG_1024_SAMPLES,
+} ina3221_avgmode;
+
+typedef enum {
+    INA3221_CONVTIME_140US = 0, INA3221_CONVTIME_204US, INA3221_CONVTIME_332US, INA3221_CONVTIME_588US,
+    INA3221_CONVTIME_1MS, INA3221_CONVTIME_2MS, INA3221_CONVTIME_4MS, INA3221_CONVTIME_8MS,
+} ina3221_convtime;
+
+class Adafruit_INA3221
+{
+  private:
+    float shunt[3] = {0.05f, 0.05f, 0.05f};
+
+  public:
+    bool  begin(uint8_t i2c_addr = 0x40, TwoWire *theWire = &Wire) { (void)i2c_addr; (void)theWire; return true; }
+    void  setShuntResistance(uint8_t channel, float ohms)       { if (channel < 3) shunt[channel] = ohms; }
+    void  setAveragingMode(ina3221_avgmode mode)                { (void)mode; }
+    void  setBusVoltageConvTime(ina3221_convtime convTime)      { (void)convTime; }
+    void  setShuntVoltageConvTime(ina3221_convtime convTime)    { (void)convTime; }
+    float getBusVoltage(uint8_t channel)                        { return 12.0f - 0.1f * channel + (rand() % 100) * 0.0001f; }
+    float getCurrentAmps(uint8_t channel)                       { return 0.25f + 0.05f * channel + (rand() % 100) * 0.00001f; }
+};
@@ -0,0 +1,238 @@
+/**
+ * @file Arduino.cpp
+ * @author Doug Fajardo
+ * @brief Host (native) implementation of the Arduino core stand-in.
+ * @version 0.1
+ * @date 2025-08-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * main() calls the sketch's setup() once, then loop() until the process
+ * is interrupted or (if SMAC_RUN_MS is set in the environment) that many
+ * milliseconds have elapsed. The latter makes runs under perf/valgrind
+ * repeatable. If SMAC_RELAYER_SIM is set, the Relayer simulator (see
+ * RelayerSim.h) is started before setup() and reports when main() stops.
+ */
+#include "Arduino.h"
+#include "NativeShim.h"
+#include "RelayerSim.h"
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+
+HardwareSerial Serial;
+
+static const auto bootTime = std::chrono::steady_clock::now();
+static std::atomic<bool> stopRequested(false);
+
+// - - - - - - - - - - Time - - - - - - - - - -
+int64_t NativeShim_MicrosSinceBoot()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(NativeShim_MicrosSinceBoot() / 1000);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)NativeShim_MicrosSinceBoot();
+}
+
+void delay(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+// - - - - - - - - - - GPIO / LED - - - - - - -
+static uint8_t pinLevels[64];
+
+void pinMode(uint8_t pin, uint8_t mode)              { (void)pin; (void)mode; }
+void digitalWrite(uint8_t pin, uint8_t val)          { if (pin < 64) pinLevels[pin] = val; }
+int  digitalRead(uint8_t pin)                        { return (pin < 64) ? pinLevels[pin] : 0; }
+void rgbLedWrite(uint8_t pin, uint8_t r, uint8_t g, uint8_t b) { (void)pin; (void)r; (void)g; (void)b; }
+
+static void (*pinHandlers[64])(void *);
+static void *pinHandlerArgs[64];
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode)
+{
+    (void)mode;
+    if (pin >= 64) return;
+    pinHandlerArgs[pin] = arg;
+    pinHandlers[pin]    = handler;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    if (pin < 64) pinHandlers[pin] = nullptr;
+}
+
+void NativeShim_PinChanged(uint8_t pin)
+{
+    if (pin < 64 && pinHandlers[pin] != nullptr)
+        pinHandlers[pin](pinHandlerArgs[pin]);
+}
+
+// - - - - - - - - - - Math / chars - - - - - -
+long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+char *ultoa(unsigned long value, char *result, int base)
+{
+    char tmp[sizeof(unsigned long) * 8 + 1];
+    int  len = 0;
+    do
+    {
+        int digit = value % base;
+        tmp[len++] = (digit < 10) ? ('0' + digit) : ('a' + digit - 10);
+        value /= base;
+    } while (value != 0);
+
+    for (int i = 0; i < len; i++)
+        result[i] = tmp[len - 1 - i];
+    result[len] = 0;
+    return result;
+}
+
+char *ltoa(long value, char *result, int base)
+{
+    if (value < 0 && base == 10)
+    {
+        result[0] = '-';
+        ultoa((unsigned long)(-value), result + 1, base);
+        return result;
+    }
+    return ultoa((unsigned long)value, result, base);
+}
+
+// - - - - - - - - - - String - - - - - - - - -
+void String::toCharArray(char *buf, unsigned int bufsize) const
+{
+    if (bufsize == 0) return;
+    strncpy(buf, c_str(), bufsize - 1);
+    buf[bufsize - 1] = 0;
+}
+
+// - - - - - - - - - - Serial - - - - - - - - -
+void HardwareSerial::begin(unsigned long baud)
+{
+    (void)baud;
+    fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+}
+
+int HardwareSerial::available()
+{
+    // Bytes waiting on stdin.  (select() would also report a closed stdin,
+    // such as /dev/null, as readable forever.)
+    int waiting = 0;
+    if (ioctl(STDIN_FILENO, FIONREAD, &waiting) != 0)
+        return 0;
+    return waiting;
+}
+
+int HardwareSerial::read()
+{
+    unsigned char c;
+    return (::read(STDIN_FILENO, &c, 1) == 1) ? c : -1;
+}
+
+size_t HardwareSerial::read(uint8_t *buffer, size_t size)
+{
+    ssize_t n = ::read(STDIN_FILENO, buffer, size);
+    return (n > 0) ? (size_t)n : 0;
+}
+
+size_t HardwareSerial::readBytes(char *buffer, size_t length)
+{
+    ssize_t n = ::read(STDIN_FILENO, buffer, length);
+    return (n > 0) ? (size_t)n : 0;
+}
+
+size_t HardwareSerial::write(uint8_t c)                          { return fwrite(&c, 1, 1, stdout); }
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) { return fwrite(buffer, 1, size, stdout); }
+void   HardwareSerial::flush()                                   { fflush(stdout); }
+
+size_t HardwareSerial::print(const char *s)          { return fputs(s, stdout) >= 0 ? strlen(s) : 0; }
+size_t HardwareSerial::print(const String &s)        { return print(s.c_str()); }
+size_t HardwareSerial::print(char c)                 { return write((uint8_t)c); }
+size_t HardwareSerial::print(int n)                  { return ::printf("%d", n); }
+size_t HardwareSerial::print(unsigned int n)         { return ::printf("%u", n); }
+size_t HardwareSerial::print(long n)                 { return ::printf("%ld", n); }
+size_t HardwareSerial::print(unsigned long n)        { return ::printf("%lu", n); }
+size_t HardwareSerial::print(long long n)            { return ::printf("%lld", n); }
+size_t HardwareSerial::print(unsigned long long n)   { return ::printf("%llu", n); }
+size_t HardwareSerial::print(double d, int digits)   { return ::printf("%.*f", digits, d); }
+size_t HardwareSerial::println()                     { return print("\r\n"); }
+
+size_t HardwareSerial::printf(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int n = vprintf(fmt, args);
+    va_end(args);
+    return (n > 0) ? (size_t)n : 0;
+}
+
+// - - - - - - - - - - Process control - - - - -
+void NativeShim_RequestStop()
+{
+    stopRequested = true;
+}
+
+bool NativeShim_StopRequested()
+{
+    return stopRequested;
+}
+
+#if !defined(NATIVE_SHIM_NO_MAIN) && !defined(PIO_UNIT_TESTING)   // unit tests have Unity's main()
+static void onSignal(int sig)
+{
+    (void)sig;
+    stopRequested = true;
+}
+
+int main(int argc, char *argv[])
+{
+    (void)argc; (void)argv;
+    signal(SIGINT,  onSignal);
+    signal(SIGTERM, onSignal);
+
+    const char *runMs = getenv("SMAC_RUN_MS");
+    int64_t stopAtUs  = (runMs != nullptr) ? atoll(runMs) * 1000LL : 0;
+
+    const char *relayerSim = getenv("SMAC_RELAYER_SIM");
+    if (relayerSim != nullptr && !RelayerSim_Start(relayerSim))
+        fprintf(stderr, "SMAC_RELAYER_SIM: expected all, or a list of joy, query, pid, telem (and udp)\n");
+
+    setup();
+    while (!stopRequested)
+    {
+        loop();
+        if (stopAtUs > 0 && NativeShim_MicrosSinceBoot() >= stopAtUs)
+            break;
+    }
+
+    if (relayerSim != nullptr)
+        RelayerSim_Stop(stderr);
+
+    // Device and sender tasks are detached threads that never return, so skip
+    // the static destructors they could still be using and just leave.
+    fflush(stdout);
+    _Exit(0);
+}
+#endif
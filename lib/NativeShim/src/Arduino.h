@@ -0,0 +1,142 @@
+/**
+ * @file Arduino.h
+ * @author Doug Fajardo
+ * @brief Host (native) stand-in for the parts of the Arduino-ESP32 core
+ *        that the SMAC framework and TwoWheeler devices actually use.
+ * @version 0.1
+ * @date 2025-08-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * This is ONLY used by the [env:native] build (see platformio.ini). It lets
+ * Node, Device, DefDevice, RingBuffer, PIDX, Interp and the DEV_* classes
+ * compile and run on Linux, so the hot paths can be benchmarked with
+ * perf/valgrind instead of guessing on the board.
+ *
+ * Timing (millis/micros/esp_timer_get_time) is taken from the host
+ * monotonic clock. 'Serial' writes to stdout and reads from stdin.
+ */
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <time.h>
+#include <string>
+
+#include "esp_err.h"
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+
+#ifndef ARDUINO
+#define ARDUINO 10819
+#endif
+#define SMAC_NATIVE_SHIM 1
+
+#define HIGH          1
+#define LOW           0
+#define INPUT         0x01
+#define OUTPUT        0x03
+#define LED_BUILTIN   2
+
+#ifndef constrain
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#endif
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// - - - - - - - - - - Time - - - - - - - - - -
+unsigned long millis();
+unsigned long micros();
+void          delay(uint32_t ms);
+void          delayMicroseconds(uint32_t us);
+
+// - - - - - - - - - - GPIO / LED - - - - - - -
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+void rgbLedWrite(uint8_t pin, uint8_t red, uint8_t green, uint8_t blue);
+
+// Pin change interrupts: the handler runs on the thread that changed the pin
+// (see ESP32Encoder::advance())
+#define RISING        0x01
+#define FALLING       0x02
+#define CHANGE        0x03
+void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode);
+void detachInterrupt(uint8_t pin);
+void NativeShim_PinChanged(uint8_t pin);
+
+// - - - - - - - - - - Math / chars - - - - - -
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+inline bool isDigit(int c) { return (isdigit(c) != 0); }
+
+// - - - - - - - - - - libc extras from newlib - -
+char *ltoa(long value, char *result, int base);
+char *ultoa(unsigned long value, char *result, int base);
+
+// - - - - - - - - - - PSRAM (esp32-hal-psram) - -
+// The host heap stands in for PSRAM
+inline bool  psramFound() { return(true); }
+inline void *ps_malloc(size_t size) { return(malloc(size)); }
+
+// - - - - - - - - - - String - - - - - - - - -
+// Only what the SMAC Node needs (WiFi.macAddress().toCharArray(...))
+class String : public std::string
+{
+  public:
+    String() {}
+    String(const char *s) : std::string(s) {}
+    String(const std::string &s) : std::string(s) {}
+    void toCharArray(char *buf, unsigned int bufsize) const;
+};
+
+// - - - - - - - - - - Serial - - - - - - - - -
+class HardwareSerial
+{
+  public:
+    void   begin(unsigned long baud);
+    int    available();
+    int    read();
+    size_t read(uint8_t *buffer, size_t size);
+    size_t readBytes(char *buffer, size_t length);
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buffer, size_t size);
+    void   flush();
+
+    size_t print(const char *s);
+    size_t print(const String &s);
+    size_t print(char c);
+    size_t print(int n);
+    size_t print(unsigned int n);
+    size_t print(long n);
+    size_t print(unsigned long n);
+    size_t print(long long n);
+    size_t print(unsigned long long n);
+    size_t print(double d, int digits = 2);
+
+    size_t println();
+    template <typename T> size_t println(T value)              { size_t n = print(value);         return n + println(); }
+    size_t println(double d, int digits)                        { size_t n = print(d, digits);     return n + println(); }
+
+    size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// Provided by the sketch (src/main.cpp)
+void setup();
+void loop();
@@ -0,0 +1,47 @@
+/**
+ * @file ESP32Encoder.h
+ * @brief Native shim - quadrature encoder whose count is driven by the host.
+ *
+ * On the target the PCNT peripheral counts edges. Here the count only
+ * changes when a host tool calls setCount() or advance(). advance() steps
+ * one count at a time and raises the pin change interrupt of the A and B
+ * pins in turn, like the edges of a real encoder.
+ */
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "Arduino.h"
+
+enum puType { up, down, none };
+
+class ESP32Encoder
+{
+  private:
+    std::atomic<int64_t> count{0};
+    int pinA = -1;
+    int pinB = -1;
+
+  public:
+    static puType useInternalWeakPullResistors;
+
+    void    attachFullQuad(int aPinNumber, int bPinNumber) { pinA = aPinNumber; pinB = bPinNumber; }
+    void    attachHalfQuad(int aPinNumber, int bPinNumber) { pinA = aPinNumber; pinB = bPinNumber; }
+    int64_t getCount()                                     { return count.load(); }
+    int64_t clearCount()                                   { count = 0; return 0; }
+    int64_t setCount(int64_t value)                        { count = value; return value; }
+    void    advance(int64_t delta);
+    int     getPinA()                                      { return pinA; }
+    int     getPinB()                                      { return pinB; }
+};
+
+inline void ESP32Encoder::advance(int64_t delta)
+{
+    int64_t step = (delta < 0) ? -1 : 1;
+    for (; delta != 0; delta -= step)
+    {
+        int64_t now = (count += step);
+        int     pin = (now & 1) ? pinA : pinB;
+        if (pin >= 0)
+            NativeShim_PinChanged((uint8_t)pin);
+    }
+}
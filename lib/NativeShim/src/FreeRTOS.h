@@ -0,0 +1,6 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Native shim - some code includes "FreeRTOS.h" without the directory.
+ */
+#pragma once
+#include "freertos/FreeRTOS.h"
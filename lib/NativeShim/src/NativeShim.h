@@ -0,0 +1,29 @@
+/**
+ * @file NativeShim.h
+ * @author Doug Fajardo
+ * @brief Host-only hooks of the native shim that have no ESP32 equivalent.
+ * @version 0.1
+ * @date 2025-08-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Firmware code must never include this file; it is for host-side tools
+ * (simulators, benchmarks) that need to reach "under" the shimmed APIs.
+ */
+#pragma once
+#include <stdint.h>
+#include "esp_now.h"
+
+int64_t NativeShim_MicrosSinceBoot();  // Same clock as esp_timer_get_time()
+void    NativeShim_RequestStop();      // Ask main() to stop calling loop()
+bool    NativeShim_StopRequested();
+
+// ESP-NOW loopback.
+//   Every esp_now_send() is handed to the 'transmit hook' (if one is set),
+//   which plays the part of the radio + Relayer. The send callback registered
+//   by the firmware is then called with the status the hook returned.
+//   NativeShim_EspNowDeliver() plays the part of the radio receiving a frame:
+//   it calls the receive callback the firmware registered.
+typedef bool (*NativeShim_TxHook)(const uint8_t *mac, const uint8_t *data, size_t len, void *ctx);
+void NativeShim_SetEspNowTxHook(NativeShim_TxHook hook, void *ctx);
+bool NativeShim_EspNowDeliver(const uint8_t *srcMac, const uint8_t *data, int len);
@@ -0,0 +1,71 @@
+/**
+ * @file Preferences.cpp
+ * @author Doug Fajardo
+ * @brief Native shim - in-memory Preferences.
+ * @version 0.1
+ * @date 2025-08-20
+ *
+ * @copyright Copyright (c) 2025
+ */
+#include "Preferences.h"
+#include "WiFi.h"
+
+WiFiClass WiFi;
+
+static std::map<std::string, std::vector<uint8_t>> store;
+
+bool Preferences::begin(const char *name, bool readOnly)
+{
+    (void)readOnly;
+    nameSpace = std::string(name) + "/";
+    return true;
+}
+
+void Preferences::end()
+{
+    nameSpace.clear();
+}
+
+bool Preferences::clear()
+{
+    for (auto it = store.begin(); it != store.end(); )
+    {
+        if (it->first.compare(0, nameSpace.size(), nameSpace) == 0)
+            it = store.erase(it);
+        else
+            ++it;
+    }
+    return true;
+}
+
+bool Preferences::remove(const char *key)
+{
+    return store.erase(nameSpace + key) > 0;
+}
+
+bool Preferences::isKey(const char *key)
+{
+    return store.count(nameSpace + key) > 0;
+}
+
+size_t Preferences::getBytesLength(const char *key)
+{
+    auto it = store.find(nameSpace + key);
+    return (it == store.end()) ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen)
+{
+    auto it = store.find(nameSpace + key);
+    if (it == store.end() || it->second.size() > maxLen)
+        return 0;
+    memcpy(buf, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len)
+{
+    const uint8_t *bytes = (const uint8_t *)value;
+    store[nameSpace + key] = std::vector<uint8_t>(bytes, bytes + len);
+    return len;
+}
@@ -0,0 +1,24 @@
+/**
+ * @file Preferences.h
+ * @brief Native shim - non-volatile storage kept in memory for the run.
+ */
+#pragma once
+#include "Arduino.h"
+#include <map>
+#include <vector>
+
+class Preferences
+{
+  private:
+    std::string nameSpace;
+
+  public:
+    bool   begin(const char *name, bool readOnly = false);
+    void   end();
+    bool   clear();
+    bool   remove(const char *key);
+    bool   isKey(const char *key);
+    size_t getBytesLength(const char *key);
+    size_t getBytes(const char *key, void *buf, size_t maxLen);
+    size_t putBytes(const char *key, const void *value, size_t len);
+};
@@ -0,0 +1,564 @@
+/**
+ * @file RelayerSim.cpp
+ * @author Doug Fajardo
+ * @brief Host-side stand-in for the Relayer (see RelayerSim.h).
+ * @version 0.1
+ * @date 2025-08-22
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Two threads touch the simulator: whichever firmware task calls
+ * esp_now_send() (the transmit hook), and the traffic thread started here.
+ * Everything they share is guarded by simLock. Commands are only ever
+ * delivered from the traffic thread, so the firmware's CommandBuffer
+ * keeps the single producer it has on the target (the WiFi task).
+ *
+ * With the "udp" option, the hook and the traffic thread only write to
+ * their end of a UDP loopback pair, and two more threads read them: the
+ * Relayer's end parses the frames, the Node's end delivers the commands
+ * (now the CommandBuffer's single producer).
+ */
+#include "RelayerSim.h"
+#include "NativeShim.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <math.h>
+#include <mutex>
+#include <stdarg.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#define SIM_DATA_FRAME_MARKER   0xDB    // Must match common.h
+#define SIM_DATA_BATCH_MARKER   0xDC
+#define SIM_FRAME_HEADER_SIZE   8
+
+#define SIM_JOY_PERIOD_US       20000   // 50 Hz
+#define SIM_GNOI_PERIOD_US      1000000
+#define SIM_GDEI_PERIOD_US      2000000
+#define SIM_PID_PERIOD_US       3000000
+#define SIM_REPORT_RATE_HZ      10      // PID periodic reports
+#define SIM_SUBSCRIBE_RATE_HZ   20      // QUAD speed subscriptions
+#define SIM_UDP_POLL_US         50000   // How often the UDP receive threads look at udpRunning
+
+enum SimStream { STREAM_JOY, STREAM_QUERY, STREAM_PID, STREAM_TELEM, NUM_STREAMS };
+static const char *streamNames[NUM_STREAMS] = { "joy", "query", "pid", "telem" };
+
+/**
+ * @brief One command waiting for its reply
+ */
+struct Pending
+{
+    int       device;       // device index the reply comes back from
+    char      prefix[8];    // what the reply value starts with
+    int64_t   sentUs;
+    SimStream stream;
+};
+
+struct StreamStats
+{
+    unsigned long         sent     = 0;
+    unsigned long         answered = 0;
+    unsigned long         lost     = 0;
+    std::vector<uint32_t> latencyUs;
+};
+
+static const uint8_t      relayerMac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+static std::mutex         simLock;
+static std::deque<Pending> pending;
+static StreamStats        stats[NUM_STREAMS];
+static unsigned long      framesIn = 0, bytesIn = 0;
+static unsigned long      telemetryRecords = 0, telemetryBytes = 0;
+static bool               discovering = false;
+static int                driverIndex = -1;
+static int                lastDevice  = 0;
+static std::vector<int>   pidIndexes;
+static std::vector<int>   quadIndexes;
+
+static bool               enabled[NUM_STREAMS];
+static std::atomic<bool>  running(false);
+static std::atomic<bool>  pingSeen(false);
+static std::thread        traffic;
+static int64_t            startUs = 0;
+
+// UDP loopback ("udp" option): one socket on 127.0.0.1 for each end of the radio
+static bool               useUdp      = false;
+static int                nodeSock    = -1;
+static int                relayerSock = -1;
+static std::atomic<bool>  udpRunning(false);
+static std::thread        nodeReceiver;
+static std::thread        relayerReceiver;
+
+// - - - - - - - - - - Node -> Relayer - - - - - - - - - -
+
+/**
+ * @brief Account for one record the Node sent. Called with simLock held.
+ */
+static void onRecord(int device, const char *value, int valueLen, int64_t nowUs)
+{
+    if (valueLen == 4 && memcmp(value, "PING", 4) == 0)
+    {
+        pingSeen = true;
+        return;
+    }
+
+    bool deviceInfo = (valueLen >= 7 && memcmp(value, "DEINFO=", 7) == 0);
+    if (deviceInfo && discovering)
+    {
+        const char *bar  = (const char *)memchr(value + 7, '|', valueLen - 7);
+        int         nlen = (bar != nullptr) ? (int)(bar - (value + 7)) : valueLen - 7;
+        if (nlen == 6 && memcmp(value + 7, "Driver", 6) == 0)
+            driverIndex = device;
+        if (nlen >= 3 && memcmp(value + 7 + nlen - 3, "PID", 3) == 0)
+            pidIndexes.push_back(device);
+        if (nlen >= 4 && memcmp(value + 7 + nlen - 4, "QUAD", 4) == 0)
+            quadIndexes.push_back(device);
+        lastDevice = std::max(lastDevice, device);
+        return;
+    }
+
+    for (auto it = pending.begin(); it != pending.end(); ++it)
+    {
+        int plen = (int)strlen(it->prefix);
+        if (it->device == device && valueLen >= plen && memcmp(value, it->prefix, plen) == 0)
+        {
+            StreamStats &s = stats[it->stream];
+            s.answered++;
+            s.latencyUs.push_back((uint32_t)(nowUs - it->sentUs));
+            pending.erase(it);
+            return;
+        }
+    }
+
+    // The DEINFO frames before the last one belong to a GDEI reply, not telemetry
+    if (!deviceInfo)
+    {
+        telemetryRecords++;
+        telemetryBytes += valueLen;
+    }
+}
+
+/**
+ * @brief Split a binary Data Frame into device + value. Typed frames are
+ *        never command replies, so their value is left empty.
+ */
+static void onBinaryFrame(const uint8_t *frame, int len, int64_t nowUs)
+{
+    if (len < SIM_FRAME_HEADER_SIZE)
+        return;
+    int numFields = frame[3];
+    if (numFields == 0)
+        onRecord(frame[2], (const char *)frame + SIM_FRAME_HEADER_SIZE, len - SIM_FRAME_HEADER_SIZE, nowUs);
+    else
+        onRecord(frame[2], "", 0, nowUs);
+}
+
+/**
+ * @brief Split an ASCII Data String "nn|dd|timestamp|value" into device + value
+ */
+static void onAsciiRecord(const char *text, int len, int64_t nowUs)
+{
+    const char *field = text;
+    const char *end   = text + len;
+    for (int bars = 0; bars < 3; bars++)
+    {
+        field = (const char *)memchr(field, '|', end - field);
+        if (field == nullptr)
+            return;
+        field++;
+    }
+    onRecord(atoi(text + 3), field, (int)(end - field), nowUs);
+}
+
+/**
+ * @brief Account for one frame the Node sent. Called with simLock held.
+ */
+static void onFrame(const uint8_t *data, size_t len, int64_t nowUs)
+{
+    framesIn++;
+    bytesIn += len;
+
+    if (data[0] == SIM_DATA_BATCH_MARKER)
+    {
+        size_t pos = 2;
+        for (int i = 0; i < data[1] && pos < len; i++)
+        {
+            int recordLen = data[pos];
+            onBinaryFrame(data + pos + 1, std::min<int>(recordLen, (int)(len - pos - 1)), nowUs);
+            pos += 1 + recordLen;
+        }
+    }
+    else if (data[0] == SIM_DATA_FRAME_MARKER)
+    {
+        onBinaryFrame(data, (int)len, nowUs);
+    }
+    else
+    {
+        // One Data String, or several separated with '\n' (ASCII batch)
+        const char *text = (const char *)data;
+        const char *end  = (const char *)memchr(text, '\0', len);
+        if (end == nullptr)
+            end = text + len;
+        while (text < end)
+        {
+            const char *eol = (const char *)memchr(text, '\n', end - text);
+            if (eol == nullptr)
+                eol = end;
+            onAsciiRecord(text, (int)(eol - text), nowUs);
+            text = eol + 1;
+        }
+    }
+}
+
+static bool onTransmit(const uint8_t *mac, const uint8_t *data, size_t len, void *ctx)
+{
+    (void)mac; (void)ctx;
+    int64_t nowUs = NativeShim_MicrosSinceBoot();
+    std::lock_guard<std::mutex> lock(simLock);
+    onFrame(data, len, nowUs);
+    return true;
+}
+
+/**
+ * @brief "udp" option: the frame goes out of the Node's socket, and the
+ *        radio reports it sent if the kernel took it
+ */
+static bool onTransmitUdp(const uint8_t *mac, const uint8_t *data, size_t len, void *ctx)
+{
+    (void)mac; (void)ctx;
+    return send(nodeSock, data, len, 0) == (ssize_t)len;
+}
+
+/**
+ * @brief "udp" option: the Relayer's end, timing each frame when it arrives
+ */
+static void relayerReceiveThread()
+{
+    uint8_t frame[ESP_NOW_MAX_DATA_LEN];
+    while (true)
+    {
+        ssize_t len = recv(relayerSock, frame, sizeof(frame), 0);
+        if (len <= 0)
+        {
+            if (!udpRunning)
+                break;   // drained
+            continue;
+        }
+        int64_t nowUs = NativeShim_MicrosSinceBoot();
+        std::lock_guard<std::mutex> lock(simLock);
+        onFrame(frame, (size_t)len, nowUs);
+    }
+}
+
+// - - - - - - - - - - Relayer -> Node - - - - - - - - - -
+
+static void deliver(const char *text)
+{
+    if (useUdp)
+        send(relayerSock, text, strlen(text), 0);
+    else
+        NativeShim_EspNowDeliver(relayerMac, (const uint8_t *)text, (int)strlen(text));
+}
+
+/**
+ * @brief "udp" option: the Node's end, where the radio receives commands
+ */
+static void nodeReceiveThread()
+{
+    uint8_t frame[ESP_NOW_MAX_DATA_LEN];
+    while (true)
+    {
+        ssize_t len = recv(nodeSock, frame, sizeof(frame), 0);
+        if (len <= 0)
+        {
+            if (!udpRunning)
+                break;
+            continue;
+        }
+        NativeShim_EspNowDeliver(relayerMac, frame, (int)len);
+    }
+}
+
+/**
+ * @brief Send "dd|CCCC|params" and expect a reply from <replyDevice>
+ *        that starts with <prefix>.
+ */
+static void sendCommand(SimStream stream, int device, int replyDevice, const char *prefix, const char *format, ...)
+{
+    char    text[ESP_NOW_MAX_DATA_LEN];
+    int     len = snprintf(text, sizeof(text), "%02d|", device);
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text + len, sizeof(text) - len, format, args);
+    va_end(args);
+
+    {
+        std::lock_guard<std::mutex> lock(simLock);
+        Pending p = { replyDevice, {}, NativeShim_MicrosSinceBoot(), stream };
+        strncpy(p.prefix, prefix, sizeof(p.prefix) - 1);
+        pending.push_back(p);
+        stats[stream].sent++;
+    }
+    deliver(text);
+}
+
+/**
+ * @brief Count commands that have waited too long as lost
+ */
+static void expirePending(int64_t nowUs)
+{
+    std::lock_guard<std::mutex> lock(simLock);
+    while (!pending.empty() && nowUs - pending.front().sentUs > RELAYER_SIM_TIMEOUT_US)
+    {
+        stats[pending.front().stream].lost++;
+        pending.pop_front();
+    }
+}
+
+static void sleepUntil(int64_t us)
+{
+    int64_t wait = us - NativeShim_MicrosSinceBoot();
+    if (wait > 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(wait));
+}
+
+static void trafficThread()
+{
+    // Answer the Node's PINGs like the Relayer does
+    while (running && !pingSeen)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    if (!running)
+        return;
+    deliver("PONG");
+
+    // Learn where the Driver and PID devices are from one GDEI
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    {
+        std::lock_guard<std::mutex> lock(simLock);
+        discovering = true;
+    }
+    deliver("00|GDEI");
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    {
+        std::lock_guard<std::mutex> lock(simLock);
+        discovering = false;
+        framesIn = bytesIn = telemetryRecords = telemetryBytes = 0;
+    }
+    if (enabled[STREAM_JOY] && driverIndex < 0)
+        fprintf(stderr, "RelayerSim: no Driver device, joy stream is off\n");
+
+    startUs = NativeShim_MicrosSinceBoot();
+
+    if (enabled[STREAM_TELEM])
+    {
+        // Turn the telemetry on once: periodic reports from the PIDs,
+        // and a subscription to each QUAD's speed (field 1)
+        for (int pid : pidIndexes)
+        {
+            sendCommand(STREAM_TELEM, pid, pid, "RATEHZ=", "SRHZ|%d", SIM_REPORT_RATE_HZ);
+            sendCommand(STREAM_TELEM, pid, pid, "PP Enab", "ENPP");
+        }
+        for (int quad : quadIndexes)
+            sendCommand(STREAM_TELEM, 0, 0, "SUBS=", "SSUB|%02d|1|%d", quad, SIM_SUBSCRIBE_RATE_HZ);
+    }
+
+    int64_t joyNext  = startUs;
+    int64_t gnoiNext = startUs;
+    int64_t gdeiNext = startUs;
+    int64_t pidNext  = startUs;
+
+    while (running)
+    {
+        int64_t now = NativeShim_MicrosSinceBoot();
+        double  t   = (now - startUs) / 1e6;
+
+        if (enabled[STREAM_JOY] && driverIndex >= 0 && now >= joyNext)
+        {
+            // A slow sweep of both sticks
+            sendCommand(STREAM_JOY, driverIndex, driverIndex, "SPED|", "SPED|%.1f", 100.0 * sin(t * M_PI / 2.0));
+            sendCommand(STREAM_JOY, driverIndex, driverIndex, "ROTA|", "ROTA|%.1f", 45.0 * sin(t * M_PI / 3.0));
+            joyNext += SIM_JOY_PERIOD_US;
+        }
+        if (enabled[STREAM_QUERY] && now >= gnoiNext)
+        {
+            sendCommand(STREAM_QUERY, 0, 0, "NOINFO=", "GNOI");
+            gnoiNext += SIM_GNOI_PERIOD_US;
+        }
+        if (enabled[STREAM_QUERY] && now >= gdeiNext)
+        {
+            // Timed to the last Device's DEINFO, i.e. the whole answer
+            sendCommand(STREAM_QUERY, 0, lastDevice, "DEINFO=", "GDEI");
+            gdeiNext += SIM_GDEI_PERIOD_US;
+        }
+        if (enabled[STREAM_PID] && now >= pidNext)
+        {
+            // Rewrite the gains main.cpp configures, so the burst loads the
+            // command path without changing how the motors behave
+            for (int pid : pidIndexes)
+            {
+                sendCommand(STREAM_PID, pid, pid, "OK|", "SETP|0");
+                sendCommand(STREAM_PID, pid, pid, "OK|", "SETI|0");
+                sendCommand(STREAM_PID, pid, pid, "OK|", "SETD|0");
+            }
+            pidNext += SIM_PID_PERIOD_US;
+        }
+
+        expirePending(now);
+
+        int64_t next = now + 1000;
+        if (enabled[STREAM_JOY])   next = std::min(next, joyNext);
+        if (enabled[STREAM_QUERY]) next = std::min(next, std::min(gnoiNext, gdeiNext));
+        if (enabled[STREAM_PID])   next = std::min(next, pidNext);
+        sleepUntil(next);
+    }
+}
+
+// - - - - - - - - - - Control - - - - - - - - - - - - - -
+
+/**
+ * @brief A UDP socket on 127.0.0.1, any port. <addr> gets its address.
+ * @return the socket, -1 on error
+ */
+static int openUdp(struct sockaddr_in *addr)
+{
+    socklen_t      size = sizeof(*addr);
+    struct timeval poll = { 0, SIM_UDP_POLL_US };
+
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family      = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0)
+        return -1;
+    if (bind(sock, (struct sockaddr *)addr, size) != 0 ||
+        getsockname(sock, (struct sockaddr *)addr, &size) != 0 ||
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &poll, sizeof(poll)) != 0)
+    {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+/**
+ * @brief Open the loopback pair, each socket connected to the other,
+ *        and start both receive threads
+ */
+static bool startUdp()
+{
+    struct sockaddr_in nodeAddr, relayerAddr;
+
+    nodeSock    = openUdp(&nodeAddr);
+    relayerSock = openUdp(&relayerAddr);
+    if (nodeSock < 0 || relayerSock < 0 ||
+        connect(nodeSock, (struct sockaddr *)&relayerAddr, sizeof(relayerAddr)) != 0 ||
+        connect(relayerSock, (struct sockaddr *)&nodeAddr, sizeof(nodeAddr)) != 0)
+    {
+        perror("RelayerSim: UDP loopback");
+        if (nodeSock >= 0)    close(nodeSock);
+        if (relayerSock >= 0) close(relayerSock);
+        nodeSock = relayerSock = -1;
+        return false;
+    }
+
+    udpRunning      = true;
+    nodeReceiver    = std::thread(nodeReceiveThread);
+    relayerReceiver = std::thread(relayerReceiveThread);
+    return true;
+}
+
+static void stopUdp()
+{
+    udpRunning = false;
+    if (nodeReceiver.joinable())
+        nodeReceiver.join();
+    if (relayerReceiver.joinable())
+        relayerReceiver.join();
+    close(nodeSock);
+    close(relayerSock);
+    nodeSock = relayerSock = -1;
+}
+
+bool RelayerSim_Start(const char *streams)
+{
+    bool all = (strstr(streams, "all") != nullptr);
+    bool any = false;
+    for (int i = 0; i < NUM_STREAMS; i++)
+    {
+        enabled[i] = all || strstr(streams, streamNames[i]) != nullptr;
+        any |= enabled[i];
+    }
+    if (!any)
+        return false;
+
+    useUdp = (strstr(streams, "udp") != nullptr);
+    if (useUdp && !startUdp())
+        return false;
+
+    NativeShim_SetEspNowTxHook(useUdp ? onTransmitUdp : onTransmit, nullptr);
+    running = true;
+    traffic = std::thread(trafficThread);
+    return true;
+}
+
+static uint32_t percentile(const std::vector<uint32_t> &sorted, int pct)
+{
+    if (sorted.empty())
+        return 0;
+    size_t i = (sorted.size() * pct) / 100;
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+void RelayerSim_Stop(FILE *out)
+{
+    running = false;
+    if (traffic.joinable())
+        traffic.join();
+    NativeShim_SetEspNowTxHook(nullptr, nullptr);
+    if (useUdp)
+        stopUdp();   // after the hook is gone, so nothing sends on a closed socket
+    expirePending(NativeShim_MicrosSinceBoot());
+
+    std::lock_guard<std::mutex> lock(simLock);
+    double secs = (startUs > 0) ? (NativeShim_MicrosSinceBoot() - startUs) / 1e6 : 0.0;
+    if (secs <= 0.0)
+    {
+        fprintf(out, "RelayerSim: the Node never got past PING\n");
+        return;
+    }
+
+    fprintf(out, "\nRelayerSim: %.2f s over %s, Node sent %lu frames / %lu bytes (%.0f frames/s)\n",
+            secs, useUdp ? "UDP loopback" : "the in-process hook", framesIn, bytesIn, framesIn / secs);
+    fprintf(out, "  stream      sent  answered   lost  in-flight    min    p50    p90    p99    max  (us)\n");
+    for (int i = 0; i < NUM_STREAMS; i++)
+    {
+        if (!enabled[i])
+            continue;
+        StreamStats &s = stats[i];
+        std::vector<uint32_t> sorted(s.latencyUs);
+        std::sort(sorted.begin(), sorted.end());
+        unsigned long inFlight = s.sent - s.answered - s.lost;
+        fprintf(out, "  %-8s %7lu %9lu %6lu %10lu %6u %6u %6u %6u %6u\n",
+                streamNames[i], s.sent, s.answered, s.lost, inFlight,
+                sorted.empty() ? 0 : sorted.front(), percentile(sorted, 50),
+                percentile(sorted, 90), percentile(sorted, 99),
+                sorted.empty() ? 0 : sorted.back());
+    }
+    unsigned long sent = 0, lost = 0;
+    for (int i = 0; i < NUM_STREAMS; i++)
+    {
+        sent += stats[i].sent;
+        lost += stats[i].lost;
+    }
+    fprintf(out, "  lost %.2f%% of commands\n", sent > 0 ? 100.0 * lost / sent : 0.0);
+    fprintf(out, "  telemetry: %lu records, %.0f records/s, %.0f value bytes/s\n",
+            telemetryRecords, telemetryRecords / secs, telemetryBytes / secs);
+}
@@ -0,0 +1,68 @@
+/**
+ * @file RelayerSim.h
+ * @author Doug Fajardo
+ * @brief Host-side stand-in for the Relayer: replays command traffic into
+ *        the firmware and measures what comes back.
+ * @version 0.1
+ * @date 2025-08-22
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * The simulator sits on the ESP-NOW loopback (see NativeShim.h). It
+ * installs itself as the transmit hook, so it sees every frame exactly as
+ * Node::SendDataPacket() hands it to esp_now_send(), and it injects
+ * commands with NativeShim_EspNowDeliver(), so they go through the
+ * firmware's onCommandReceived() like radio traffic does on the target.
+ *
+ * That way nothing is copied or serialized between the two ends, so its
+ * latencies cover only the firmware's own time: the command path, Run(),
+ * the sender task. Add the "udp" option to put a UDP loopback pair on
+ * 127.0.0.1 between them instead: the hook writes each frame to the
+ * Node's socket, a thread on the Relayer's socket times it on arrival,
+ * and commands come in through a thread on the Node's socket (the
+ * stand-in for the WiFi task). The latencies then also include two
+ * trips through the kernel, with the frames as bytes on a real transport.
+ * Neither models the radio's airtime or losses.
+ *
+ * main() starts it when SMAC_RELAYER_SIM is set in the environment, to
+ * "all" or a comma separated list of streams, and optionally "udp":
+ *
+ *   joy   : Driver SPED and ROTA, each at 50 Hz (a slow joystick sweep)
+ *   query : GNOI every second, GDEI every 2 seconds
+ *   pid   : every 3 seconds, a burst of SETP/SETI/SETD to every *PID device
+ *   telem : once, periodic reports from every *PID device at 10 Hz (SRHZ,
+ *           ENPP) and a 20 Hz subscription to every *QUAD's speed (SSUB)
+ *   udp   : over UDP loopback, not the in-process hook
+ *
+ * Each command is matched to the first reply from the same device that
+ * starts with the prefix that command answers with (SPED|, ROTA|, OK|,
+ * NOINFO=, DEINFO=, RATEHZ=, PP Enabled, SUBS=). A command not answered
+ * within RELAYER_SIM_TIMEOUT_US counts as lost. Every other record (the
+ * telem stream's reports and subscriptions) is counted as telemetry. The report
+ * (latency percentiles per stream, loss, telemetry throughput) goes to
+ * stderr when main() stops the simulator.
+ *
+ * Run it for a fixed time, and keep the Debugging prints off the console:
+ *
+ *   SMAC_RELAYER_SIM=all SMAC_RUN_MS=10000 .pio/build/native/program > /dev/null
+ *   SMAC_RELAYER_SIM=all,udp SMAC_RUN_MS=10000 .pio/build/native/program > /dev/null
+ */
+#pragma once
+#include <stdio.h>
+
+#define RELAYER_SIM_TIMEOUT_US  500000  // A command with no reply by then is lost
+
+/**
+ * @brief Install the transmit hook and start the traffic thread.
+ *        Call before setup(), the simulator answers the Node's PING itself.
+ * @param streams "all", or a comma separated list of joy, query, pid, telem,
+ *                and "udp" for the UDP loopback
+ * @return false if no known stream was named, or the loopback failed
+ */
+bool RelayerSim_Start(const char *streams);
+
+/**
+ * @brief Stop sending, wait out the replies still in flight and print the
+ *        report to <out>.
+ */
+void RelayerSim_Stop(FILE *out);
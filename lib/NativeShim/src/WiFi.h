@@ -0,0 +1,22 @@
+/**
+ * @file WiFi.h
+ * @brief Native shim - just enough of WiFiClass for an ESP-NOW station.
+ */
+#pragma once
+#include "Arduino.h"
+
+typedef enum {
+    WIFI_OFF = 0,
+    WIFI_STA,
+    WIFI_AP,
+    WIFI_AP_STA,
+} wifi_mode_t;
+
+class WiFiClass
+{
+  public:
+    bool   mode(wifi_mode_t m) { (void)m; return true; }
+    String macAddress()        { return String("02:00:00:00:00:01"); }
+};
+
+extern WiFiClass WiFi;
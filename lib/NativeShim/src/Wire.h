@@ -0,0 +1,14 @@
+/**
+ * @file Wire.h
+ * @brief Native shim - there is no I2C bus on the host.
+ */
+#pragma once
+#include "Arduino.h"
+
+class TwoWire
+{
+  public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) { (void)sda; (void)scl; (void)frequency; return true; }
+};
+
+extern TwoWire Wire;
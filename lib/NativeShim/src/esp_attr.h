@@ -0,0 +1,8 @@
+/**
+ * @file esp_attr.h
+ * @brief Native shim - linker placement attributes are meaningless on the host.
+ */
+#pragma once
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_BSS_ATTR
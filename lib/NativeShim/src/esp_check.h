@@ -0,0 +1,6 @@
+/**
+ * @file esp_check.h
+ * @brief Native shim.
+ */
+#pragma once
+#include "esp_err.h"
@@ -0,0 +1,6 @@
+/**
+ * @file esp_log_buffer.h
+ * @brief Native shim.
+ */
+#pragma once
+#include "esp_log.h"
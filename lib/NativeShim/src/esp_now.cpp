@@ -0,0 +1,79 @@
+/**
+ * @file esp_now.cpp
+ * @author Doug Fajardo
+ * @brief Native shim - ESP-NOW loopback to a host-side transmit hook.
+ * @version 0.1
+ * @date 2025-08-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * With no hook installed, sends "succeed" and go nowhere, except that a
+ * Node's PING Data String ("nn|dd|timestamp|PING") is answered with PONG,
+ * so setup() gets past waiting for the Relayer on its own. The send
+ * callback (if registered) is called synchronously after the hook, which
+ * is close enough to the target where it arrives shortly after from the
+ * WiFi task.
+ */
+#include "esp_now.h"
+#include "NativeShim.h"
+#include <mutex>
+#include <string.h>
+
+static bool              initialized = false;
+static esp_now_recv_cb_t recvCallback = nullptr;
+static esp_now_send_cb_t sendCallback = nullptr;
+static NativeShim_TxHook txHook       = nullptr;
+static void             *txHookCtx    = nullptr;
+static std::mutex        radioLock;   // the 'radio' handles one frame at a time
+
+esp_err_t esp_now_init()                                { initialized = true;  return ESP_OK; }
+esp_err_t esp_now_deinit()                              { initialized = false; return ESP_OK; }
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *) { return initialized ? ESP_OK : ESP_ERR_ESPNOW_NOT_INIT; }
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb) { recvCallback = cb; return ESP_OK; }
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb) { sendCallback = cb; return ESP_OK; }
+
+esp_err_t esp_now_send(const uint8_t *peer_addr, const uint8_t *data, size_t len)
+{
+    if (!initialized)                    return ESP_ERR_ESPNOW_NOT_INIT;
+    if (len == 0 || len > ESP_NOW_MAX_DATA_LEN) return ESP_ERR_ESPNOW_ARG;
+
+    bool delivered = true;
+    bool answerPing = false;
+    {
+        std::lock_guard<std::mutex> lock(radioLock);
+        if (txHook != nullptr)
+            delivered = txHook(peer_addr, data, len, txHookCtx);
+        else
+            answerPing = (len >= 5 && memcmp(data + len - 5, "|PING", 5) == 0) ||
+                         (len >= 6 && memcmp(data + len - 6, "|PING", 6) == 0);   // with the NULL
+    }
+
+    if (sendCallback != nullptr)
+        sendCallback(peer_addr, delivered ? ESP_NOW_SEND_SUCCESS : ESP_NOW_SEND_FAIL);
+
+    if (answerPing)
+        NativeShim_EspNowDeliver(peer_addr, (const uint8_t *)"PONG", 5);
+    return ESP_OK;
+}
+
+void NativeShim_SetEspNowTxHook(NativeShim_TxHook hook, void *ctx)
+{
+    std::lock_guard<std::mutex> lock(radioLock);
+    txHook    = hook;
+    txHookCtx = ctx;
+}
+
+bool NativeShim_EspNowDeliver(const uint8_t *srcMac, const uint8_t *data, int len)
+{
+    if (recvCallback == nullptr || len <= 0 || len > ESP_NOW_MAX_DATA_LEN)
+        return false;
+
+    uint8_t             src[ESP_NOW_ETH_ALEN];
+    uint8_t             dst[ESP_NOW_ETH_ALEN] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+    wifi_pkt_rx_ctrl_t  rx = {};
+    esp_now_recv_info_t info = {src, dst, &rx};
+    memcpy(src, srcMac, ESP_NOW_ETH_ALEN);
+
+    recvCallback(&info, data, len);
+    return true;
+}
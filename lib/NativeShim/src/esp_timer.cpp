@@ -0,0 +1,160 @@
+/**
+ * @file esp_timer.cpp
+ * @author Doug Fajardo
+ * @brief Native shim - esp_timer implemented with one dispatcher thread.
+ * @version 0.1
+ * @date 2025-08-20
+ *
+ * @copyright Copyright (c) 2025
+ */
+#include "esp_timer.h"
+#include "NativeShim.h"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <chrono>
+
+struct esp_timer
+{
+    esp_timer_cb_t callback;
+    void          *arg;
+    const char    *name;
+    bool           active;
+    bool           periodic;
+    int64_t        period;   // uSecs (periodic only)
+    int64_t        alarm;    // uSecs since boot
+};
+
+static std::mutex               timerLock;
+static std::condition_variable  timerWake;
+static std::vector<esp_timer *> timers;
+static std::thread             *timerTask = nullptr;
+
+static void timerTaskLoop()
+{
+    std::unique_lock<std::mutex> lock(timerLock);
+    while (true)
+    {
+        // Find the earliest alarm
+        esp_timer *next = nullptr;
+        for (esp_timer *t : timers)
+        {
+            if (t->active && (next == nullptr || t->alarm < next->alarm))
+                next = t;
+        }
+
+        if (next == nullptr)
+        {
+            timerWake.wait(lock);
+            continue;
+        }
+
+        int64_t now = NativeShim_MicrosSinceBoot();
+        if (next->alarm > now)
+        {
+            timerWake.wait_for(lock, std::chrono::microseconds(next->alarm - now));
+            continue;
+        }
+
+        // Due - re-arm (or disarm) before dispatching
+        if (next->periodic)
+        {
+            next->alarm += next->period;
+            if (next->alarm < now) next->alarm = now + next->period;  // skip unhandled events
+        }
+        else
+            next->active = false;
+
+        esp_timer_cb_t cb  = next->callback;
+        void          *arg = next->arg;
+        lock.unlock();
+        cb(arg);
+        lock.lock();
+    }
+}
+
+int64_t esp_timer_get_time()
+{
+    return NativeShim_MicrosSinceBoot();
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle)
+{
+    if (args == nullptr || args->callback == nullptr || out_handle == nullptr)
+        return ESP_ERR_INVALID_ARG;
+
+    esp_timer *t = new esp_timer{args->callback, args->arg, args->name, false, false, 0, 0};
+    std::lock_guard<std::mutex> lock(timerLock);
+    timers.push_back(t);
+    if (timerTask == nullptr)
+    {
+        timerTask = new std::thread(timerTaskLoop);
+        timerTask->detach();
+    }
+    *out_handle = t;
+    return ESP_OK;
+}
+
+static esp_err_t arm(esp_timer_handle_t t, uint64_t us, bool periodic)
+{
+    if (t == nullptr) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> lock(timerLock);
+    t->active   = true;
+    t->periodic = periodic;
+    t->period   = (int64_t)us;
+    t->alarm    = NativeShim_MicrosSinceBoot() + (int64_t)us;
+    timerWake.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t timeout_us)
+{
+    if (t != nullptr && t->active) return ESP_ERR_INVALID_STATE;
+    return arm(t, timeout_us, false);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t t, uint64_t period)
+{
+    if (t != nullptr && t->active) return ESP_ERR_INVALID_STATE;
+    return arm(t, period, true);
+}
+
+esp_err_t esp_timer_restart(esp_timer_handle_t t, uint64_t timeout_us)
+{
+    if (t == nullptr || !t->active) return ESP_ERR_INVALID_STATE;
+    return arm(t, timeout_us, t->periodic);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t t)
+{
+    if (t == nullptr) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> lock(timerLock);
+    if (!t->active) return ESP_ERR_INVALID_STATE;
+    t->active = false;
+    timerWake.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t t)
+{
+    if (t == nullptr) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::mutex> lock(timerLock);
+    for (size_t i = 0; i < timers.size(); i++)
+    {
+        if (timers[i] == t)
+        {
+            timers.erase(timers.begin() + i);
+            break;
+        }
+    }
+    delete t;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t t)
+{
+    if (t == nullptr) return false;
+    std::lock_guard<std::mutex> lock(timerLock);
+    return t->active;
+}
@@ -0,0 +1,327 @@
+/**
+ * @file freertos.cpp
+ * @author Doug Fajardo
+ * @brief Native shim - FreeRTOS tasks, notifications, queues and
+ *        semaphores built on host threads.
+ * @version 0.1
+ * @date 2025-08-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * Priorities and core affinity are recorded but not enforced - the host
+ * scheduler decides. Everything that blocks (delays, notifications, queue
+ * and semaphore waits) is built on a mutex + condition variable so that
+ * xTaskAbortDelay() and the 'give' side can wake the waiter early.
+ */
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "NativeShim.h"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct tskTaskControlBlock
+{
+    std::mutex              lock;
+    std::condition_variable wake;
+    uint32_t                notifyCount = 0;
+    bool                    abortDelay  = false;
+    UBaseType_t             priority    = 1;
+    BaseType_t              coreId      = tskNO_AFFINITY;
+    uint32_t                stackDepth  = 0;
+};
+
+static thread_local tskTaskControlBlock *currentTask = nullptr;
+
+// Block the calling task until 'done' returns true or the timeout expires.
+// Returns the final value of done().
+template <typename Pred>
+static bool waitFor(std::unique_lock<std::mutex> &lock, std::condition_variable &cv, TickType_t ticks, Pred done)
+{
+    if (ticks == portMAX_DELAY)
+    {
+        cv.wait(lock, done);
+        return true;
+    }
+    return cv.wait_for(lock, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), done);
+}
+
+//=========================================================
+//  Tasks
+//=========================================================
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    if (currentTask == nullptr)
+        currentTask = new tskTaskControlBlock;   // e.g. the Arduino loop task (main thread)
+    return currentTask;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *created, BaseType_t coreId)
+{
+    (void)name;
+    tskTaskControlBlock *tcb = new tskTaskControlBlock;
+    tcb->priority   = priority;
+    tcb->coreId     = coreId;
+    tcb->stackDepth = stackDepth;
+    if (created != nullptr)
+        *created = tcb;
+
+    std::thread([fn, arg, tcb]() {
+        currentTask = tcb;
+        fn(arg);
+    }).detach();
+
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth,
+                       void *arg, UBaseType_t priority, TaskHandle_t *created)
+{
+    return xTaskCreatePinnedToCore(fn, name, stackDepth, arg, priority, created, tskNO_AFFINITY);
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    // Host threads have their own (large) stacks - report the whole ESP32 stack as free
+    tskTaskControlBlock *tcb = (task != nullptr) ? task : (tskTaskControlBlock *)xTaskGetCurrentTaskHandle();
+    return tcb->stackDepth;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    // A host thread cannot be killed from outside; tasks that delete
+    // themselves just stop here.
+    if (task == nullptr || task == currentTask)
+    {
+        while (true)
+            std::this_thread::sleep_for(std::chrono::hours(1));
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    tskTaskControlBlock *me = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(me->lock);
+    waitFor(lock, me->wake, ticks, [me]() { return me->abortDelay; });
+    me->abortDelay = false;
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *previousWakeTime, TickType_t increment)
+{
+    TickType_t wakeAt = *previousWakeTime + increment;
+    TickType_t now    = xTaskGetTickCount();
+    *previousWakeTime = wakeAt;
+    if ((int32_t)(wakeAt - now) <= 0)
+        return pdFALSE;
+    vTaskDelay(wakeAt - now);
+    return pdTRUE;
+}
+
+BaseType_t xTaskAbortDelay(TaskHandle_t task)
+{
+    if (task == nullptr) return pdFAIL;
+    std::lock_guard<std::mutex> lock(task->lock);
+    task->abortDelay = true;
+    task->wake.notify_all();
+    return pdPASS;
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return (TickType_t)(NativeShim_MicrosSinceBoot() / (1000 * portTICK_PERIOD_MS));
+}
+
+BaseType_t xPortGetCoreID()
+{
+    tskTaskControlBlock *me = xTaskGetCurrentTaskHandle();
+    return (me->coreId == tskNO_AFFINITY) ? 1 : me->coreId;
+}
+
+void taskYIELD()
+{
+    std::this_thread::yield();
+}
+
+//--- Direct-to-task notifications ------------------------
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    // ESP-IDF has configASSERT(xTaskToNotify) here, so do not let host runs hide it
+    if (task == nullptr)
+    {
+        fprintf(stderr, "xTaskNotifyGive: NULL task handle\n");
+        abort();
+    }
+    std::lock_guard<std::mutex> lock(task->lock);
+    task->notifyCount++;
+    task->wake.notify_all();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higherPriorityTaskWoken)
+{
+    xTaskNotifyGive(task);
+    if (higherPriorityTaskWoken != nullptr)
+        *higherPriorityTaskWoken = pdFALSE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait)
+{
+    tskTaskControlBlock *me = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(me->lock);
+    waitFor(lock, me->wake, ticksToWait, [me]() { return me->notifyCount > 0 || me->abortDelay; });
+    me->abortDelay = false;
+
+    uint32_t count = me->notifyCount;
+    if (count > 0)
+        me->notifyCount = clearCountOnExit ? 0 : count - 1;
+    return count;
+}
+
+//=========================================================
+//  Queues
+//=========================================================
+
+struct QueueDefinition
+{
+    std::mutex              lock;
+    std::condition_variable changed;
+    std::vector<uint8_t>    storage;
+    UBaseType_t             length;
+    UBaseType_t             itemSize;
+    UBaseType_t             head  = 0;
+    UBaseType_t             count = 0;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    QueueDefinition *q = new QueueDefinition;
+    q->length   = length;
+    q->itemSize = itemSize;
+    q->storage.resize((size_t)length * itemSize);
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticksToWait)
+{
+    std::unique_lock<std::mutex> lock(q->lock);
+    if (!waitFor(lock, q->changed, ticksToWait, [q]() { return q->count < q->length; }))
+        return pdFAIL;
+
+    UBaseType_t tail = (q->head + q->count) % q->length;
+    memcpy(q->storage.data() + (size_t)tail * q->itemSize, item, q->itemSize);
+    q->count++;
+    q->changed.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t q, const void *item, TickType_t ticksToWait)
+{
+    return xQueueSend(q, item, ticksToWait);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *higherPriorityTaskWoken)
+{
+    if (higherPriorityTaskWoken != nullptr)
+        *higherPriorityTaskWoken = pdFALSE;
+    return xQueueSend(q, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticksToWait)
+{
+    std::unique_lock<std::mutex> lock(q->lock);
+    if (!waitFor(lock, q->changed, ticksToWait, [q]() { return q->count > 0; }))
+        return pdFAIL;
+
+    memcpy(item, q->storage.data() + (size_t)q->head * q->itemSize, q->itemSize);
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    q->changed.notify_all();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    std::lock_guard<std::mutex> lock(q->lock);
+    return q->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q)
+{
+    std::lock_guard<std::mutex> lock(q->lock);
+    return q->length - q->count;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    delete q;
+}
+
+//=========================================================
+//  Semaphores (a mutex is a binary semaphore that starts 'given')
+//=========================================================
+
+struct SemaphoreDefinition
+{
+    std::mutex              lock;
+    std::condition_variable changed;
+    UBaseType_t             count;
+    UBaseType_t             maxCount;
+};
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount)
+{
+    SemaphoreDefinition *s = new SemaphoreDefinition;
+    s->count    = initialCount;
+    s->maxCount = maxCount;
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()  { return xSemaphoreCreateCounting(1, 1); }
+SemaphoreHandle_t xSemaphoreCreateBinary() { return xSemaphoreCreateCounting(1, 0); }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticksToWait)
+{
+    std::unique_lock<std::mutex> lock(s->lock);
+    if (!waitFor(lock, s->changed, ticksToWait, [s]() { return s->count > 0; }))
+        return pdFAIL;
+    s->count--;
+    return pdPASS;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    std::lock_guard<std::mutex> lock(s->lock);
+    if (s->count >= s->maxCount)
+        return pdFAIL;
+    s->count++;
+    s->changed.notify_one();
+    return pdPASS;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t s, BaseType_t *higherPriorityTaskWoken)
+{
+    if (higherPriorityTaskWoken != nullptr)
+        *higherPriorityTaskWoken = pdFALSE;
+    return xSemaphoreGive(s);
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t s)
+{
+    std::lock_guard<std::mutex> lock(s->lock);
+    return s->count;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t s)
+{
+    delete s;
+}
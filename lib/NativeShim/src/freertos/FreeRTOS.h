@@ -0,0 +1,53 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Native shim - the FreeRTOS types/macros used by the firmware.
+ *
+ * Tasks are host threads, ticks are milliseconds (configTICK_RATE_HZ=1000)
+ * and port spinlocks are plain host spinlocks.
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int          BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t     TickType_t;
+typedef uint32_t     StackType_t;
+
+#define pdFALSE  ((BaseType_t)0)
+#define pdTRUE   ((BaseType_t)1)
+#define pdFAIL   pdFALSE
+#define pdPASS   pdTRUE
+
+#define configTICK_RATE_HZ     1000
+#define portTICK_PERIOD_MS     ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY          ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms)      ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+#define tskNO_AFFINITY         ((BaseType_t)0x7FFFFFFF)
+#define portNUM_PROCESSORS     2
+
+typedef struct {
+    volatile int lock;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED  {0}
+
+static inline void vPortEnterCritical(portMUX_TYPE *mux)
+{
+    while (__atomic_exchange_n(&mux->lock, 1, __ATOMIC_ACQUIRE)) { }
+}
+
+static inline void vPortExitCritical(portMUX_TYPE *mux)
+{
+    __atomic_store_n(&mux->lock, 0, __ATOMIC_RELEASE);
+}
+
+#define portENTER_CRITICAL(mux)         vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux)          vPortExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux)     vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux)      vPortExitCritical(mux)
+#define taskENTER_CRITICAL(mux)         vPortEnterCritical(mux)
+#define taskEXIT_CRITICAL(mux)          vPortExitCritical(mux)
+#define taskENTER_CRITICAL_ISR(mux)     vPortEnterCritical(mux)
+#define taskEXIT_CRITICAL_ISR(mux)      vPortExitCritical(mux)
+#define portYIELD_FROM_ISR(x)           do { (void)(x); } while (0)
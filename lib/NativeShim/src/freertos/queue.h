@@ -0,0 +1,17 @@
+/**
+ * @file queue.h
+ * @brief Native shim - FreeRTOS queues (copy-by-value, fixed item size).
+ */
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef struct QueueDefinition *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t    xQueueSend(QueueHandle_t q, const void *item, TickType_t ticksToWait);
+BaseType_t    xQueueSendToBack(QueueHandle_t q, const void *item, TickType_t ticksToWait);
+BaseType_t    xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *higherPriorityTaskWoken);
+BaseType_t    xQueueReceive(QueueHandle_t q, void *item, TickType_t ticksToWait);
+UBaseType_t   uxQueueMessagesWaiting(QueueHandle_t q);
+UBaseType_t   uxQueueSpacesAvailable(QueueHandle_t q);
+void          vQueueDelete(QueueHandle_t q);
@@ -0,0 +1,19 @@
+/**
+ * @file semphr.h
+ * @brief Native shim - FreeRTOS semaphores/mutexes.
+ */
+#pragma once
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+typedef struct SemaphoreDefinition *SemaphoreHandle_t;
+typedef SemaphoreHandle_t xSemaphoreHandle;   // pre-v8 name still used by the firmware
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateBinary();
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticksToWait);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t sem);
+BaseType_t        xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *higherPriorityTaskWoken);
+UBaseType_t       uxSemaphoreGetCount(SemaphoreHandle_t sem);
+void              vSemaphoreDelete(SemaphoreHandle_t sem);
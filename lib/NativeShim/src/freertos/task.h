@@ -0,0 +1,27 @@
+/**
+ * @file task.h
+ * @brief Native shim - FreeRTOS tasks and direct-to-task notifications.
+ */
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+typedef struct tskTaskControlBlock *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t  xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth,
+                                    void *arg, UBaseType_t priority, TaskHandle_t *created, BaseType_t coreId);
+BaseType_t  xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth,
+                        void *arg, UBaseType_t priority, TaskHandle_t *created);
+void        vTaskDelete(TaskHandle_t task);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+void        vTaskDelay(TickType_t ticks);
+BaseType_t  xTaskDelayUntil(TickType_t *previousWakeTime, TickType_t increment);
+BaseType_t  xTaskAbortDelay(TaskHandle_t task);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+TickType_t  xTaskGetTickCount();
+BaseType_t  xPortGetCoreID();
+void        taskYIELD();
+
+BaseType_t  xTaskNotifyGive(TaskHandle_t task);
+void        vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higherPriorityTaskWoken);
+uint32_t    ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait);
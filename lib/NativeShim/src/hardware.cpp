@@ -0,0 +1,80 @@
+/**
+ * @file hardware.cpp
+ * @author Doug Fajardo
+ * @brief Native shim - GPIO, LEDC, I2C and encoder stand-ins.
+ * @version 0.1
+ * @date 2025-08-20
+ *
+ * @copyright Copyright (c) 2025
+ */
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "Wire.h"
+#include "ESP32Encoder.h"
+
+TwoWire Wire;
+puType  ESP32Encoder::useInternalWeakPullResistors = up;
+
+static uint32_t gpioLevels[GPIO_NUM_MAX];
+static uint32_t ledcDuty[LEDC_CHANNEL_MAX];
+static uint32_t ledcPendingDuty[LEDC_CHANNEL_MAX];
+
+esp_err_t gpio_config(const gpio_config_t *cfg)
+{
+    return (cfg == nullptr) ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) return ESP_ERR_INVALID_ARG;
+    gpioLevels[gpio_num] = level ? 1 : 0;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) return 0;
+    return (int)gpioLevels[gpio_num];
+}
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *timer_conf)
+{
+    return (timer_conf == nullptr) ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *conf)
+{
+    if (conf == nullptr || conf->channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+    ledcDuty[conf->channel] = ledcPendingDuty[conf->channel] = conf->duty;
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty)
+{
+    (void)speed_mode;
+    if (channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+    ledcPendingDuty[channel] = duty;
+    return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    (void)speed_mode;
+    if (channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+    ledcDuty[channel] = ledcPendingDuty[channel];
+    return ESP_OK;
+}
+
+uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    (void)speed_mode;
+    return (channel < LEDC_CHANNEL_MAX) ? ledcDuty[channel] : 0;
+}
+
+esp_err_t ledc_stop(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t idle_level)
+{
+    (void)speed_mode; (void)idle_level;
+    if (channel >= LEDC_CHANNEL_MAX) return ESP_ERR_INVALID_ARG;
+    ledcDuty[channel] = ledcPendingDuty[channel] = 0;
+    return ESP_OK;
+}
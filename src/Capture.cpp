@@ -0,0 +1,265 @@
+/**
+ * @file Capture.cpp
+ * @author Doug Fajardo
+ * @brief Record both wheels at the control tick rate, for download afterwards
+ * @version 0.1
+ * @date 2025-09-18
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * See Capture.h
+ */
+#include <Arduino.h>
+#include "config.h"
+#include "Capture.h"
+
+static_assert(sizeof(Capture::Record) == CAPTURE_RECORD_SIZE, "Capture::Record must match the download layout");
+
+static const char base64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - -
+Capture::Capture()
+{
+    ring = nullptr;
+    capacity = 0;
+    inPsram = false;
+    trigger = TRIGGER_NOW;
+    divider = 1;
+    preSamples = 0;
+    postSamples = 0;
+    written = 0;
+    triggeredAt = 0;
+    triggerUs = 0;
+    tickCount = 0;
+    state = CAPTURE_IDLE;
+    triggerRequested = false;
+    stopRequested = false;
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - -
+Capture::~Capture()
+{
+    return;
+}
+
+
+/**
+ * @brief Get the ring: in PSRAM if the board has it, else a smaller one in internal RAM
+ * @return false if there is no memory for it
+ */
+bool Capture::allocate()
+{
+    if (ring != nullptr) return(true);
+
+#ifdef BOARD_HAS_PSRAM
+    if (psramFound())
+    {
+        ring = (Record *)ps_malloc(CAPTURE_PSRAM_BYTES);
+        if (ring != nullptr)
+        {
+            capacity = CAPTURE_PSRAM_BYTES / sizeof(Record);
+            inPsram = true;
+        }
+    }
+#endif
+    if (ring == nullptr)
+    {
+        ring = (Record *)malloc(CAPTURE_SRAM_BYTES);
+        capacity = (ring != nullptr) ? CAPTURE_SRAM_BYTES / sizeof(Record) : 0;
+    }
+    return(ring != nullptr);
+}
+
+
+/**
+ * @brief Start a capture (the records of the last one are dropped)
+ *
+ * @param _trigger  - TRIGGER_NOW, or TRIGGER_MOTION for the next motion command
+ * @param _divider  - record one sample every <_divider> control ticks
+ * @param pre       - samples to keep from before the trigger (0 for TRIGGER_NOW)
+ * @param post      - samples to take from the trigger on
+ * @return false if a capture is in progress, or the numbers do not fit the ring
+ */
+bool Capture::arm(Trigger _trigger, uint32_t _divider, uint32_t pre, uint32_t post)
+{
+    int now = state.load(std::memory_order_acquire);
+    if ((now == CAPTURE_ARMED) || (now == CAPTURE_RUNNING)) return(false);
+    if ((ring == nullptr) || (_divider < 1) || (post < 1)) return(false);
+    if (_trigger == TRIGGER_NOW) pre = 0;
+    if ((uint64_t)pre + post > capacity) return(false);
+
+    trigger     = _trigger;
+    divider     = _divider;
+    preSamples  = pre;
+    postSamples = post;
+    written     = 0;
+    triggeredAt = 0;
+    triggerUs   = 0;
+    tickCount   = _divider - 1;   // the first tick after arming is sampled
+    stopRequested    = false;
+    triggerRequested = (_trigger == TRIGGER_NOW);
+    state.store(CAPTURE_ARMED, std::memory_order_release);
+    return(true);
+}
+
+
+/**
+ * @brief A motion command came: trigger a capture waiting for one
+ */
+void Capture::triggerOnMotion()
+{
+    if ((trigger == TRIGGER_MOTION) && (state.load(std::memory_order_acquire) == CAPTURE_ARMED))
+    {
+        triggerRequested = true;
+    }
+}
+
+
+/**
+ * @brief Finish the capture at the next sample, keeping what was recorded
+ *    (Stopped before its trigger, it keeps the latest pre-trigger samples.)
+ */
+void Capture::stop()
+{
+    int now = state.load(std::memory_order_acquire);
+    if ((now == CAPTURE_ARMED) || (now == CAPTURE_RUNNING))
+    {
+        stopRequested = true;
+    }
+}
+
+
+/**
+ * @brief Is this control tick to be recorded? (control loop task)
+ */
+bool Capture::sampleDue()
+{
+    int now = state.load(std::memory_order_acquire);
+    if ((now != CAPTURE_ARMED) && (now != CAPTURE_RUNNING)) return(false);
+
+    if (++tickCount < divider) return(false);
+    tickCount = 0;
+    return(true);
+}
+
+
+/**
+ * @brief Add one sample (control loop task, after sampleDue())
+ */
+void Capture::add(const Record &rec)
+{
+    int now = state.load(std::memory_order_acquire);
+
+    if ((now == CAPTURE_ARMED) && triggerRequested.exchange(false))
+    {
+        triggeredAt = written;
+        triggerUs   = rec.timeUs;
+        now = CAPTURE_RUNNING;
+    }
+
+    ring[written % capacity] = rec;
+    written++;
+
+    if (stopRequested.exchange(false))
+    {
+        if (now == CAPTURE_ARMED)
+        {
+            triggeredAt = written;   // no trigger: keep the latest pre-trigger samples
+            triggerUs   = rec.timeUs;
+        }
+        now = CAPTURE_DONE;
+    }
+    else if ((now == CAPTURE_RUNNING) && (written - triggeredAt >= postSamples))
+    {
+        now = CAPTURE_DONE;
+    }
+    state.store(now, std::memory_order_release);
+}
+
+
+/**
+ * @brief Unwrapped ring index of the first record to download:
+ *    <preSamples> before the trigger, if the ring still has them
+ */
+uint32_t Capture::firstRecord()
+{
+    uint32_t oldest = (written > capacity) ? written - capacity : 0;
+    uint32_t wanted = (triggeredAt > preSamples) ? triggeredAt - preSamples : 0;
+    return((wanted > oldest) ? wanted : oldest);
+}
+
+
+/**
+ * @brief Where the capture is (any task)
+ *    Counts are final once the state is CAPTURE_DONE.
+ */
+Capture::Status Capture::getStatus()
+{
+    Status st;
+    st.state    = (State)state.load(std::memory_order_acquire);
+    st.divider  = divider;
+    st.capacity = capacity;
+    if (st.state == CAPTURE_DONE)
+    {
+        uint32_t first  = firstRecord();
+        st.records      = written - first;
+        st.triggerIndex = triggeredAt - first;
+        st.triggerUs    = triggerUs;
+    } else {
+        uint32_t so_far = written;
+        st.records      = (so_far < capacity) ? so_far : capacity;
+        st.triggerIndex = 0;
+        st.triggerUs    = 0;
+    }
+    return(st);
+}
+
+
+/**
+ * @brief Copy finished records, in time order
+ *
+ * @param index      - first record to copy (0 = the oldest kept)
+ * @param out        - where to put them
+ * @param maxRecords - room in <out>
+ * @return records copied (0 past the end), -1 if the capture is not done
+ */
+int Capture::read(uint32_t index, Record *out, int maxRecords)
+{
+    if (state.load(std::memory_order_acquire) != CAPTURE_DONE) return(-1);
+
+    uint32_t first = firstRecord();
+    uint32_t total = written - first;
+    int copied = 0;
+
+    while ((index + copied < total) && (copied < maxRecords))
+    {
+        out[copied] = ring[(first + index + copied) % capacity];
+        copied++;
+    }
+    return(copied);
+}
+
+
+/**
+ * @brief Base64 (RFC 4648, with padding) of <length> bytes, NULL terminated
+ *    Chunks of records go out in text replies this way.
+ * @return chars written, not counting the NULL
+ */
+int Capture::encodeBase64(const uint8_t *data, int length, char *text)
+{
+    int out = 0;
+    for (int i = 0; i < length; i += 3)
+    {
+        uint32_t bits = (uint32_t)data[i] << 16;
+        if (i + 1 < length) bits |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < length) bits |= data[i + 2];
+
+        text[out++] = base64Chars[(bits >> 18) & 0x3F];
+        text[out++] = base64Chars[(bits >> 12) & 0x3F];
+        text[out++] = (i + 1 < length) ? base64Chars[(bits >> 6) & 0x3F] : '=';
+        text[out++] = (i + 2 < length) ? base64Chars[bits & 0x3F] : '=';
+    }
+    text[out] = 0;
+    return(out);
+}
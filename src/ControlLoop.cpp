@@ -0,0 +1,238 @@
+/**
+ * @file ControlLoop.cpp
+ * @author Doug Fajardo
+ * @brief One clock for the speed checks, PIDs and motor outputs of all the wheels
+ * @version 0.1
+ * @date 2025-09-10
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * See ControlLoop.h
+ */
+#include "ControlLoop.h"
+#include "esp_err.h"
+#include <math.h>
+
+static_assert(MAX_CONTROL_WHEELS <= 2, "Capture::Record holds two wheels");
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - -
+ControlLoop::ControlLoop()
+{
+    wheelCount = 0;
+    tickTimerhandle = nullptr;
+    appliedWrites = 0;
+    lastTickUs = 0;
+    stats = {};
+    resetRequested = false;
+    periodUs.write(1000000 / CONTROL_RATE_HZ);
+}
+
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - -
+ControlLoop::~ControlLoop()
+{
+    return;
+}
+
+
+/**
+ * @brief Add a wheel to the loop, and stop its own speed and PID timers
+ *
+ * @param quad  - the wheel's quadrature decoder
+ * @param pid   - the wheel's PID (it drives the wheel's ln298)
+ * @param ln298 - the wheel's motor driver (only read, for captures)
+ * @return false if there is no room for another wheel
+ */
+bool ControlLoop::addWheel(DEV_QuadDecoder *quad, DEV_Pid *pid, DEV_LN298 *ln298)
+{
+    if (wheelCount >= MAX_CONTROL_WHEELS) return(false);
+
+    quad->clockFromControlLoop();
+    pid->clockFromControlLoop();
+    wheels[wheelCount] = {quad, pid, ln298};
+    wheelCount++;
+    return(true);
+}
+
+
+/**
+ * @brief Start ticking
+ *
+ * @param rateHz - ticks per second (CONTROL_RATE_MIN_HZ .. CONTROL_RATE_MAX_HZ)
+ */
+void ControlLoop::start(uint32_t rateHz)
+{
+    esp_timer_create_args_t tick_timer_args =
+        {
+            .callback = &tick_cb,              //!< Callback function to execute when timer expires
+            .arg = this,                       //!< Argument to pass to callback
+            .dispatch_method = ESP_TIMER_TASK, //!< Dispatch callback from task or ISR; if not specified, esp_timer task
+                                               //!< is used; for ISR to work, also set Kconfig option
+                                               //!< `CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD`
+            .name = "ControlTick",             //!< Timer name, used in esp_timer_dump() function
+            .skip_unhandled_events = true      //!< Setting to skip unhandled events in light sleep for periodic timers
+        };
+
+    if (capture.allocate())
+    {
+        Serial.printf("... Control loop: captures up to %lu records, in %s\n\r",
+                      (unsigned long)capture.getStatus().capacity, capture.isInPsram() ? "PSRAM" : "internal RAM");
+    } else {
+        Serial.println("... Control loop: no memory for captures");
+    }
+    ESP_ERROR_CHECK(esp_timer_create(&tick_timer_args, &tickTimerhandle));
+    if (!setRate(rateHz))
+    {
+        setRate(CONTROL_RATE_HZ);
+    }
+    Serial.printf("... Control loop: %d wheels at %lu Hz\n\r", wheelCount, (unsigned long)getRate());
+    return;
+}
+
+
+/**
+ * @brief Change the tick rate
+ *    The new period starts now; the wheels pick it up on the next tick.
+ *
+ * @param rateHz - ticks per second (CONTROL_RATE_MIN_HZ .. CONTROL_RATE_MAX_HZ)
+ * @return false if the rate is out of range (nothing changed)
+ */
+bool ControlLoop::setRate(uint32_t rateHz)
+{
+    if ((rateHz < CONTROL_RATE_MIN_HZ) || (rateHz > CONTROL_RATE_MAX_HZ)) return(false);
+
+    uint32_t newPeriodUs = 1000000 / rateHz;
+    periodUs.write(newPeriodUs);
+
+    if (esp_timer_is_active(tickTimerhandle))
+    {
+        ESP_ERROR_CHECK(esp_timer_restart(tickTimerhandle, newPeriodUs));
+    } else {
+        ESP_ERROR_CHECK(esp_timer_start_periodic(tickTimerhandle, newPeriodUs));
+    }
+    return(true);
+}
+
+
+/**
+ * @brief Current rate, in ticks per second
+ */
+uint32_t ControlLoop::getRate()
+{
+    return(1000000 / periodUs.read());
+}
+
+
+/**
+ * @brief Current period, in uSecs
+ */
+uint32_t ControlLoop::getPeriodUs()
+{
+    return(periodUs.read());
+}
+
+
+/**
+ * @brief A consistent copy of the tick statistics
+ */
+ControlLoop::TickStats ControlLoop::getStats()
+{
+    return(published.read());
+}
+
+
+/**
+ * @brief Clear the tick statistics (at the next tick)
+ */
+void ControlLoop::resetStats()
+{
+    resetRequested = true;
+}
+
+
+/**
+ * @brief Timer callback (esp_timer task)
+ * @param arg - pointer to the ControlLoop instance
+ */
+void ControlLoop::tick_cb(void *arg)
+{
+    ((ControlLoop *)arg)->tick();
+}
+
+
+/**
+ * @brief One control tick: sample, speed, PID, output - for all wheels
+ *   Each step is done for every wheel before the next step starts.
+ */
+void ControlLoop::tick()
+{
+    time_t   now = esp_timer_get_time();
+    uint32_t writes = periodUs.writes();   // before read(): a newer period is applied next tick
+    uint32_t period = periodUs.read();
+    bool     computed[MAX_CONTROL_WHEELS];
+
+    // A new rate: the PID sample time follows it, the tick interval restarts
+    if (writes != appliedWrites)
+    {
+        appliedWrites = writes;
+        for (int i = 0; i < wheelCount; i++)
+        {
+            wheels[i].quad->setLoopPeriod(period);
+            wheels[i].pid->setLoopPeriod(period);
+        }
+        lastTickUs = 0;
+    }
+
+    // (1) Both counts at the same instant
+    for (int i = 0; i < wheelCount; i++)
+        wheels[i].quad->sampleCount(now);
+
+    // (2) Speeds
+    for (int i = 0; i < wheelCount; i++)
+        wheels[i].quad->updateSpeed();
+
+    // (3) PIDs
+    for (int i = 0; i < wheelCount; i++)
+        computed[i] = wheels[i].pid->computeOutput();
+
+    // (4) Motor duties
+    for (int i = 0; i < wheelCount; i++)
+        if (computed[i]) wheels[i].pid->applyOutput();
+
+    if (capture.sampleDue()) captureTick(now);
+
+    // Statistics
+    if (resetRequested.exchange(false))
+    {
+        stats = {};
+    }
+    uint32_t runUs = (uint32_t)(esp_timer_get_time() - now);
+    stats.ticks++;
+    stats.lastRunUs = runUs;
+    if (runUs > stats.maxRunUs) stats.maxRunUs = runUs;
+    if (runUs > period) stats.overruns++;
+    if (lastTickUs != 0)
+    {
+        uint32_t jitter = (uint32_t)llabs((now - lastTickUs) - (time_t)period);
+        if (jitter > stats.maxJitterUs) stats.maxJitterUs = jitter;
+    }
+    lastTickUs = now;
+    published.write(stats);
+}
+
+
+/**
+ * @brief Record this tick's counts, duties and PID outputs (see Capture.h)
+ */
+void ControlLoop::captureTick(time_t now)
+{
+    Capture::Record rec = {};
+    rec.timeUs = (uint32_t)now;
+    for (int i = 0; i < wheelCount; i++)
+    {
+        rec.count[i]  = (int32_t)wheels[i].quad->getSampledCount();
+        rec.duty[i]   = (int16_t)wheels[i].ln298->getPulseWidth();
+        rec.output[i] = (int16_t)lround(wheels[i].pid->output * 100);
+    }
+    capture.add(rec);
+}
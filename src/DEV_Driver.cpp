@@ -9,7 +9,9 @@
  * 
  * This sets up - and controls - two wheels. Feedback
  * thru the PID class is used to govern the actual 
- * power applied to each wheel.
+ * power applied to each wheel. One control loop (see
+ * ControlLoop.h) clocks both wheels' speed checks, PIDs
+ * and motor outputs.
  */
 #include "Node.h"
 #include "config.h"
@@ -28,9 +30,11 @@ DEV_Driver::DEV_Driver( const char *_name, Node *_myNode) : DefDevice(_name)
     nextMotorIdx=0;   
     mySpeed=0;
     myDirect=0; 
+    control=nullptr;
     // SetID(devid);  // TBD: Do I need this?
     Serial.print(" ");
     periodicEnabled=false; // Start with NO periodic reports
+    immediateEnabled=false; // Nothing to do continuously
 }
 
 
@@ -57,6 +61,12 @@ void DEV_Driver::setup(MotorControl_config_t *left_cfg, MotorControl_config_t *r
     rightMtr = new DEV_MotorControl("rightMotor", myNode);
     rightMtr->setup(right_cfg, "right_");
     myNode->AddDevice(rightMtr);
+
+    // Both wheels on one tick, instead of each quad's and PID's own timer
+    control = new ControlLoop();
+    control->addWheel(leftMtr->myQuadDecoder,  leftMtr->piddev,  leftMtr->ln298);
+    control->addWheel(rightMtr->myQuadDecoder, rightMtr->piddev, rightMtr->ln298);
+    control->start(CONTROL_RATE_HZ);
     periodicEnabled = false; 
 }
 
@@ -67,7 +77,7 @@ void DEV_Driver::setup(MotorControl_config_t *left_cfg, MotorControl_config_t *r
 //     current positionm current direction, current (average)speed over ground
 //  
 // - - - - - - - - - - - - - - - - - - - - - - - - - - 
-ProcessStatus DEV_Driver::DoPeriodic()
+ProcessStatus DEV_Driver::DoPeriodic(DPacket &packet)
 {
     // TODO:
     return(SUCCESS_NODATA);
@@ -75,17 +85,17 @@ ProcessStatus DEV_Driver::DoPeriodic()
 
 // If your child Device class needs to handle custom commands, then override this method:
 //
-// The global <CommandPacket> will have the command definition.
+// <command> has the command definition.
 // First call this base class method to handle the built-in Device commands:
 //
-//   Device::ExecuteCommand ();
+//   Device::ExecuteCommand (command, reply);
 //
 // If this call returns NOT_HANDLED, then your child class should handle the command.
 //
-// If your ExecuteCommand() method has data to return, it should populate the
-// global <DataPacket> and return an appropriate ProcessStatus.
+// If your ExecuteCommand() method has data to return, it should populate
+// <reply> and return an appropriate ProcessStatus.
 //
-// When populating the global <DataPacket>, value strings that start with a dash or a digit
+// When populating <reply>, value strings that start with a dash or a digit
 // will be interpreted by the Interface as periodic process data, say from a sensor reading.
 //
 // Commands recognized by the driver:
@@ -94,38 +104,29 @@ ProcessStatus DEV_Driver::DoPeriodic()
 //   SPD   <rate>      // +/- 2048  heading change in mm per Millisecond. May be negative.
 //   ROT <degrees>      // +/- 2048 degrees per Millisecond. Negative is right, positive is left
 //   stop (int stopRate); // 0..100 0 means drift, 100 means emergency stop, otherwise percentage
+//   CRAT <hz>          // control loop rate, 1..1000 ticks per second
+//   CTIK [R]           // control loop tick statistics, R also resets them
+//   CAPT [N|M|X ...]   // arm, stop or report a capture of both wheels (see Capture.h)
+//   CGET <index>       // download captured records, from <index>
 //
 //
-ProcessStatus  DEV_Driver::ExecuteCommand ()
+ProcessStatus  DEV_Driver::ExecuteCommand (CPacket &command, DPacket &reply)
 {
     ProcessStatus status;
-    status = Device::ExecuteCommand();
+    status = Device::ExecuteCommand(command, reply);
     if (status != NOT_HANDLED) return(status);
 
     status=FAIL_NODATA;
-    scanParam();
-    char *cmdPtr = CommandPacket.command;
-
-    if (strncmp(cmdPtr, "MOVE",4) == 0)
-    {  // Move  at a given speed and rate of rotation
-        status=cmdMOV(argCount, arglist);
-        
-    }  else if (strncmp(cmdPtr, "STOP",4) == 0)
-    { // Stop all motion
-        status=cmdSTOP(argCount ,arglist);
-
-    } else if (strncmp(cmdPtr,"SPED",4) == 0)
-    {  // Set speed
-        status = cmdSPEED(argCount ,arglist);
-
-    } else if (strncmp(cmdPtr,"ROTA",4 ) == 0)
-    {  // Set rotation rate
-        status = cmdROTATION(argCount ,arglist);
-    } else if (strncmp(cmdPtr, "DRFT", 4) == 0)
+
+    // Look up the command in commandTable (see DEV_Driver.h):
+    //   CAPT, CGET, CRAT, CTIK, DRFT, MOVE, ROTA, SPED, STOP
+    auto entry = FindCommand(commandTable, command.key);
+    if (entry != nullptr)
     {
-        status = cmdDrift(argCount, arglist);
+        scanParam(command, reply);
+        status = (this->*entry->handler)(argCount, arglist, reply);
     } else {
-        sprintf(DataPacket.value, "EROR|Driver|Unknown command");
+        sprintf(reply.value, "EROR|Driver|Unknown command");
         status = FAIL_DATA;
     }
     // Serial.print("STATUS:  "); Serial.println(status);
@@ -150,6 +151,8 @@ void DEV_Driver::setMotion(int speed, int rotation)
     int tmpSpeed, tmpRotate = 0;   // these are the raw joystick readings, 0 to +/-2048
     dist_t m1, m2 = 0.0;           // These are in mm/sec.
 
+    control->capture.triggerOnMotion();   // a capture armed with CAPT|M starts here
+
     tmpSpeed = constrain(speed, -2048, 2048);
     tmpRotate = constrain(rotation, -2048, 2048);
 
@@ -180,12 +183,9 @@ void DEV_Driver::setMotion(int speed, int rotation)
  *  If no turnRate, assume straight ahead
  * @return ProcessStatus 
  */
-ProcessStatus DEV_Driver::cmdMOV(int argcnt, char *argv[])
+ProcessStatus DEV_Driver::cmdMOV(int argcnt, const ParamSpan *argv, DPacket &reply)
 {
-    ProcessStatus retVal = SUCCESS_NODATA;
     int tmpval = 0;
-    char *pSpd = nullptr;
-    char *pRot = nullptr;
 
     Serial.println("See cmdMOV");
     ProcessStatus result = SUCCESS_NODATA;
@@ -193,12 +193,11 @@ ProcessStatus DEV_Driver::cmdMOV(int argcnt, char *argv[])
    if (argcnt==2)
     {   // We have two args - speed and turnrate
         errno = 0;
-        tmpval = strtol(argv[0], nullptr, 10);  // speed
+        tmpval = strtol(argv[0].text, nullptr, 10);  // speed
         if (errno != 0)
         { // bad value (overflow/underflow)
             result = FAIL_DATA;
-            sprintf(DataPacket.value, "speed parameter is not a valid value");
-            retVal = FAIL_DATA;
+            sprintf(reply.value, "speed parameter is not a valid value");
             goto endCmdMOV;
         }
         else
@@ -208,12 +207,11 @@ ProcessStatus DEV_Driver::cmdMOV(int argcnt, char *argv[])
 
 
         errno = 0;
-        tmpval = strtol(argv[1], nullptr, 10); // rotation rate
+        tmpval = strtol(argv[1].text, nullptr, 10); // rotation rate
         if (errno != 0)
         {
             result = FAIL_DATA;
-            sprintf(DataPacket.value, "speed parameter is not a valid value");
-            retVal = FAIL_DATA;
+            sprintf(reply.value, "speed parameter is not a valid value");
             goto endCmdMOV;
         }
         else
@@ -226,8 +224,8 @@ ProcessStatus DEV_Driver::cmdMOV(int argcnt, char *argv[])
     setMotion(mySpeed, myDirect);
 
     // Report current speed and rotation rate
-    DataPacket.timestamp = millis();
-    sprintf(DataPacket.value, "*** In SetMotion: Speed|%d| dir|%d| m1|%f| M2|%f",
+    reply.timestamp = millis();
+    sprintf(reply.value, "*** In SetMotion: Speed|%d| dir|%d| m1|%lu| M2|%lu",
              mySpeed, myDirect, leftMtr->GetRate(), rightMtr->GetRate());
 
 endCmdMOV:
@@ -242,7 +240,7 @@ endCmdMOV:
  *
  * @return ProcessStatus
  */
-ProcessStatus DEV_Driver::cmdSTOP(int argcnt, char *argv[])
+ProcessStatus DEV_Driver::cmdSTOP(int argcnt, const ParamSpan *argv, DPacket &reply)
 {
     ProcessStatus retVal = SUCCESS_NODATA;
     Serial.println("See cmdSTOP");
@@ -255,7 +253,7 @@ ProcessStatus DEV_Driver::cmdSTOP(int argcnt, char *argv[])
  * @brief SMAC command handler - set speed
  * @return ProcessStatus 
  */
-ProcessStatus DEV_Driver::cmdSPEED(int argcnt, char *argv[])
+ProcessStatus DEV_Driver::cmdSPEED(int argcnt, const ParamSpan *argv, DPacket &reply)
 {
     ProcessStatus retVal=SUCCESS_NODATA;   
     errno = 0;
@@ -263,7 +261,7 @@ ProcessStatus DEV_Driver::cmdSPEED(int argcnt, char *argv[])
 
     if (argcnt == 1)
     {
-        if (0 != getDouble(0, &tmpSpd, "Speed value:"))
+        if (SUCCESS_NODATA != getDouble(0, &tmpSpd, "Speed value:"))
         {
             retVal = FAIL_DATA;
             goto cmdSPEEDend;
@@ -275,14 +273,14 @@ ProcessStatus DEV_Driver::cmdSPEED(int argcnt, char *argv[])
     }
     else if (argcnt != 0)
     {
-        sprintf(DataPacket.value, "too many arguments");
+        sprintf(reply.value, "too many arguments");
         retVal=FAIL_DATA;
         goto cmdSPEEDend;
     }
 
     if (retVal == SUCCESS_NODATA)
     {
-        sprintf(DataPacket.value, "SPED|%f", mySpeed);
+        sprintf(reply.value, "SPED|%d", mySpeed);
         retVal = SUCCESS_DATA;
     }
 
@@ -295,19 +293,18 @@ cmdSPEEDend:
  * 
  * @return ProcessStatus 
  */
-ProcessStatus DEV_Driver::cmdROTATION(int argcnt, char *argv[])
+ProcessStatus DEV_Driver::cmdROTATION(int argcnt, const ParamSpan *argv, DPacket &reply)
 {
-    ProcessStatus retVal = SUCCESS_DATA;
+    ProcessStatus retVal = SUCCESS_NODATA;
 
-    char *pRot;
     double tmpRot;
     errno = 0;
 
     if (argcnt == 1)
     {
-        if (0 != getDouble( 0, &tmpRot, "Rotation:"))
+        if (SUCCESS_NODATA != getDouble( 0, &tmpRot, "Rotation:"))
         {
-            retVal - FAIL_DATA;
+            retVal = FAIL_DATA;
             goto cmdROTATIONend;
 
         } else {
@@ -316,14 +313,14 @@ ProcessStatus DEV_Driver::cmdROTATION(int argcnt, char *argv[])
         if (errno != 0)
         { //to many arguments
             retVal = FAIL_DATA;
-            sprintf(DataPacket.value, "Too many arguments");
+            sprintf(reply.value, "Too many arguments");
             goto cmdROTATIONend;
         }
     }
 
     if (retVal==SUCCESS_NODATA)
     {
-        sprintf(DataPacket.value,"ROTA|%d", myDirect);
+        sprintf(reply.value,"ROTA|%d", myDirect);
         retVal=SUCCESS_DATA;
     }
 
@@ -339,13 +336,180 @@ cmdROTATIONend:
  * @param argv 
  * @return ProcessStatus 
  */
-ProcessStatus DEV_Driver::cmdDrift(int argcnt, char *argv[])
+ProcessStatus DEV_Driver::cmdDrift(int argcnt, const ParamSpan *argv, DPacket &reply)
 {
     ProcessStatus retVal = SUCCESS_NODATA;
     // PID to manunal
     leftMtr ->setDrift();
     rightMtr->setDrift();
-    sprintf(DataPacket.value, "DRFT|OK");
+    sprintf(reply.value, "DRFT|OK");
     retVal = SUCCESS_DATA;
     return(retVal);
-}
\ No newline at end of file
+}
+
+
+/**
+ * @brief Get or set the control loop rate
+ *   FORMAT:    CRAT            report the rate
+ *   FORMAT:    CRAT|<hz>       set it, CONTROL_RATE_MIN_HZ..CONTROL_RATE_MAX_HZ
+ *   Reply:     CRAT|<hz>|<period uSecs>
+ *   The PID sample time follows the rate, so the Ki and Kd tunings keep their meaning.
+ * @return ProcessStatus
+ */
+ProcessStatus DEV_Driver::cmdCtlRate(int argcnt, const ParamSpan *argv, DPacket &reply)
+{
+    ProcessStatus retVal = SUCCESS_NODATA;
+    int32_t rate = 0;
+
+    if (argcnt == 1)
+    {
+        if (SUCCESS_NODATA != getInt32(0, &rate, "Control rate"))
+        {
+            retVal = FAIL_DATA;
+        }
+        else if ((rate < CONTROL_RATE_MIN_HZ) || !control->setRate(rate))
+        {
+            sprintf(reply.value, "EROR|CRAT|Rate must be %d..%d", CONTROL_RATE_MIN_HZ, CONTROL_RATE_MAX_HZ);
+            retVal = FAIL_DATA;
+        }
+    }
+    else if (argcnt != 0)
+    {
+        sprintf(reply.value, "EROR|CRAT|Wrong number of arguments");
+        retVal = FAIL_DATA;
+    }
+
+    if (retVal == SUCCESS_NODATA)
+    {
+        sprintf(reply.value, "CRAT|%lu|%lu", (unsigned long)control->getRate(), (unsigned long)control->getPeriodUs());
+        retVal = SUCCESS_DATA;
+    }
+    return(retVal);
+}
+
+
+/**
+ * @brief Report the control loop tick statistics
+ *   FORMAT:    CTIK            report
+ *   FORMAT:    CTIK|R          report, then reset
+ *   Reply:     CTIK|<ticks>|<overruns>|<lastRunUs>|<maxRunUs>|<maxJitterUs>
+ *     overruns are ticks whose work took longer than the period,
+ *     jitter is how far a tick interval was from the period.
+ * @return ProcessStatus
+ */
+ProcessStatus DEV_Driver::cmdCtlTicks(int argcnt, const ParamSpan *argv, DPacket &reply)
+{
+    if (argcnt > 1 || (argcnt == 1 && (argv[0].length != 1 || toupper(argv[0].text[0]) != 'R')))
+    {
+        sprintf(reply.value, "EROR|CTIK|Use CTIK or CTIK|R");
+        return(FAIL_DATA);
+    }
+
+    ControlLoop::TickStats now = control->getStats();
+    if (argcnt == 1) control->resetStats();
+
+    sprintf(reply.value, "CTIK|%lu|%lu|%lu|%lu|%lu",
+            (unsigned long)now.ticks, (unsigned long)now.overruns, (unsigned long)now.lastRunUs,
+            (unsigned long)now.maxRunUs, (unsigned long)now.maxJitterUs);
+    return(SUCCESS_DATA);
+}
+
+
+/**
+ * @brief Arm, stop or report a capture of both wheels (see Capture.h)
+ *   FORMAT:    CAPT                                    report
+ *   FORMAT:    CAPT|N|<divider>|<samples>              start now
+ *   FORMAT:    CAPT|M|<divider>|<pre>|<post>           start at the next motion command (MOVE, SPED, ROTA, STOP)
+ *   FORMAT:    CAPT|X                                  stop, keeping what was recorded
+ *     <divider> - record every <divider>th control tick
+ *     <pre>     - samples to keep from before the motion command
+ *   Reply:     CAPT|<state>|<records>|<triggerIndex>|<triggerUs>|<sampleUs>|<capacity>
+ *     state is I(dle), A(rmed), R(unning) or D(one); once done, CGET downloads the records.
+ * @return ProcessStatus
+ */
+ProcessStatus DEV_Driver::cmdCapture(int argcnt, const ParamSpan *argv, DPacket &reply)
+{
+    ProcessStatus retVal = SUCCESS_NODATA;
+    uint32_t divider = 0;
+    uint32_t pre = 0;
+    uint32_t post = 0;
+    char mode = (argcnt > 0 && argv[0].length == 1) ? toupper(argv[0].text[0]) : 0;
+
+    if (argcnt == 0)
+    {
+        // just report
+    }
+    else if (mode == 'X' && argcnt == 1)
+    {
+        control->capture.stop();
+    }
+    else if ((mode == 'N' && argcnt == 3) || (mode == 'M' && argcnt == 4))
+    {
+        if ((SUCCESS_NODATA != getUint32(1, &divider, "Capture divider"))
+            || (mode == 'M' && SUCCESS_NODATA != getUint32(2, &pre, "Capture pre-trigger samples"))
+            || (SUCCESS_NODATA != getUint32(argcnt - 1, &post, "Capture samples")))
+        {
+            retVal = FAIL_DATA;
+        }
+        else if (!control->capture.arm((mode == 'N') ? Capture::TRIGGER_NOW : Capture::TRIGGER_MOTION, divider, pre, post))
+        {
+            sprintf(reply.value, "EROR|CAPT|Busy, or divider < 1, or samples not 1..%lu",
+                    (unsigned long)control->capture.getStatus().capacity);
+            retVal = FAIL_DATA;
+        }
+    } else {
+        sprintf(reply.value, "EROR|CAPT|Use CAPT, CAPT|N|div|n, CAPT|M|div|pre|post or CAPT|X");
+        retVal = FAIL_DATA;
+    }
+
+    if (retVal == SUCCESS_NODATA)
+    {
+        Capture::Status now = control->capture.getStatus();
+        sprintf(reply.value, "CAPT|%c|%lu|%lu|%lu|%lu|%lu", "IARD"[now.state],
+                (unsigned long)now.records, (unsigned long)now.triggerIndex, (unsigned long)now.triggerUs,
+                (unsigned long)(now.divider * control->getPeriodUs()), (unsigned long)now.capacity);
+        retVal = SUCCESS_DATA;
+    }
+    return(retVal);
+}
+
+
+/**
+ * @brief Download records of a finished capture
+ *   FORMAT:    CGET|<index>
+ *   Reply:     CGET|<index>|<count>|<base64 of <count> records>
+ *     Up to CAPTURE_CHUNK_RECORDS records from <index>, in the layout of Capture.h.
+ *     A count of 0 means <index> is past the end.
+ * @return ProcessStatus
+ */
+// The whole text frame of a traced reply, at its longest, must fit one message, or its end is cut off:
+//   "nn|dd|<timestamp>|" (17) + "CGET|<index>|<count>|" (18) + base64 + "|#<trace id>" (12) + NULL
+static_assert(17 + 18 + 4 * ((CAPTURE_CHUNK_RECORDS * CAPTURE_RECORD_SIZE + 2) / 3) + 12 + 1 <= MAX_MESSAGE_LENGTH,
+              "CAPTURE_CHUNK_RECORDS is too large for a traced CGET reply");
+
+ProcessStatus DEV_Driver::cmdCaptureGet(int argcnt, const ParamSpan *argv, DPacket &reply)
+{
+    Capture::Record chunk[CAPTURE_CHUNK_RECORDS];
+    uint32_t index = 0;
+
+    if (argcnt != 1)
+    {
+        sprintf(reply.value, "EROR|CGET|Use CGET|<index>");
+        return(FAIL_DATA);
+    }
+    if (SUCCESS_NODATA != getUint32(0, &index, "Capture index"))
+    {
+        return(FAIL_DATA);
+    }
+
+    int count = control->capture.read(index, chunk, CAPTURE_CHUNK_RECORDS);
+    if (count < 0)
+    {
+        sprintf(reply.value, "EROR|CGET|No finished capture");
+        return(FAIL_DATA);
+    }
+
+    int len = sprintf(reply.value, "CGET|%lu|%d|", (unsigned long)index, count);
+    Capture::encodeBase64((const uint8_t *)chunk, count * (int)sizeof(Capture::Record), reply.value + len);
+    return(SUCCESS_DATA);
+}
@@ -22,10 +22,6 @@
 
 // #define DEBUG_DEV_INA3221
 
-// Static initializer
-portMUX_TYPE DEV_INA3221::INA3221_Data_Access_Spinlock = portMUX_INITIALIZER_UNLOCKED;
-
-
 // - - - - - - - - - - - - - - - - - - - - -
 // @brief Construct a new INA3221Device object
 //
@@ -55,15 +51,30 @@ DEV_INA3221::INA3221DeviceChannel::INA3221DeviceChannel(const char *inName, DEV_
 // - - - - - - - - - - - - - - - - - - - - -
 // Report the battery voltage and current readings
 // - - - - - - - - - - - - - - - - - - - - -
-ProcessStatus DEV_INA3221::INA3221DeviceChannel::DoPeriodic()
+ProcessStatus DEV_INA3221::INA3221DeviceChannel::DoPeriodic(DPacket &packet)
 {    
     float val=0;
-    me->getDataReading(dataPointNo, &val, &DataPacket.timestamp);
-    sprintf(DataPacket.value, "%f",val,  &DataPacket.timestamp);
+    me->getDataReading(dataPointNo, &val, &packet.timestamp);
+    packet.ClearFields();
+    packet.AddFloatField(val);
     return (SUCCESS_DATA);
 }
 
 
+// - - - - - - - - - - - - - - - - - - - - -
+// Sample the reading for a subscription (SSUB), it is field 0
+// - - - - - - - - - - - - - - - - - - - - -
+bool DEV_INA3221::INA3221DeviceChannel::SampleField(int field, DPacket &packet)
+{
+    float val=0;
+    unsigned long timeStamp;
+    if (field != 0) return(false);
+    me->getDataReading(dataPointNo, &val, &timeStamp);
+    packet.AddFloatField(val);
+    return(true);
+}
+
+
 // - - - - - - - - - - - - - - - - - - - - -
 // @brief Construct a new INA3221Device object
 //
@@ -77,15 +88,12 @@ DEV_INA3221::DEV_INA3221(const char *inName, int _i2CAddr, Node *myNode, TwoWire
     initStatusOk=false;
     strncpy(version, INA3221Version, MAX_VERSION_LENGTH);
     version[MAX_VERSION_LENGTH-1]=0x00;
+    SetTrafficClass(TRAFFIC_STATUS);   // battery readings are safety data, keep them when telemetry is limited
     immediateEnabled = false;
     periodicEnabled = false;
-    readCounter = 0;
     SetRate(900);     // default reporting rate (every 4 secs)for this device
 
-    // Initialize the readings to 0.
-    for (int i=0; i<6; i++) {
-       dataReadings[i]=0.0;
-    }
+    // The readings start at 0 (the SeqLock value-initializes them)
 
     // Init communications with I2C
     i2cAddr = _i2CAddr;    // Remember our address
@@ -104,7 +112,13 @@ DEV_INA3221::DEV_INA3221(const char *inName, int _i2CAddr, Node *myNode, TwoWire
     myNode->AddDevice(new INA3221DeviceChannel("Current2", this, 5));
 
  // Start the read task, configure the INA3221
-    ESP_ERROR_CHECK(xTaskCreate(readDataTask, "ReadINA3221", 4096, this, 3, &readtask));
+    // xTaskCreate returns pdPASS (1), not ESP_OK, so it cannot go through ESP_ERROR_CHECK
+    if (xTaskCreate(readDataTask, "ReadINA3221", 4096, this, 3, &readtask) != pdPASS)
+    {
+        Serial.println("Failed to start INA3221 read task");
+        initStatusOk = false;
+        return;
+    }
     for (uint8_t idx = 0; idx < 3; idx++)
     {
         TAKE_I2C;
@@ -114,7 +128,7 @@ DEV_INA3221::DEV_INA3221(const char *inName, int _i2CAddr, Node *myNode, TwoWire
     noOfSamplesPerReading=16;
     sampleTimeUs=5000;
     updateSampleReadInterval(5000); // Default 5000 msecs (5 Second).
-    Serial.printf("INITIAL SAMPLE TIME IS %d ticks\r\n", sampleReadIntervalMs);
+    Serial.printf("INITIAL SAMPLE TIME IS %d ticks\r\n", (int)sampleReadIntervalMs.read());
     initStatusOk = true;
 }
 
@@ -136,16 +150,14 @@ DEV_INA3221::DEV_INA3221(const char *inName, int _i2CAddr, Node *myNode, TwoWire
 // - - - - - - - - - - - - - - - - - - - - -
 time_t DEV_INA3221::updateSampleReadInterval( time_t timeInMsecs)
 {
-    taskENTER_CRITICAL(&INA3221_Data_Access_Spinlock);
-    sampleReadIntervalMs = timeInMsecs;  
-    taskEXIT_CRITICAL(&INA3221_Data_Access_Spinlock);
+    sampleReadIntervalMs.write(timeInMsecs);
 
 
-    Serial.printf ("***In updateSampleReadInterval - new update interval is %d Msecs\r\n", sampleReadIntervalMs);
+    Serial.printf ("***In updateSampleReadInterval - new update interval is %d Msecs\r\n", (int)timeInMsecs);
 
     xTaskAbortDelay(readtask);  // tell our subtask to use the new time period
 
-    return (sampleReadIntervalMs);
+    return (timeInMsecs);
 }
 
 
@@ -161,10 +173,9 @@ time_t DEV_INA3221::updateSampleReadInterval( time_t timeInMsecs)
 // - - - - - - - - - - - - - - - - - - - - -
 void DEV_INA3221::getDataReading(int idx, float *dta, unsigned long int *timeStamp)
 {
-    taskENTER_CRITICAL(&INA3221_Data_Access_Spinlock);
-    *timeStamp = (unsigned long) dts_msec;
-    *dta = dataReadings[idx];
-    taskEXIT_CRITICAL(&INA3221_Data_Access_Spinlock);
+    Readings now = readings.read();
+    *timeStamp = (unsigned long) now.dts_msec;
+    *dta = now.dataReadings[idx];
 }
 
 // - - - - - - - - - - - - - - - - - - - - -
@@ -176,40 +187,36 @@ void DEV_INA3221::readDataTask(void *arg)
 {
     DEV_INA3221 *me=(DEV_INA3221 *) arg;
 
-    float tmpValues[6]= {};
+    Readings newReadings = {};
     uint8_t idx=0;
-    time_t xLastWakeTime;  // when we last woke up
-    bool wasDelayedFlag=false; 
+    TickType_t xLastWakeTime = xTaskGetTickCount();  // deadline of this reading
 
     while (true)
     {   // do forever
         #ifdef DEBUG_DEV_INA3221
         Serial.println("***READ NEW DATA VALUES");
         #endif
-        xLastWakeTime = esp_timer_get_time();
-        me->readCounter++;
+        newReadings.readCounter++;
 
         // we are ready to read - do it!
         TAKE_I2C;  // Using I2C - this can take a while...
         for (idx = 0; idx < 3; idx++)
         {           
-            tmpValues[idx]   = me->getBusVoltage(idx);
-            tmpValues[idx+3] = me->getCurrentAmps(idx) * 1000; // convert to ma
+            newReadings.dataReadings[idx]   = me->getBusVoltage(idx);
+            newReadings.dataReadings[idx+3] = me->getCurrentAmps(idx) * 1000; // convert to ma
         }
         GIVE_I2C;
 
-        // Now update our internal memory with the new values
-        taskENTER_CRITICAL(&INA3221_Data_Access_Spinlock);
-        for (idx=0; idx<6; idx++)
-        {
-            me->dataReadings[idx] = tmpValues[idx];
-        }
-        me->dts_msec = esp_timer_get_time()/1000;
-        taskEXIT_CRITICAL(&INA3221_Data_Access_Spinlock);
+        // Now publish the new values, all together
+        newReadings.dts_msec = esp_timer_get_time()/1000;
+        me->readings.write(newReadings);
 
-        // wait a while for the next reading
-        TickType_t waitTimeMs = me->sampleReadIntervalMs - ((esp_timer_get_time() - xLastWakeTime) / 1000);
-        vTaskDelay(portTICK_PERIOD_MS * waitTimeMs);
+        // wait for the next reading, one interval after this one's deadline (no drift).
+        // If the reading ran past it, skip ahead instead of bunching readings up.
+        TickType_t interval = pdMS_TO_TICKS(me->sampleReadIntervalMs.read());
+        if (interval < 1) interval = 1;
+        if (xTaskDelayUntil(&xLastWakeTime, interval) == pdFALSE)
+            xLastWakeTime = xTaskGetTickCount();
     }
 }
 
@@ -218,64 +225,76 @@ void DEV_INA3221::readDataTask(void *arg)
  * 
  *  FORMAT:   INAX|<readCount>|volt[0], volt[1], volt[2], current[0], current[1], current[2]
  */
-ProcessStatus DEV_INA3221::DoPeriodic()
+ProcessStatus DEV_INA3221::DoPeriodic(DPacket &packet)
 {
-    float tmp[6];
-    unsigned long long tmpCount;
-    time_t timeStamp;
-    taskENTER_CRITICAL(&INA3221_Data_Access_Spinlock);
+    Readings now = readings.read();
+
+    packet.ClearFields();
+    packet.AddTextField("INAX");
+    packet.AddUIntField((uint32_t)now.readCounter);
     for (int i=0; i<6; i++)
     {
-        tmp[i] = dataReadings[i];
+        packet.AddFloatField(now.dataReadings[i]);
     }
-    tmpCount = readCounter;
-    timeStamp = dts_msec;
-    taskEXIT_CRITICAL(&INA3221_Data_Access_Spinlock);
-
-    sprintf(DataPacket.value, "INAX|%llu|%f|%f|%f|%f|%f|%f",tmpCount,
-         tmp[0], tmp[1], tmp[2], tmp[3], tmp[4], tmp[5]);
-    DataPacket.timestamp = timeStamp;
+    packet.timestamp = now.dts_msec;
     return(SUCCESS_DATA);
 }
 
 
+/**
+ * @brief Sample one field of the periodic report, for a subscription (SSUB)
+ *   Fields are numbered as in DoPeriodic: 1 = read count, 2..4 = volts, 5..7 = currents
+ * @return false if there is no such field
+ */
+bool DEV_INA3221::SampleField(int field, DPacket &packet)
+{
+    unsigned long timeStamp;
+    float val;
+
+    if (field == 1)
+    {
+        packet.AddUIntField((uint32_t)readings.read().readCounter);
+        return(true);
+    }
+    if ((field < 2) || (field > 7)) return(false);
+
+    getDataReading(field - 2, &val, &timeStamp);
+    packet.AddFloatField(val);
+    return(true);
+}
+
+
 // - - - - - - - - - - - - - - - - - - - - -
 // Handle any SMAC commands 
 // FORMAT: GPOW   ( get all 6 current values)
 // - - - - - - - - - - - - - - - - - - - - -
-ProcessStatus  DEV_INA3221::ExecuteCommand () 
+ProcessStatus  DEV_INA3221::ExecuteCommand(CPacket &command, DPacket &reply) 
 {
     ProcessStatus retVal=SUCCESS_NODATA;
-    DataPacket.timestamp=millis();
-    retVal = Device::ExecuteCommand();
+    reply.timestamp=millis();
+    retVal = Device::ExecuteCommand(command, reply);
     if (retVal == NOT_HANDLED)
     {
-        scanParam();
-        if (isCommand("STIM"))
-        {  // Set the time per sample (ms)
-            retVal=setTimePerSampleCommand();
-
-        } else if (isCommand("SAVG"))
+        // Look up the command in commandTable (see DEV_INA3221.h)
+        const CommandEntry<CommandHandler<DEV_INA3221>> *entry = FindCommand(commandTable, command.key);
+        if (entry != nullptr)
         {
-            retVal=setAveragingModeCommand();
+            scanParam(command, reply);
+            retVal = (this->*entry->handler)(command, reply);
 
-        } else if (isCommand("RATE"))
-        {
-            retVal = setSampleRateCommand();
-        
         } else 
         { 
-            sprintf(DataPacket.value, "ERROR: Unknown command");
+            sprintf(reply.value, "ERROR: Unknown command");
             retVal=FAIL_DATA;
         }
     }
  
     if (retVal==SUCCESS_NODATA)
     {        
-        sprintf(DataPacket.value, "OK");
+        sprintf(reply.value, "OK");
         retVal=SUCCESS_DATA;
     }
-    if (DataPacket.timestamp == 0) DataPacket.timestamp = millis();
+    if (reply.timestamp == 0) reply.timestamp = millis();
     return(retVal);
 }
 
@@ -287,7 +306,7 @@ ProcessStatus  DEV_INA3221::ExecuteCommand ()
  *         1, 4, 16, 64, 128, 256, 512, 1024
  * @return ProcessStatus 
  */
-ProcessStatus DEV_INA3221::setAveragingModeCommand()
+ProcessStatus DEV_INA3221::setAveragingModeCommand(CPacket &command, DPacket &reply)
 {
     ProcessStatus retVal = SUCCESS_NODATA;
     int notoaverage = 0;
@@ -298,22 +317,22 @@ ProcessStatus DEV_INA3221::setAveragingModeCommand()
     }
     else if (argCount != 0)
     {
-        sprintf(DataPacket.value, "ERROR: Missing (or too many) arguments to SAVG command");
+        sprintf(reply.value, "ERROR: Missing (or too many) arguments to SAVG command");
         retVal = FAIL_DATA;
     }
 
     if ((argCount == 1) && (retVal == SUCCESS_NODATA))
     {
-        retVal = setAvgCount(notoaverage);
+        retVal = setAvgCount(notoaverage, reply);
     }
 
     if (retVal == SUCCESS_DATA)
     {
-        Serial.printf(DataPacket.value, "SAVG|%d\r\n", noOfSamplesPerReading);
+        Serial.printf(reply.value, "SAVG|%d\r\n", noOfSamplesPerReading);
         retVal = SUCCESS_DATA;
     }
 
-    DataPacket.timestamp = millis();
+    reply.timestamp = millis();
     return (retVal);
 }
 
@@ -324,7 +343,7 @@ ProcessStatus DEV_INA3221::setAveragingModeCommand()
  *         1, 4, 16, 64, 128, 256, 512, 1024
  *  return: The update interval is re-calculated.
  */
-ProcessStatus DEV_INA3221::setAvgCount(int val)
+ProcessStatus DEV_INA3221::setAvgCount(int val, DPacket &reply)
 {
     ProcessStatus retVal=SUCCESS_NODATA;
 
@@ -374,9 +393,9 @@ ProcessStatus DEV_INA3221::setAvgCount(int val)
     }
     else
     {     
-        sprintf(DataPacket.value, "ERROR: Count Must be one of 1,4,16,64,128,256,512,1024. arg=%d", val);
+        sprintf(reply.value, "ERROR: Count Must be one of 1,4,16,64,128,256,512,1024. arg=%d", val);
         #ifdef DEBUG_DEV_INA3221
-        Serial.println(DataPacket.value);
+        Serial.println(reply.value);
         #endif
         retVal = FAIL_DATA;
     }
@@ -384,10 +403,10 @@ ProcessStatus DEV_INA3221::setAvgCount(int val)
 
     if (retVal == SUCCESS_NODATA)
     {
-        sprintf(DataPacket.value, "OK");
+        sprintf(reply.value, "OK");
         retVal = SUCCESS_DATA;
     }
-    DataPacket.timestamp = millis();
+    reply.timestamp = millis();
     return(retVal);
 }
 
@@ -400,7 +419,7 @@ ProcessStatus DEV_INA3221::setAvgCount(int val)
  * 
  * @return ProcessStatus 
  */
-ProcessStatus DEV_INA3221::setTimePerSampleCommand()
+ProcessStatus DEV_INA3221::setTimePerSampleCommand(CPacket &command, DPacket &reply)
 {
   ProcessStatus retVal = SUCCESS_NODATA;
     int time_val = 0;
@@ -409,20 +428,20 @@ ProcessStatus DEV_INA3221::setTimePerSampleCommand()
         retVal = getInt(0, &time_val, "Code for timePerSample:");
     } else if (argCount!=0)
     {
-        sprintf(DataPacket.value, "ERROR: Missing (or too many) arguments");
+        sprintf(reply.value, "ERROR: Missing (or too many) arguments");
         retVal = FAIL_DATA;
     }
 
     if (  (argCount==1) && (retVal == SUCCESS_NODATA))
-            retVal = setConvTime(time_val);
+            retVal = setConvTime(time_val, reply);
 
     if (retVal == SUCCESS_NODATA)
     {
-        sprintf(DataPacket.value, "STIM|%f", sampleTimeUs);
+        sprintf(reply.value, "STIM|%lld", (long long)sampleTimeUs);
         retVal = SUCCESS_DATA;
     }
 
-    DataPacket.timestamp = millis();
+    reply.timestamp = millis();
     return (retVal);
 }
 
@@ -436,7 +455,7 @@ ProcessStatus DEV_INA3221::setTimePerSampleCommand()
  *          1 (mSec)      2 (mSecs)  4 (mSecs) 8 (secs)
  *
  */
-ProcessStatus DEV_INA3221::setConvTime(int val)
+ProcessStatus DEV_INA3221::setConvTime(int val, DPacket &reply)
 {
     ProcessStatus retVal = SUCCESS_NODATA;
 
@@ -492,7 +511,7 @@ ProcessStatus DEV_INA3221::setConvTime(int val)
     else
     {
         retVal = FAIL_DATA;
-        sprintf(DataPacket.value, "ERROR: Convert time must be 140, 204, 332, 588, 1, 2, 4, 8");
+        sprintf(reply.value, "ERROR: Convert time must be 140, 204, 332, 588, 1, 2, 4, 8");
         #ifdef DEBUG_DEV_INA3221
         Serial.printf( "ERROR: Convert time must be 140, 204, 332, 588, 1, 2, 4, 8. value seen = %d\r\n",val);
         #endif
@@ -502,9 +521,9 @@ ProcessStatus DEV_INA3221::setConvTime(int val)
     if (retVal == SUCCESS_NODATA)
     {
         retVal = SUCCESS_DATA;
-        sprintf(DataPacket.value, "OK");
+        sprintf(reply.value, "OK");
     }
-    DataPacket.timestamp = millis();
+    reply.timestamp = millis();
     return (retVal);
 }
 
@@ -514,18 +533,18 @@ ProcessStatus DEV_INA3221::setConvTime(int val)
  *  FORMAT:  <SRAT>|<time>
  *     <time> is in milliseconds (limit 32767)
  */
-ProcessStatus DEV_INA3221::setSampleRateCommand()
+ProcessStatus DEV_INA3221::setSampleRateCommand(CPacket &command, DPacket &reply)
 {
     ProcessStatus retVal = SUCCESS_NODATA;
 
-    time_t newRate = 0;
+    long long newRate = 0;
     if (argCount == 1)
     {
         retVal = getLLint(0, &newRate, "Sample Rate:");
     }
     else if (argCount != 0)
     {
-        sprintf(DataPacket.value, "ERROR: Missing (or too many) arguments");
+        sprintf(reply.value, "ERROR: Missing (or too many) arguments");
         retVal = FAIL_DATA;
     }
 
@@ -536,7 +555,7 @@ ProcessStatus DEV_INA3221::setSampleRateCommand()
 
     if (retVal==SUCCESS_NODATA)
     {
-        sprintf(DataPacket.value, "OK");
+        sprintf(reply.value, "OK");
         retVal=SUCCESS_DATA;
     }
 
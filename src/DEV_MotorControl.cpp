@@ -15,6 +15,7 @@ DEV_MotorControl::DEV_MotorControl(const char * InName, Node *_nodePtr) : DefDev
 {
     piddev = nullptr;
     myNode = _nodePtr;
+    periodicReportOnly = false;   // DoPeriodic() runs the motor, it is never skipped
  }
 
 
@@ -57,6 +58,7 @@ void DEV_MotorControl::setup( MotorControl_config_t *cfg, const char *prefix)
     piddev = new DEV_Pid(name, cfg, myQuadDecoder, ln298);
     myNode->AddDevice(piddev);
     periodicEnabled=false;
+    immediateEnabled=false;   // Nothing to do continuously
 }
 
 template <typename A>
@@ -72,22 +74,24 @@ A defmap(A x, A in_min, A in_max, A out_min, A out_max)
  *  REPT <Y|N>   - enable periodic reports
  * @return ProcessStatus 
  */
-ProcessStatus DEV_MotorControl::ExecuteCommand()
+ProcessStatus DEV_MotorControl::ExecuteCommand(CPacket &command, DPacket &reply)
 {
     ProcessStatus retVal;
-    DataPacket.timestamp = millis();
-    retVal = Device::ExecuteCommand();
+    reply.timestamp = millis();
+    retVal = Device::ExecuteCommand(command, reply);
     if (retVal == NOT_HANDLED)
     {
-        scanParam();
-        if (isCommand("MSPD"))
-        { // Set motor speed
-            retVal = cmdSetSpeed(argCount, arglist);
+        // Look up the command in commandTable (see DEV_MotorControl.h)
+        auto entry = FindCommand(commandTable, command.key);
+        if (entry != nullptr)
+        {
+            scanParam(command, reply);
+            retVal = (this->*entry->handler)(argCount, arglist, reply);
         }
 
         else
         {
-            sprintf(DataPacket.value, "EROR|DEV_MotorControl|Unknown command");
+            sprintf(reply.value, "EROR|DEV_MotorControl|Unknown command");
             retVal = FAIL_DATA;
         }
     }
@@ -97,7 +101,7 @@ ProcessStatus DEV_MotorControl::ExecuteCommand()
 /**
  * @brief Set the overall ground speed of the robot
  */
- ProcessStatus DEV_MotorControl::cmdSetSpeed(int argCnt, char **argv)
+ ProcessStatus DEV_MotorControl::cmdSetSpeed(int argCnt, const ParamSpan *argv, DPacket &reply)
  {
     // TODO:
     return(NOT_HANDLED);
@@ -109,7 +113,7 @@ ProcessStatus DEV_MotorControl::ExecuteCommand()
  * @brief loop - call periodically to send status info
  * 
  */
-ProcessStatus DEV_MotorControl::DoPeriodic()
+ProcessStatus DEV_MotorControl::DoPeriodic(DPacket &packet)
 {
     static double last_output_val = 0;
 
@@ -11,7 +11,7 @@
  * SPED|<val>              set (or get) the actual speed.
  * SPID|<p>|<i>|<d>        (set or get PID values)
  * SMODE|<AUTO|MAN..>      Auto (pid controls) or Manual(no pid) 
- * STIM|<time>             PID loop rate (milliseconds)
+ * STIM|<time>             PID loop rate (milliseconds), unless a control loop clocks the PID
  *
  * 7/26/2026 DEF Use timer to drive PID compute.
  */
@@ -26,6 +26,10 @@ DEV_Pid::DEV_Pid( const char *_name, MotorControl_config_t *cfg,
     quad  = _quad;
 
     name = strdup(_name);
+    setPoint = 0;
+    actual = 0;
+    output = 0;
+    controlLoopClock = false;
         //PID(double*, double*, double*,        // * constructor.  links the PID to the actual, Output, and 
         // double, double, double, int, int);   //   Setpoint.  Initial tuning parameters are also set here.
                                                 //   (overload for specifying proportional mode)
@@ -35,6 +39,7 @@ DEV_Pid::DEV_Pid( const char *_name, MotorControl_config_t *cfg,
     pid->SetTunings(DEFAULT_Kp, DEFAULT_Ki, DEFAULT_Kd);
     pid->SetMode(AUTOMATIC); // MANUAL ????
     periodicEnabled=false;
+    immediateEnabled=false;   // The PID runs from its own timer
 
     esp_timer_create_args_t timer_cfg {
         .callback=timer_callback,        //!< Callback function to execute when timer expires
@@ -62,17 +67,40 @@ DEV_Pid::~DEV_Pid()
  * @brief periodically -  report  current values
  * @param arg
  */
-ProcessStatus DEV_Pid::DoPeriodic()
+ProcessStatus DEV_Pid::DoPeriodic(DPacket &packet)
 {
     ProcessStatus retVal = SUCCESS_NODATA;
-    DataPacket.timestamp = millis();    
-    sprintf(DataPacket.value, "PID|%lf|%lf|%lf", setPoint, actual, output);
+    packet.timestamp = millis();    
+    PidState now = state.read();
+    packet.ClearFields();
+    packet.AddTextField("PID");
+    packet.AddFloatField(now.setPoint);
+    packet.AddFloatField(now.actual);
+    packet.AddFloatField(now.output);
     retVal = SUCCESS_DATA;
 
     return (retVal);
 }
 
 
+/**
+ * @brief Sample one field of the periodic report, for a subscription (SSUB)
+ *   Fields are numbered as in DoPeriodic: 1 = setPoint, 2 = actual, 3 = output
+ * @return false if there is no such field
+ */
+bool DEV_Pid::SampleField(int field, DPacket &packet)
+{
+    PidState now = state.read();
+    switch (field)
+    {
+        case 1:  packet.AddFloatField(now.setPoint);  return(true);
+        case 2:  packet.AddFloatField(now.actual);    return(true);
+        case 3:  packet.AddFloatField(now.output);    return(true);
+    }
+    return(false);
+}
+
+
 
 /**
  * @brief Decode (and implement) SMAC commands
@@ -84,50 +112,26 @@ ProcessStatus DEV_Pid::DoPeriodic()
  * FORMAT:  STIM <time_ms>      (sample time rate - via DOIMMEDIATE)
  * @return ProcessStatus 
  */
-ProcessStatus DEV_Pid::ExecuteCommand()
+ProcessStatus DEV_Pid::ExecuteCommand(CPacket &command, DPacket &reply)
 {
     ProcessStatus retVal = SUCCESS_DATA;
-    DataPacket.timestamp = millis();
-    retVal = Device::ExecuteCommand();
+    reply.timestamp = millis();
+    retVal = Device::ExecuteCommand(command, reply);
     if (retVal != NOT_HANDLED)
         return (retVal);
-    retVal = NOT_HANDLED;
-
-    scanParam();
-    if (isCommand("SPED"))
-    {   // Set speed
-        retVal = cmdSetSpeed();
-
-    } else if (isCommand("SETP"))
-    {   // Set p parameter        
-        retVal = cmdSetP();
-
-    } else if (isCommand("SETI"))
-    {  // Set i parameter
-        retVal = cmdSetI();
-
-    } else if (isCommand("SETD"))
-    {   // Set D
-        retVal = cmdSetD();
-    }
-
-    else if (isCommand("SMOD"))
-    {    // Set mode (auto or manual)
-        retVal = cmdSetMode();
-    }
 
-    else if (isCommand("STIM"))
-    {    // Set pid update time (millisecs)
-        retVal = cmdSetSTime();
-    }
-
-    else 
+    // Look up the command in commandTable (see DEV_Pid.h)
+    const CommandEntry<CommandHandler<DEV_Pid>> *entry = FindCommand(commandTable, command.key);
+    if (entry == nullptr)
     {
-        sprintf(DataPacket.value, "EROR|PID|Unknown command");
-        retVal = FAIL_DATA;
+        sprintf(reply.value, "EROR|PID|Unknown command");
+        return (FAIL_DATA);
     }
 
-    return (retVal); // for now...
+    scanParam(command, reply);
+    retVal = (this->*entry->handler)(command, reply);
+
+    return (retVal);
 }
 
 
@@ -138,22 +142,24 @@ ProcessStatus DEV_Pid::ExecuteCommand()
  *    Note: This works wether we are
  * in MANUAL or AUTOMATIC modes
  */
-ProcessStatus DEV_Pid::cmdSetSpeed()
+ProcessStatus DEV_Pid::cmdSetSpeed(CPacket &command, DPacket &reply)
 {
     ProcessStatus retVal=SUCCESS_NODATA;
+    double speed = requestedSpeed.read();
 
     if (argCount == 1)
     {
-        retVal=getDouble(0, &setPoint, "Speed ");
+        retVal=getDouble(0, &speed, "Speed ");
+        if (retVal==SUCCESS_NODATA) setSpeed(speed);
     } else if (argCount != 0)
     {
-        sprintf(DataPacket.value, "ERR|Wrong number of arguments in SPED command");
+        sprintf(reply.value, "ERR|Wrong number of arguments in SPED command");
         retVal=FAIL_DATA;
     }
 
     if (retVal==SUCCESS_NODATA)
     {
-        sprintf(DataPacket.value, "OK|%ld", setPoint);
+        sprintf(reply.value, "OK|%f", speed);
         retVal = SUCCESS_DATA;
     }
     return(retVal);
@@ -164,7 +170,7 @@ ProcessStatus DEV_Pid::cmdSetSpeed()
  */
 void DEV_Pid::setSpeed(double speed)
 {
-    setPoint = speed;
+    requestedSpeed.write(speed);   // timer_callback() picks it up
     return;
 }
 
@@ -174,7 +180,7 @@ void DEV_Pid::setSpeed(double speed)
  * 
  * @return ProcessStatus 
  */
-ProcessStatus DEV_Pid::cmdSetP()
+ProcessStatus DEV_Pid::cmdSetP(CPacket &command, DPacket &reply)
 {
     ProcessStatus retVal=SUCCESS_NODATA;
     if (argCount == 1)
@@ -182,14 +188,14 @@ ProcessStatus DEV_Pid::cmdSetP()
         retVal=getDouble(0, &kp, "Kp ");
     } else if (argCount != 0)
     {
-        sprintf(DataPacket.value, "ERR|Wrong number of arguments in SETP command");
+        sprintf(reply.value, "ERR|Wrong number of arguments in SETP command");
         retVal=FAIL_DATA;
     }
 
     if (retVal==SUCCESS_NODATA)
     {
         if (argCount==1) pid->SetTunings(kp, ki, kd);
-        sprintf(DataPacket.value, "OK|%ld", kp);
+        sprintf(reply.value, "OK|%f", kp);
         retVal = SUCCESS_DATA;
     }
     return(retVal);
@@ -202,7 +208,7 @@ ProcessStatus DEV_Pid::cmdSetP()
  * 
  * @return ProcessStatus 
  */
-ProcessStatus DEV_Pid::cmdSetI()
+ProcessStatus DEV_Pid::cmdSetI(CPacket &command, DPacket &reply)
 {
     ProcessStatus retVal=SUCCESS_NODATA;
     if (argCount == 1)
@@ -210,14 +216,14 @@ ProcessStatus DEV_Pid::cmdSetI()
         retVal=getDouble(0, &ki, "Ki ");
     } else if (argCount != 0)
     {
-        sprintf(DataPacket.value, "ERR|Wrong number of arguments in SETI command");
+        sprintf(reply.value, "ERR|Wrong number of arguments in SETI command");
         retVal=FAIL_DATA;
     }
 
     if (retVal==SUCCESS_NODATA)
     {
         if (argCount==1) pid->SetTunings(kp, ki, kd);
-        sprintf(DataPacket.value, "OK|%ld", ki);
+        sprintf(reply.value, "OK|%f", ki);
         retVal = SUCCESS_DATA;
     }
     return(retVal);
@@ -230,7 +236,7 @@ ProcessStatus DEV_Pid::cmdSetI()
  * 
  * @return ProcessStatus 
  */
-ProcessStatus DEV_Pid::cmdSetD()
+ProcessStatus DEV_Pid::cmdSetD(CPacket &command, DPacket &reply)
 {
     ProcessStatus retVal=SUCCESS_NODATA;
     if (argCount == 1)
@@ -238,14 +244,14 @@ ProcessStatus DEV_Pid::cmdSetD()
         retVal=getDouble(0, &kd, "Kd ");
     } else if (argCount != 0)
     {
-        sprintf(DataPacket.value, "ERR|Wrong number of arguments in SETD command");
+        sprintf(reply.value, "ERR|Wrong number of arguments in SETD command");
         retVal=FAIL_DATA;
     }
 
     if (retVal==SUCCESS_NODATA)
     {
         if (argCount==1) pid->SetTunings(kp, ki, kd);
-        sprintf(DataPacket.value, "OK|%ld", kd);
+        sprintf(reply.value, "OK|%f", kd);
         retVal = SUCCESS_DATA;
     }
     return(retVal);
@@ -259,7 +265,7 @@ ProcessStatus DEV_Pid::cmdSetD()
  *    FORMAT: SMODE|<bool>
  * @return ProcessStatus 
  */
-ProcessStatus DEV_Pid::cmdSetMode()
+ProcessStatus DEV_Pid::cmdSetMode(CPacket &command, DPacket &reply)
 {
     ProcessStatus retVal = SUCCESS_NODATA;
     bool val=false;
@@ -274,7 +280,7 @@ ProcessStatus DEV_Pid::cmdSetMode()
     else if (argCount != 0)
     {
         // Error - wrong arg count
-        sprintf(DataPacket.value,"EROR| Wrong number of arguments");
+        sprintf(reply.value,"EROR| Wrong number of arguments");
         retVal = FAIL_DATA;
     }
 
@@ -284,7 +290,7 @@ ProcessStatus DEV_Pid::cmdSetMode()
         {
             pid->SetMode(val) ;
         }
-        sprintf(DataPacket.value, "SMOD|%s",  (pid->GetMode()==AUTOMATIC) ? "Automatic": "Manual" );
+        sprintf(reply.value, "SMOD|%s",  (pid->GetMode()==AUTOMATIC) ? "Automatic": "Manual" );
         retVal=SUCCESS_DATA;
     }
 
@@ -303,14 +309,20 @@ ProcessStatus DEV_Pid::cmdSetMode()
 /**
  * @brief  Command to Set the PID compute time (milliseconds)
  *    FORMAT: STIM|<time>
+ *    While a control loop clocks the PID, its period is set with the Driver's CRAT.
  * 
  * @return ProcessStatus 
  */
-ProcessStatus DEV_Pid::cmdSetSTime()
+ProcessStatus DEV_Pid::cmdSetSTime(CPacket &command, DPacket &reply)
 {
     ProcessStatus retVal = SUCCESS_NODATA;
     int32_t stime=mySampleTime;
-    if (argCount == 1)
+    if (argCount == 1 && controlLoopClock)
+    {
+        sprintf(reply.value,"EROR|STIM|Clocked by the control loop, use CRAT");
+        retVal = FAIL_DATA;
+    }
+    else if (argCount == 1)
     {
         if ( 0 != getInt32(1, &stime, "Bad mode "))
         {
@@ -320,7 +332,7 @@ ProcessStatus DEV_Pid::cmdSetSTime()
     } else if (argCount != 0) 
     {
         // Error - wrong arg count
-        sprintf(DataPacket.value,"ERRO| wrong number of arguments");
+        sprintf(reply.value,"ERRO| wrong number of arguments");
         retVal = FAIL_DATA;
     }
 
@@ -331,7 +343,7 @@ ProcessStatus DEV_Pid::cmdSetSTime()
             setSampleClock(mySampleTime);
             mySampleTime=stime;
         }
-        sprintf(DataPacket.value,"STIM|%s",  (pid->GetMode() ? "Enabled": "Disabled" ));
+        sprintf(reply.value,"STIM|%s",  (pid->GetMode() ? "Enabled": "Disabled" ));
         retVal=SUCCESS_DATA;
     }
 
@@ -345,6 +357,7 @@ ProcessStatus DEV_Pid::cmdSetSTime()
  */
 void DEV_Pid::setSampleClock(time_t intervalMs)
 {
+    if (controlLoopClock) return;   // the loop sets the period
     mySampleTime = intervalMs;
 
     pid->SetSampleTime(mySampleTime);
@@ -362,22 +375,78 @@ void DEV_Pid::setSampleClock(time_t intervalMs)
 /**
  * @brief Run the PID Comput function
  *    This is a callback from the high-priority timer task
- *    (NOTE: nothing done if ln298 is disabled, or pid is manual)
+ *    (only while no control loop clocks this PID, see clockFromControlLoop())
  * @param arg pointer to 'this' instance of DEV_Pid
  */
 void DEV_Pid::timer_callback(void *arg)
 {
     DEV_Pid *me = (DEV_Pid *)arg;
-    if (me->ln298->isDisabled() || (me->pid->GetMode()==MANUAL)) return;
+
+    if (me->computeOutput())
+    {
+        me->applyOutput();
+    }
+}
+
+
+/**
+ * @brief One PID pass: pick up the setpoint and actual speed, compute
+ *    (NOTE: nothing computed if ln298 is disabled, or pid is manual)
+ *    Runs on the PID clock's task only.
+ * @return true if there is a new output for applyOutput()
+ */
+bool DEV_Pid::computeOutput()
+{
+    bool computed = false;
 
     // The setpoint was previously set by calling 'setSpeed()'
-    // Get the 'actual' speed value from the QUAD.
-    me->actual = me->quad->getSpeed(); // get actual speed
-    
-    // RUN COMPUTE, set the new output
-    if (me->pid->ComputeFromTimer())
+    // Get the 'actual' speed value from the QUAD's observer.
+    setPoint = requestedSpeed.read();
+    actual = quad->getVelocity(); // get actual speed (filtered)
+
+    if (!ln298->isDisabled() && (pid->GetMode()!=MANUAL))
+    {
+        // RUN COMPUTE
+        computed = pid->ComputeFromTimer();
+    }
+
+    // Publish what this pass used, for the reports
+    state.write({setPoint, actual, output});
+    return(computed);
+}
+
+
+/**
+ * @brief Send the last computed output to the motor (ln298)
+ */
+void DEV_Pid::applyOutput()
+{
+    ln298->setPulseWidth(output);
+}
+
+
+/**
+ * @brief Hand the PID clock to a control loop
+ *    Stops the PIDtimer; from now on the loop calls computeOutput()
+ *    and applyOutput() every tick, and setLoopPeriod() when its rate changes.
+ */
+void DEV_Pid::clockFromControlLoop()
+{
+    controlLoopClock = true;
+    if (esp_timer_is_active(pidTimerhandle))
     {
-        // Now share the 'output' value...
-        me->ln298->setPulseWidth(me->output);
+        esp_timer_stop(pidTimerhandle);
     }
-}
\ No newline at end of file
+}
+
+
+/**
+ * @brief Set the sample time to the control loop period
+ *    (the Ki and Kd scaling follow it). Runs on the loop's task, like ComputeCore().
+ * @param periodUs - loop period, in microseconds
+ */
+void DEV_Pid::setLoopPeriod(time_t periodUs)
+{
+    pid->SetSampleTimeUs(periodUs);
+    mySampleTime = (periodUs + 500) / 1000;
+}
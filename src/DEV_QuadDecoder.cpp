@@ -13,20 +13,37 @@
 #include "esp_err.h"
 #include "esp_log_buffer.h"
 
-static const char *TAG="DEV_QuadDecoder";
 /**
  * @brief Construct a new Quad Decoder object
  * 
  * @param _node 
  * @param InName 
  */
-DEV_QuadDecoder::DEV_QuadDecoder(const char *InName): DefDevice(InName)
+DEV_QuadDecoder::DEV_QuadDecoder(const char *InName): DefDevice(InName),
+    observer(QUAD_OBS_PROCESS_NOISE, QUAD_OBS_MEASURE_NOISE)
 {
     myEncoder      = new ESP32Encoder;
     spdUpdateTimerhandle=nullptr;
     last_position  = 0;
     last_timecheck = 0;
-    last_speed = 0;
+    resetRequested = false;
+    restartPending = false;
+    controlLoopClock = false;
+    raw_count = 0;
+    sample_position = 0;
+    sample_edges = 0;
+    sample_edgeUs = 0;
+    sample_time = 0;
+    last_periodSpeed = 0;
+    edgeUs = 0;
+    edgeCount = 0;
+    last_edgeUs = 0;
+    last_edgeCount = 0;
+    last_edgePosition = 0;
+    observerTime = 0;
+    observerNoiseWrites = 0;
+    observerNoise.write({QUAD_OBS_PROCESS_NOISE, QUAD_OBS_MEASURE_NOISE});
+    position.write({0, 0});
     setPhysParams(QUAD_PULSES_PER_REV, WHEEL_DIAM_MM);
     currentSpdCheckRate = SPEED_CHECK_INTERVAL_mSec;
 }
@@ -54,6 +71,10 @@ void DEV_QuadDecoder::setup(MotorControl_config_t *cfg)
     myEncoder->attachFullQuad(cfg->quad_pin_a, cfg->quad_pin_b);
     resetPosition();
 
+    // Timestamp every edge of both channels (the PCNT still does the counting)
+    attachInterruptArg(cfg->quad_pin_a, edge_isr, this, CHANGE);
+    attachInterruptArg(cfg->quad_pin_b, edge_isr, this, CHANGE);
+
     // Set up the speed update clock
      // speed check timer
     esp_timer_create_args_t speed_timer_args =
@@ -74,74 +95,253 @@ void DEV_QuadDecoder::setup(MotorControl_config_t *cfg)
     Serial.printf("... Interval is %d (mseconds)\n\r", SPEED_CHECK_INTERVAL_mSec);
 
     periodicEnabled = false; // Default is no report.
+    immediateEnabled = false; // Speed is updated by the timer, nothing to do continuously
     return;
 }
 
 
+/**
+ * @brief Encoder edge interrupt: remember when the count last changed
+ *
+ * @param arg - pointer to the appropriate DEV_QuadDecoder instance
+ */
+void IRAM_ATTR DEV_QuadDecoder::edge_isr(void *arg)
+{
+    DEV_QuadDecoder *me = (DEV_QuadDecoder *)arg;
+    me->edgeUs = (uint32_t)esp_timer_get_time();
+    me->edgeCount = me->edgeCount + 1;   // after edgeUs, see sampleCount()
+}
+
+
 /**
  * @brief Called by High res timer to update the speed
- * 
+ *   (only while no control loop clocks this decoder, see clockFromControlLoop())
+ *
  * @param arg - pointer to the appropriate DEV_QuadDecoder instance
  */
 void DEV_QuadDecoder::update_speed_cb(void *arg)
 {
     DEV_QuadDecoder *me = (DEV_QuadDecoder *)arg;
-    pulse_t pos_diff;
-    time_t  now  = esp_timer_get_time();
-    time_t  elapsed;
-    pulse_t pos_now = me->myEncoder->getCount();
-
-    // Deltas
-    pos_diff = (pos_now - me->last_position);
-    elapsed  = (now - me->last_timecheck)/1000;
-
-    // Calc speed
-    me->last_speed = ( ((double)pos_diff) * me->pulsesToDist) / ((double)elapsed);
-   //Serial.printf(" position pulsesRoDist %lf  diff %ld elapsed= %lld speed=%lf\r\n", 
-   //     me->pulsesToDist, pos_diff, elapsed, me->last_speed);
-    me->last_position = me->myEncoder->getCount();
-    me->last_timecheck = now;
+    me->sampleCount(esp_timer_get_time());
+    me->updateSpeed();
+}
+
+
+/**
+ * @brief Take the count and latest edge for the next updateSpeed()
+ *   The control loop calls this for both wheels back to back, with the
+ *   same <now>, so both speeds are measured over the same interval.
+ *
+ *   The position is accumulated here, in 64 bits, from the change in the
+ *   encoder's count since the last sample (its low 32 bits, so a 32-bit
+ *   wrap in between is just a small difference). It never wraps, and
+ *   QRST starts it over without touching the encoder. The distance for
+ *   getPosition() is worked out once, here.
+ *
+ * @param now - esp_timer time of this sample, in uSecs
+ */
+void DEV_QuadDecoder::sampleCount(time_t now)
+{
+    pulse_t raw;
+
+    // The latest edge and the count it left (again if an edge comes in between)
+    do
+    {
+        sample_edges  = edgeCount;
+        sample_edgeUs = edgeUs;
+        raw = (pulse_t)myEncoder->getCount();
+    } while (sample_edges != edgeCount);
+
+    // QRST: this sample is position 0
+    if (resetRequested.exchange(false))
+    {
+        restartPending  = true;
+        sample_position = 0;
+    } else {
+        sample_position += (pulse_t)((uint32_t)raw - (uint32_t)raw_count);
+    }
+    raw_count   = raw;
+    sample_time = now;
+    position.write({sample_position, sample_position * pulsesToDist});
+}
+
+
+/**
+ * @brief Update the speed from the last sampleCount()
+ *
+ *   Two estimates are made, both in the same units (distance per mSec):
+ *   - count delta: counts in this check / time since the last check.
+ *     Good when many counts arrive; at crawl speed it is 0 or 1 count.
+ *   - edge period: counts between the last edge before the previous check and the
+ *     last edge before this one / the time between those two edges, measured
+ *     in uSecs. Exact to one count even at one count per check. With no edge
+ *     in a check the speed can be no more than one count since the last edge,
+ *     so the estimate decays toward 0, and is 0 after QUAD_STOP_TIMEOUT_uSec.
+ *   They are blended on the counts in this check: edge period only up to
+ *   QUAD_BLEND_LOW_COUNTS, count delta only from QUAD_BLEND_HIGH_COUNTS.
+ */
+void DEV_QuadDecoder::updateSpeed()
+{
+    pulse64_t pos_now = sample_position;
+    uint32_t edges   = sample_edges;
+    uint32_t edge_at = sample_edgeUs;
+    time_t   now     = sample_time;
+
+    // QRST: start over from position 0 (this task owns the estimator state)
+    if (restartPending)
+    {
+        restartPending    = false;
+        last_position     = pos_now;
+        last_timecheck    = now;
+        last_periodSpeed  = 0;
+        last_edgeUs       = (uint32_t)now;
+        last_edgeCount    = edges;
+        last_edgePosition = pos_now;
+        last_speed.write(0);
+        observer.reset(pos_now + 0.5);
+        observerTime = now;
+        estimate.write({observer.position() * pulsesToDist, 0, 0});
+        return;
+    }
+
+    bool    newEdge  = (edges != last_edgeCount);
+    double  elapsed  = (double)(now - last_timecheck);
+    pulse_t pos_diff = (pulse_t)(pos_now - last_position);
+    double  countsToSpeed = pulsesToDist * 1000.0;   // counts per uSec -> distance per mSec
+
+    // Count delta
+    double deltaSpeed = (elapsed > 0) ? (pos_diff * countsToSpeed) / elapsed : 0;
+
+    // Edge period
+    if (edges != last_edgeCount)
+    {
+        uint32_t span = edge_at - last_edgeUs;
+        if (span > QUAD_STOP_TIMEOUT_uSec)
+            span = edge_at - (uint32_t)last_timecheck;   // starting from a stop: time it from this check
+        if (span > 0)
+            last_periodSpeed = ((pos_now - last_edgePosition) * countsToSpeed) / span;
+
+        last_edgeUs       = edge_at;
+        last_edgeCount    = edges;
+        last_edgePosition = pos_now;
+    }
+    else if (pos_diff != 0)
+    {
+        last_periodSpeed = deltaSpeed;   // counting without edge interrupts
+    }
+    else
+    {
+        uint32_t since = (uint32_t)now - last_edgeUs;
+        double   bound = countsToSpeed / since;
+        if (since > QUAD_STOP_TIMEOUT_uSec)
+            last_periodSpeed = 0;
+        else if (fabs(last_periodSpeed) > bound)
+            last_periodSpeed = copysign(bound, last_periodSpeed);
+    }
+
+    // Blend
+    double weight = (double)(abs(pos_diff) - QUAD_BLEND_LOW_COUNTS) / (QUAD_BLEND_HIGH_COUNTS - QUAD_BLEND_LOW_COUNTS);
+    weight = constrain(weight, 0.0, 1.0);
+    last_speed.write(weight * deltaSpeed + (1.0 - weight) * last_periodSpeed);
+
+    updateObserver(pos_now, pos_diff, newEdge, edge_at, now);
+
+    last_position  = pos_now;
+    last_timecheck = now;
 
     return;
 }
 
 
+/**
+ * @brief Move the observer (see Observer.h) up to this speed check
+ *
+ *   Count <c> means the wheel is between boundaries c and c+1 (in counts).
+ *   - With a new edge, the wheel was exactly on a boundary at the edge's
+ *     time: c if it moved up, c+1 if it moved down. The observer is moved
+ *     to that time, corrected, then moved on to <now>.
+ *   - Counting without edge interrupts: corrected with the middle, c+0.5.
+ *   - No count change: it is only corrected if it has left [c, c+1] by more
+ *     than QUAD_OBS_CELL_MARGIN (real edges are not evenly spaced), and its
+ *     velocity is held to what no edge for that long allows
+ *     (QUAD_OBS_BOUND_COUNTS since the last edge), 0 after QUAD_STOP_TIMEOUT_uSec.
+ *   Runs on the speed clock's task, after the speed update.
+ */
+void DEV_QuadDecoder::updateObserver(pulse64_t pos_now, pulse_t pos_diff, bool newEdge, uint32_t edge_at, time_t now)
+{
+    // New noise settings from QOBS
+    if (observerNoise.writes() != observerNoiseWrites)
+    {
+        observerNoiseWrites = observerNoise.writes();
+        ObserverNoise noise = observerNoise.read();
+        observer.setNoise(noise.process, noise.measurement);
+    }
+
+    if (newEdge && (pos_diff != 0))
+    {
+        // esp_timer time of the edge, from its low 32 bits (not before the last check)
+        int32_t age = (int32_t)((uint32_t)now - edge_at);
+        time_t  edgeTime = now - ((age > 0) ? age : 0);
+        if (edgeTime < observerTime) edgeTime = observerTime;
+
+        observer.predict((edgeTime - observerTime) / 1000000.0);
+        observer.correct((pos_diff > 0) ? pos_now : pos_now + 1);
+        observer.predict((now - edgeTime) / 1000000.0);
+    }
+    else if (pos_diff != 0)
+    {
+        observer.update(pos_now + 0.5, (now - observerTime) / 1000000.0);
+    }
+    else
+    {
+        observer.predict((now - observerTime) / 1000000.0);
+        if (observer.position() > pos_now + 1 + QUAD_OBS_CELL_MARGIN)
+            observer.correct(pos_now + 1);
+        else if (observer.position() < pos_now - QUAD_OBS_CELL_MARGIN)
+            observer.correct(pos_now);
+
+        uint32_t since = (uint32_t)now - last_edgeUs;
+        if (since > QUAD_STOP_TIMEOUT_uSec)
+            observer.limitVelocity(0);
+        else if (since > 0)
+            observer.limitVelocity(QUAD_OBS_BOUND_COUNTS * 1000000.0 / since);
+    }
+    observerTime = now;
+
+    // counts, counts/sec, counts/sec^2 -> distance, distance/mSec, distance/mSec^2
+    estimate.write({observer.position() * pulsesToDist,
+                    observer.velocity() * pulsesToDist / 1000.0,
+                    observer.acceleration() * pulsesToDist / 1000000.0});
+}
+
+
 /**
  * @brief
  *
  * @return ProcessStatus
  */
-ProcessStatus DEV_QuadDecoder::ExecuteCommand()
+ProcessStatus DEV_QuadDecoder::ExecuteCommand(CPacket &command, DPacket &reply)
 {
     ProcessStatus retVal = NOT_HANDLED;
-    dist_t wheelDia;
-    uint32_t pulseCnt;
-    DataPacket.timestamp = millis();
-    retVal = Device::ExecuteCommand();
+    reply.timestamp = millis();
+    retVal = Device::ExecuteCommand(command, reply);
     if (retVal != NOT_HANDLED )  return(retVal);
 
-    scanParam();
-   if (isCommand("QSET")) 
-    {   // set wheel dia and pulses. 
-        retVal = qsetCommand();
-
-    } else if (isCommand("QRST"))
-    {  // Reset position
-        resetPosition();
-        retVal=SUCCESS_NODATA;
-
-    } else if (isCommand("QSCK"))
-    {  // Set the speed Check Interval
-        retVal = qsckCommand();        
-    } else 
+    // Look up the command in commandTable (see DEV_QuadDecoder.h)
+    const CommandEntry<CommandHandler<DEV_QuadDecoder>> *entry = FindCommand(commandTable, command.key);
+    if (entry != nullptr)
+    {
+        scanParam(command, reply);
+        retVal = (this->*entry->handler)(command, reply);
+    } else
     {
-        sprintf(DataPacket.value, "EROR|Quad|Unknown command:%s", CommandPacket.command);
+        sprintf(reply.value, "EROR|Quad|Unknown command:%s", command.command);
         retVal=FAIL_DATA;
     }
 
     if (retVal == SUCCESS_NODATA)
     {
-        sprintf(DataPacket.value, "OK");
+        sprintf(reply.value, "OK");
         retVal = SUCCESS_DATA;
     }
     return(retVal);
@@ -153,15 +353,41 @@ ProcessStatus DEV_QuadDecoder::ExecuteCommand()
  *
  * @return ProcessStatus
  */
-ProcessStatus DEV_QuadDecoder::DoPeriodic()
+ProcessStatus DEV_QuadDecoder::DoPeriodic(DPacket &packet)
 {
     ProcessStatus retVal = SUCCESS_DATA;
-    sprintf(DataPacket.value, "%f|%f|%s", getPosition(), last_speed, name);
+    packet.timestamp = (unsigned long)(ScheduledTimeUs() / 1000);   // on the period grid, no loop jitter
+    packet.ClearFields();
+    packet.AddFloatField(getPosition());
+    packet.AddFloatField(getSpeed());
+    packet.AddTextField(name);
+    Estimate est = estimate.read();
+    packet.AddFloatField(est.velocity);
+    packet.AddFloatField(est.acceleration);
 
     return(retVal);
 }
 
 
+/**
+ * @brief Sample one field of the periodic report, for a subscription (SSUB)
+ *    Field 0 is the position, field 1 the speed, field 3 the observer's
+ *    velocity and field 4 its acceleration. The name (2) is not sampled.
+ * @return false if there is no such field
+ */
+bool DEV_QuadDecoder::SampleField(int field, DPacket &packet)
+{
+    switch (field)
+    {
+        case 0:  packet.AddFloatField(getPosition());  return(true);
+        case 1:  packet.AddFloatField(getSpeed());     return(true);
+        case 3:  packet.AddFloatField(estimate.read().velocity);      return(true);
+        case 4:  packet.AddFloatField(estimate.read().acceleration);  return(true);
+    }
+    return(false);
+}
+
+
 /**
  * @brief Set the pulses/routation and wheel diam
  *   Format: QSET
@@ -176,7 +402,7 @@ ProcessStatus DEV_QuadDecoder::DoPeriodic()
  *
  * @return ProcessStatus
  */
-ProcessStatus DEV_QuadDecoder::qsetCommand()
+ProcessStatus DEV_QuadDecoder::qsetCommand(CPacket &command, DPacket &reply)
 {
     ProcessStatus retVal = SUCCESS_NODATA;
     double wheel;   // temporary wheel diameter
@@ -195,12 +421,12 @@ ProcessStatus DEV_QuadDecoder::qsetCommand()
         {
             if (pulses < 0)
             {
-                sprintf(DataPacket.value, "EROR|Pulse count must be >0");
+                sprintf(reply.value, "EROR|Pulse count must be >0");
                 retVal = FAIL_DATA;
             }
             else if (wheel < 0)
             {
-                sprintf(DataPacket.value, "EROR|WheelDiam must be >0");
+                sprintf(reply.value, "EROR|WheelDiam must be >0");
                 retVal = FAIL_DATA;
             }
             else
@@ -212,14 +438,14 @@ ProcessStatus DEV_QuadDecoder::qsetCommand()
 
     } else if (argCount !=0 )
     {
-        sprintf(DataPacket.value, "ERRR| wrong number of arguments");
+        sprintf(reply.value, "ERRR| wrong number of arguments");
         retVal = FAIL_DATA;
     }
 
     if (retVal == SUCCESS_NODATA)
     {
         // Show the current parameters
-        sprintf(DataPacket.value, "QSET|%f|%lld|%8.5f", wheelDiam, pulsesPerRev, pulsesToDist);
+        sprintf(reply.value, "QSET|%f|%ld|%8.5f", wheelDiam, (long)pulsesPerRev, pulsesToDist);
         retVal = SUCCESS_DATA;
     }
 
@@ -232,13 +458,20 @@ ProcessStatus DEV_QuadDecoder::qsetCommand()
  *    Format:  QSCK|<period>
  *             <period> is the time period between speed
  *                      checks, in milliseconds
+ *    While a control loop clocks this decoder, the period
+ *    can only be read (set it with the Driver's CRAT).
  * @return ProcessStatus
  */
-ProcessStatus DEV_QuadDecoder::qsckCommand()
+ProcessStatus DEV_QuadDecoder::qsckCommand(CPacket &command, DPacket &reply)
 {
     ProcessStatus retVal = SUCCESS_NODATA;
-    time_t newclkRate = 0;
-    if (argCount == 1)
+    long long newclkRate = 0;
+    if (argCount == 1 && controlLoopClock)
+    {
+        sprintf(reply.value, "EROR|QSCK|Clocked by the control loop, use CRAT");
+        retVal = FAIL_DATA;
+    }
+    else if (argCount == 1)
     {
         if (SUCCESS_NODATA != getLLint(0, &newclkRate, "Speed check rate "))
         {
@@ -250,14 +483,14 @@ ProcessStatus DEV_QuadDecoder::qsckCommand()
 
     } else if (argCount != 0)
     {
-        sprintf(DataPacket.value, "ERRR| wrong number of arguments");
+        sprintf(reply.value, "ERRR| wrong number of arguments");
         retVal = FAIL_DATA;
 
     }
 
     if (retVal == SUCCESS_NODATA)
     {
-        sprintf(DataPacket.value, "OK|SCLK|%lld", currentSpdCheckRate);
+        sprintf(reply.value, "OK|SCLK|%lld", (long long)currentSpdCheckRate);
         retVal=SUCCESS_DATA;
     }
     return (retVal);
@@ -292,6 +525,7 @@ void DEV_QuadDecoder::setPhysParams(pulse_t pulseCnt, double diam)
  */
 void DEV_QuadDecoder::setSpeedCheckInterval(time_t interval)
 {
+    if (controlLoopClock) return;   // the loop sets the period
     currentSpdCheckRate = interval * 1000;
     if (esp_timer_is_active(spdUpdateTimerhandle))
     {
@@ -302,27 +536,80 @@ void DEV_QuadDecoder::setSpeedCheckInterval(time_t interval)
     return;
 }
 
+/**
+ * @brief Hand the speed checks to a control loop
+ *    Stops the SpeedTimer; from now on the loop calls sampleCount()
+ *    and updateSpeed() every tick.
+ */
+void DEV_QuadDecoder::clockFromControlLoop()
+{
+    controlLoopClock = true;
+    if (esp_timer_is_active(spdUpdateTimerhandle))
+    {
+        ESP_ERROR_CHECK(esp_timer_stop(spdUpdateTimerhandle));
+    }
+    return;
+}
+
+/**
+ * @brief Record the control loop period (reported by QSCK)
+ *
+ * @param periodUs - the loop period, in uSecs
+ */
+void DEV_QuadDecoder::setLoopPeriod(time_t periodUs)
+{
+    currentSpdCheckRate = periodUs;
+    return;
+}
+
 /**
  * @brief Return the last calculated position.
- *   (this is in engineering units)
- * @return pulse_t
+ *   (this is in engineering units, as of the latest speed check)
+ * @return double
  */
 double DEV_QuadDecoder::DEV_QuadDecoder::getPosition()
 {
-    double result= myEncoder->getCount() * pulsesToDist;
-    return(result);
+    return(position.read().distance);
 }
 
 /**
- * @brief Reset the position, speed, etc to 0
+ * @brief Return the accumulated encoder count (64 bits, does not wrap)
+ *   (as of the latest speed check)
+ * @return pulse64_t
+ */
+pulse64_t DEV_QuadDecoder::getCount()
+{
+    return(position.read().count);
+}
+
+/**
+ * @brief QRST command - reset the position
  *
+ * @return ProcessStatus
+ */
+ProcessStatus DEV_QuadDecoder::qrstCommand(CPacket &command, DPacket &reply)
+{
+    resetPosition();
+    return(SUCCESS_NODATA);
+}
+
+/**
+ * @brief Reset the position, speed, etc to 0
+ *   The position and speed estimate restart at the next speed check.
+ *   (The encoder keeps counting, so no count is lost to the reset.)
  */
 void DEV_QuadDecoder::resetPosition()
 {
-    myEncoder->clearCount();
-    last_position = 0;
-    last_timecheck = millis();
-    last_speed = 0;
+    resetRequested = true;
+}
+
+/**
+ * Retrieve the count taken by the latest sampleCount()
+ *   (For the control loop, which samples it; on another task it may be mid-update.)
+ */
+pulse64_t DEV_QuadDecoder::getSampledCount()
+{
+    return(sample_position);
 }
 
 /**
@@ -330,5 +617,95 @@ void DEV_QuadDecoder::resetPosition()
  */
 double DEV_QuadDecoder::getSpeed()
 {
-    return(last_speed);
-}
\ No newline at end of file
+    return(last_speed.read());
+}
+
+/**
+ * Retrieve the observer's velocity (same units as getSpeed())
+ */
+double DEV_QuadDecoder::getVelocity()
+{
+    return(estimate.read().velocity);
+}
+
+/**
+ * Retrieve the observer's position, velocity and acceleration, all from one speed check
+ */
+DEV_QuadDecoder::Estimate DEV_QuadDecoder::getEstimate()
+{
+    return(estimate.read());
+}
+
+/**
+ * @brief Set the observer noise parameters (see Observer.h)
+ *   Taken up at the next speed check.
+ * @param processNoise     - jerk density, counts^2/sec^5
+ * @param measurementNoise - variance of a count reading, counts^2
+ */
+void DEV_QuadDecoder::setObserverNoise(double processNoise, double measurementNoise)
+{
+    observerNoise.write({processNoise, measurementNoise});
+}
+
+/**
+ * @brief Get or set the observer noise parameters
+ *    Format:  QOBS                 - get them
+ *    Format:  QOBS|<process>|<measurement>
+ *             <process>     jerk density, counts^2/sec^5 (larger follows
+ *                           speed changes faster, but is noisier)
+ *             <measurement> variance of a count reading, counts^2
+ *                           (1/12 is quantization alone)
+ * @return ProcessStatus
+ */
+ProcessStatus DEV_QuadDecoder::qobsCommand(CPacket &command, DPacket &reply)
+{
+    ProcessStatus retVal = SUCCESS_NODATA;
+    ObserverNoise noise = observerNoise.read();
+
+    if (argCount == 2)
+    {
+        if (SUCCESS_NODATA != getDouble(0, &noise.process, "Process noise: "))
+        {
+            retVal = FAIL_DATA;
+        }
+        else if (SUCCESS_NODATA != getDouble(1, &noise.measurement, "Measurement noise: "))
+        {
+            retVal = FAIL_DATA;
+        }
+        else if ((noise.process <= 0) || (noise.measurement <= 0))
+        {
+            sprintf(reply.value, "EROR|QOBS|Noise values must be >0");
+            retVal = FAIL_DATA;
+        }
+        else
+        {
+            setObserverNoise(noise.process, noise.measurement);
+        }
+    } else if (argCount != 0)
+    {
+        sprintf(reply.value, "ERRR| wrong number of arguments");
+        retVal = FAIL_DATA;
+    }
+
+    if (retVal == SUCCESS_NODATA)
+    {
+        sprintf(reply.value, "QOBS|%g|%g", noise.process, noise.measurement);
+        retVal = SUCCESS_DATA;
+    }
+    return(retVal);
+}
+
+/**
+ * @brief Report the observer's estimate
+ *    Format:  QEST
+ *    Reply:   QEST|<position>|<velocity>|<acceleration>
+ *    (the position is continuous: count c covers c to c+1, so at rest
+ *     it is up to one count more than getPosition())
+ * @return ProcessStatus
+ */
+ProcessStatus DEV_QuadDecoder::qestCommand(CPacket &command, DPacket &reply)
+{
+    Estimate est = estimate.read();
+    sprintf(reply.value, "QEST|%f|%f|%f", est.position, est.velocity, est.acceleration);
+    return(SUCCESS_DATA);
+}
@@ -98,6 +98,7 @@ void DEV_LN298::setupLN298(MotorControl_config_t *cfg)
     } ;
     ESP_ERROR_CHECK(ledc_channel_config( &chnl_config));
     periodicEnabled=false;
+    immediateEnabled=false;   // Nothing to do continuously
 }
 
 /**
@@ -120,39 +121,30 @@ bool DEV_LN298::isDisabled()
  * 
  * @return ProcessStatus 
  */
-ProcessStatus DEV_LN298::ExecuteCommand()
+ProcessStatus DEV_LN298::ExecuteCommand(CPacket &command, DPacket &reply)
 {
 
     ProcessStatus retVal = SUCCESS_NODATA;
-    retVal = Device::ExecuteCommand();
+    retVal = Device::ExecuteCommand(command, reply);
     if (retVal == NOT_HANDLED)
     {
-
-        scanParam();
-
-        if (isCommand("SPWM"))
-        { 
-            retVal=setPulseWidthCommand();
-        }
-        else if (isCommand("ENAB"))
-        { // Enable
-            retVal =enable(true);
-        }
-
-        else if (isCommand("DISA"))
-        { // Disable
-            retVal =disable(true);
+        // Look up the command in commandTable (see DEV_ln298.h)
+        const CommandEntry<CommandHandler<DEV_LN298>> *entry = FindCommand(commandTable, command.key);
+        if (entry != nullptr)
+        {
+            scanParam(command, reply);
+            retVal = (this->*entry->handler)(command, reply);
         }
         else
         {
-            sprintf(DataPacket.value, "EROR|LN298|Unknown command");
+            sprintf(reply.value, "EROR|LN298|Unknown command");
             retVal = FAIL_DATA;
         }
     }
 
     if (retVal == SUCCESS_NODATA)
     {
-        sprintf(DataPacket.value, "OK|%d|%s", ledc_get_duty(LEDC_MODE, led_channel), (motorStatus = MOTOR_DIS) ? "DIS" : "ENA");
+        sprintf(reply.value, "OK|%d|%s", ledc_get_duty(LEDC_MODE, led_channel), (motorStatus = MOTOR_DIS) ? "DIS" : "ENA");
         retVal = SUCCESS_DATA;
     }
 
@@ -164,20 +156,35 @@ ProcessStatus DEV_LN298::ExecuteCommand()
  * 
  * @return ProcessStatus 
  */
- ProcessStatus DEV_LN298::DoPeriodic()
+ ProcessStatus DEV_LN298::DoPeriodic(DPacket &packet)
  {
-        DataPacket.timestamp = millis();
-        sprintf(DataPacket.value, "L298|%d|%s", lastPcnt, (motorStatus == MOTOR_DIS)?"DIS":"ENA");
+        packet.timestamp = millis();
+        packet.ClearFields();
+        packet.AddTextField("L298");
+        packet.AddIntField(lastPcnt);
+        packet.AddTextField((motorStatus == MOTOR_DIS)?"DIS":"ENA");
         return (SUCCESS_DATA);
  }
 
+/**
+ * @brief Sample one field of the periodic report, for a subscription (SSUB)
+ *   Field 1 is the pulse width (percent). The text fields are not sampled.
+ * @return false if there is no such field
+ */
+bool DEV_LN298::SampleField(int field, DPacket &packet)
+{
+    if (field != 1) return(false);
+    packet.AddIntField(lastPcnt);
+    return(true);
+}
+
 /**
  * @brief process the SPWM  (set pulse width) command
  *   Format: SPWM <pulseWidt>
  *      <pulseWidth> is percentage -
  *                   positive for forward, negative is reverse
  */
-ProcessStatus DEV_LN298::setPulseWidthCommand()
+ProcessStatus DEV_LN298::setPulseWidthCommand(CPacket &command, DPacket &reply)
 {
     ProcessStatus retVal = SUCCESS_NODATA;
     int32_t val = 0;
@@ -186,13 +193,13 @@ ProcessStatus DEV_LN298::setPulseWidthCommand()
     {
         if ((val < -100) || (val > 100))
         {
-            sprintf(DataPacket.value, "EROR|SPWM|%s|Value must be 0 +/- 100", GetName());
+            sprintf(reply.value, "EROR|SPWM|%s|Value must be 0 +/- 100", GetName());
             retVal = FAIL_DATA;
         }
 
         else if (motorStatus == MOTOR_DIS)
         {
-            sprintf(DataPacket.value, "EROR|SPWM|%s is not enabled", GetName());
+            sprintf(reply.value, "EROR|SPWM|%s is not enabled", GetName());
             retVal = FAIL_DATA;
         }
     }
@@ -204,10 +211,10 @@ ProcessStatus DEV_LN298::setPulseWidthCommand()
             setPulseWidth((int)val);
         }
  
-        sprintf(DataPacket.value, "OK|SPWM|Pulse width is %d", lastPcnt);
+        sprintf(reply.value, "OK|SPWM|Pulse width is %d", lastPcnt);
         retVal = SUCCESS_DATA;
     }
-    DataPacket.timestamp = millis();
+    reply.timestamp = millis();
     return (retVal);
 }
 
@@ -256,8 +263,6 @@ bool DEV_LN298::setPulseWidth(int pcnt)
  */
 void DEV_LN298::setDirection(int pcnt)
 {
-    ProcessStatus retVal=SUCCESS_NODATA;
-
     if (motorStatus == MOTOR_DIS) return;
     if (pcnt>=0)
     {  // forward
@@ -273,16 +278,31 @@ void DEV_LN298::setDirection(int pcnt)
     }
 }
 
+/**
+ * @brief DISA / ENAB commands - disable or enable the motor driver
+ * 
+ * @return ProcessStatus 
+ */
+ProcessStatus DEV_LN298::disableCommand(CPacket &command, DPacket &reply)
+{
+    return(disable(&reply));
+}
+
+ProcessStatus DEV_LN298::enableCommand(CPacket &command, DPacket &reply)
+{
+    return(enable(&reply));
+}
+
 /**
  * @brief Disable the motor driver
  *     This is shared as a SMAC command and (optionally) a
  * method call from an external function.
  * 
- * @param isRemoteCmd - if true, then we send an 'ok' message via SMAC.
+ * @param reply - if not null (a SMAC command), an 'ok' message is put in this reply packet.
  * @return ProcessStatus - SUCCESS_DATA if this is a remote command,
  *                         SUCCESS_NODATA if this is not a remote command
  */
-ProcessStatus DEV_LN298::disable(bool isRemoteCmd)
+ProcessStatus DEV_LN298::disable(DPacket *reply)
 {
     ProcessStatus retVal = SUCCESS_NODATA;
     setPulseWidth(0);
@@ -291,11 +311,11 @@ ProcessStatus DEV_LN298::disable(bool isRemoteCmd)
     gpio_set_level(ena_pin, false);
     motorStatus=MOTOR_DIS;
     ledc_stop(LEDC_MODE, led_channel, 0 );
-    if (isRemoteCmd)
+    if (reply != nullptr)
     {
-        DataPacket.timestamp = millis();
+        reply->timestamp = millis();
         retVal = SUCCESS_DATA;
-        sprintf(DataPacket.value, "OK|DISA|%s Disabled", GetName());    
+        sprintf(reply->value, "OK|DISA|%s Disabled", GetName());    
     }
     return(retVal);
 }
@@ -306,11 +326,11 @@ ProcessStatus DEV_LN298::disable(bool isRemoteCmd)
  *    *     This is shared as a SMAC command and (optionally) a
  * method call from an external function.
  * 
- * @param isRemoteCmd  if true, then a response message is sent via SMAC.
+ * @param reply  if not null (a SMAC command), a response message is put in this reply packet.
  * @return ProcessStatus - SUCCESS_DATA if this is a remote command,
  *                         SUCCESS_NODATA if this is not a remote command
  */
-ProcessStatus DEV_LN298::enable(bool isRemoteCmd)
+ProcessStatus DEV_LN298::enable(DPacket *reply)
 {
     ProcessStatus retVal = SUCCESS_NODATA;
 
@@ -318,10 +338,10 @@ ProcessStatus DEV_LN298::enable(bool isRemoteCmd)
     setPulseWidth(0);
     motorStatus = MOTOR_IDLE;
 
-    if (isRemoteCmd)
+    if (reply != nullptr)
     {
-        DataPacket.timestamp = millis();
-        sprintf(DataPacket.value, "OK|ENAB|%s enabled", GetName());
+        reply->timestamp = millis();
+        sprintf(reply->value, "OK|ENAB|%s enabled", GetName());
         retVal = SUCCESS_DATA;
     }
     
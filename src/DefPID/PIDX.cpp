@@ -8,7 +8,8 @@
  * This library is Copyright (@)Doug Fajardo 7/2025
  * Changes from Arduino PID library:
  * (1) Change name from PID to PIDX.
- * (2) 
+ * (2) ComputeFromTimer()/ComputeCore() for callers that keep their own clock.
+ * (3) SetSampleTimeUs(), for sample times that are not whole milliseconds.
  **********************************************************************************************/
 
 #if ARDUINO >= 100
@@ -35,6 +36,7 @@ PIDX::PIDX(double* Input, double* Output, double* Setpoint,
 												//the arduino pwm limits
 
     SampleTime = 100;							//default Controller Sample Time is 0.1 seconds
+    SampleTimeUs = 100000;
 
     PIDX::SetControllerDirection(ControllerDirection);
     PIDX::SetTunings(Kp, Ki, Kd, POn);
@@ -133,7 +135,7 @@ void PIDX::SetTunings(double Kp, double Ki, double Kd, int POn)
 
    dispKp = Kp; dispKi = Ki; dispKd = Kd;
 
-   double SampleTimeInSec = ((double)SampleTime)/1000;
+   double SampleTimeInSec = ((double)SampleTimeUs)/1000000;
    kp = Kp;
    ki = Ki * SampleTimeInSec;
    kd = Kd / SampleTimeInSec;
@@ -160,11 +162,24 @@ void PIDX::SetSampleTime(int NewSampleTime)
 {
    if (NewSampleTime > 0)
    {
-      double ratio  = (double)NewSampleTime
-                      / (double)SampleTime;
+      SetSampleTimeUs((unsigned long)NewSampleTime * 1000);
+   }
+}
+
+/* SetSampleTimeUs(...) *******************************************************
+ * sets the period, in Microseconds, at which the calculation is performed.
+ * Compute() still times itself in whole milliseconds.
+ ******************************************************************************/
+void PIDX::SetSampleTimeUs(unsigned long NewSampleTimeUs)
+{
+   if (NewSampleTimeUs > 0)
+   {
+      double ratio  = (double)NewSampleTimeUs
+                      / (double)SampleTimeUs;
       ki *= ratio;
       kd /= ratio;
-      SampleTime = (unsigned long)NewSampleTime;
+      SampleTimeUs = NewSampleTimeUs;
+      SampleTime = (NewSampleTimeUs + 500) / 1000;
    }
 }
 
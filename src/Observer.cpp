@@ -0,0 +1,140 @@
+/**
+ * @file Observer.cpp
+ * @author Doug Fajardo
+ * @brief Kalman observer of a wheel's position, velocity and acceleration
+ * @version 0.1
+ * @date 2025-09-14
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * See Observer.h
+ */
+#include "Observer.h"
+#include <math.h>
+
+// - - - - - - - - - - - - - - - - - - - -
+Observer::Observer(double processNoise, double measurementNoise)
+{
+    setNoise(processNoise, measurementNoise);
+    reset(0);
+}
+
+
+/**
+ * @brief Start over: at <position>, with unknown velocity and acceleration
+ */
+void Observer::reset(double position)
+{
+    x[0] = position;
+    x[1] = 0;
+    x[2] = 0;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            P[i][j] = 0;
+    P[0][0] = r;
+    P[1][1] = OBSERVER_INIT_VARIANCE;
+    P[2][2] = OBSERVER_INIT_VARIANCE;
+}
+
+
+/**
+ * @brief Set the noise parameters (see Observer.h)
+ *    Values that are not > 0 are ignored.
+ */
+void Observer::setNoise(double processNoise, double measurementNoise)
+{
+    if (processNoise > 0)     q = processNoise;
+    if (measurementNoise > 0) r = measurementNoise;
+}
+
+
+/**
+ * @brief Move the estimate <dtSec> ahead, then correct it with a count
+ *
+ * @param measuredPosition - encoder count now
+ * @param dtSec            - time since the last update, in seconds
+ */
+void Observer::update(double measuredPosition, double dtSec)
+{
+    predict(dtSec);
+    correct(measuredPosition);
+}
+
+
+/**
+ * @brief Move the estimate <dtSec> ahead (no measurement)
+ */
+void Observer::predict(double dtSec)
+{
+    double dt  = dtSec;
+    double dt2 = dt * dt;
+    double dt3 = dt2 * dt;
+
+    if (dt <= 0) return;
+
+    // x = F x,  F = | 1  dt  dt^2/2 |
+    //               | 0   1  dt     |
+    //               | 0   0   1     |
+    x[0] += x[1] * dt + x[2] * dt2 / 2;
+    x[1] += x[2] * dt;
+
+    // P = F P F' + Q  (F P first, then times F')
+    double FP[3][3];
+    for (int j = 0; j < 3; j++)
+    {
+        FP[0][j] = P[0][j] + dt * P[1][j] + dt2 / 2 * P[2][j];
+        FP[1][j] = P[1][j] + dt * P[2][j];
+        FP[2][j] = P[2][j];
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        P[i][0] = FP[i][0] + dt * FP[i][1] + dt2 / 2 * FP[i][2];
+        P[i][1] = FP[i][1] + dt * FP[i][2];
+        P[i][2] = FP[i][2];
+    }
+
+    // White jerk of density q over dt
+    P[0][0] += q * dt3 * dt2 / 20;
+    P[0][1] += q * dt2 * dt2 / 8;   P[1][0] = P[0][1];
+    P[0][2] += q * dt3 / 6;         P[2][0] = P[0][2];
+    P[1][1] += q * dt3 / 3;
+    P[1][2] += q * dt2 / 2;         P[2][1] = P[1][2];
+    P[2][2] += q * dt;
+}
+
+
+/**
+ * @brief Correct the estimate with a position measurement (counts)
+ */
+void Observer::correct(double measuredPosition)
+{
+    // K = P H' / (H P H' + r),  H = | 1 0 0 |
+    double S = P[0][0] + r;
+    double K[3] = { P[0][0] / S, P[1][0] / S, P[2][0] / S };
+    double innovation = measuredPosition - x[0];
+
+    for (int i = 0; i < 3; i++)
+        x[i] += K[i] * innovation;
+
+    // P = (I - K H) P
+    double P0[3] = { P[0][0], P[0][1], P[0][2] };
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            P[i][j] -= K[i] * P0[j];
+}
+
+
+/**
+ * @brief Keep |velocity| <= <maxAbs> (counts/sec)
+ *    For what the counts say but a position measurement can not: with no
+ *    count change for a while, the wheel can not be going fast. A clipped
+ *    velocity has no acceleration to keep.
+ */
+void Observer::limitVelocity(double maxAbs)
+{
+    if (fabs(x[1]) > maxAbs)
+    {
+        x[1] = copysign(maxAbs, x[1]);
+        x[2] = 0;
+    }
+}
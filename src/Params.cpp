@@ -34,6 +34,7 @@
  char     Params::nodeName[32+1];
  int      Params::nodeId;
  uint8_t  Params::relayMacAddr[MAC_SIZE];
+ Preferences Params::MyPrefs;
 
   //=============================================================================
   //   This is called by all get and set functions. It checks
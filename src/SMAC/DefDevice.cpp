@@ -13,25 +13,26 @@
  * Usage:   In devices, make your device a subclass of DefDevice (instead of Device). 
  * 
  * METHODS ADDED:
- * isCommand - compares its argument against the CommandPacket.command string.
+ * isCommand - compares its argument against the command.command string.
  * 
- * scanParam - scans the CommandPacket.params arguments, parsing the list intonull-terminated
- *             tokens, using '|' as a delimiter.  ThIt returns 'argCount' (the 
- *             number of tokens found). In addition, the argcnt(number of parameters found)  
- *             and  'argList' ( an array of pointers to each token ) are available.
+ * scanParam - picks up the '|' separated tokens the Node found in command.params.
+ *             It returns 'argCount' (the number of tokens found). In addition, the
+ *             argcnt(number of parameters found) and 'arglist' ( an array of
+ *             pointer+length spans, one per token, NOT null-terminated ) are available.
  * 
  * Various 'get...' ) functions to convert a string into one a number of different data types,
  *              with syntax checking specific to each data type.
  * 
  *              1st parameter is the index of the parameter (in arglist) to be scanned.
  *                     NOTE: scanParam MUST be called once before any of these 'get...' functions!!!
+ *                           (it also tells them which reply packet gets their error messages)
  *              2nd parameter is pointer to where the result should be stored. This must point
  *                  to existing memory of a suitable size for the requested data type.
  *              3d  parametr is a short 'header' string used to identify what is being
  *                  parsed in case of an error message. (see return value below)
  * 
  *              return value: 'SUCCESS_NODATA' or 'FAIL_DATA' as appropriate.
- *                 IF FAIL_DATA, a message will have been placed in the DataPacket.value indicating the
+ *                 IF FAIL_DATA, a message will have been placed in the reply's value indicating the
  *                 problem. The message will be in this format:
  *                     ERR|<3dParam>|<text describing the error>
  *                               
@@ -57,29 +58,27 @@ DefDevice::~DefDevice()
 
 
 /**
- * @brief Scan the parameter list
- *    The CommandPacket.params string is searched
- * for '|' separated parameters. Each parameter is 
- * null terminated, and  and a pointer to it is 
- * stored in the argument list. 
+ * @brief Pick up the parameter list
+ *    The Node has already split command.params into
+ * '|' separated tokens (see CPacket in common.h).
+ * Nothing is copied or modified: 'arglist' points at
+ * the command's token spans, which stay valid until
+ * ExecuteCommand() returns.
  * 
- *    IF we reach DEFDEVICE_MAX_ARGS, then we stop -
- *  the last argument will be the entire remaining
- *  line, regardless of content.
+ *    There are at most MAX_PARAM_TOKENS arguments -
+ *  the last one holds the rest of the line, regardless
+ *  of content.
  * 
+ * @param command - the command being executed.
+ * @param reply   - the reply packet; the get... functions put their error messages here.
  * @return int number of parameters found. (This is
  *    the same as the argCount)
  */
-int DefDevice::scanParam()
+int DefDevice::scanParam(const CPacket &command, DPacket &reply)
 {
-    argCount=0;
-    char *aPtr = strtok(CommandPacket.params, "|");
-    while ( (aPtr!=nullptr) && ( *aPtr != '\0') )
-    {
-        if (argCount >= DEFDEVICE_MAX_ARGS) break; // negative Ghost Rider, the pattern is full!
-        arglist[argCount++] = aPtr;
-        aPtr = strtok(nullptr, "|");
-    }
+    argReply = &reply;
+    arglist  = command.tokens;
+    argCount = command.numTokens;
     return(argCount);
 }
 
@@ -92,9 +91,9 @@ int DefDevice::scanParam()
  */
 ProcessStatus   DefDevice::argCountCheck(int argno, const char *msg)
 {
-    if ((argno >=  argCount) | (argno<0))
+    if ((argno >=  argCount) | (argno<0) || (arglist[argno].length == 0))
     {
-        sprintf(DataPacket.value, "ERR|%s|Missing argument no %d", msg, argno);
+        sprintf(argReply->value, "ERR|%s|Missing argument no %d", msg, argno);
         return(FAIL_DATA);
     }
     return(SUCCESS_NODATA);
@@ -103,16 +102,19 @@ ProcessStatus   DefDevice::argCountCheck(int argno, const char *msg)
 
 /**
  * @brief Determine if we have a specific command
- * This does a caseless compare between the CommandPacket.command and a candidate command string.
+ * This does a caseless compare between the command.command and a candidate command string,
+ * by comparing their packed keys (see CommandTable.h). Devices with more than a couple of
+ * commands should use a command table and FindCommand() instead.
  * 
+ * @param command - the command being executed.
  * @param cmd     - the command we are looking for. Only uip to 4 chars are used.
  * @return true   - the command matches.
  * @return false  - not a match.
  *   - TBD: Should this be a macro?
  */
-bool  DefDevice::isCommand(const char *cmd)
+bool  DefDevice::isCommand(const CPacket &command, const char *cmd)
 {
-    return(0==strncasecmp(CommandPacket.command, cmd, 4));
+    return(command.key == CommandKey(cmd));
 }
 
 
@@ -128,20 +130,20 @@ ProcessStatus DefDevice::getUInt8(int arg, uint8_t *result, const char *msg)
    if (FAIL_DATA == argCountCheck(arg,msg)) return(FAIL_DATA);
 
     // Must be positive digits
-    for (char *ptr = arglist[arg]; *ptr != '\0'; ptr++)
+    for (const char *ptr = arglist[arg].text; ptr < arglist[arg].text + arglist[arg].length; ptr++)
     {
         if (!isDigit(*ptr))
         {
-            sprintf(DataPacket.value, "ERR|%s|argument %d is not an unsigned int", msg, arg);
+            sprintf(argReply->value, "ERR|%s|argument %d is not an unsigned int", msg, arg);
             return (FAIL_DATA);
         }
     }
 
     long long tmpRes;
-    tmpRes = strtoll(arglist[arg], nullptr, 10);
-    if (tmpRes > (1L<<16) )
+    tmpRes = strtoll(arglist[arg].text, nullptr, 10);
+    if (tmpRes > UINT8_MAX)
     {
-        sprintf(DataPacket.value, "ERR|%s|Missing argument no %d");
+        sprintf(argReply->value, "ERR|%s|argument %d is too large for 8 bits", msg, arg);
         return(FAIL_DATA);
     }
 
@@ -163,16 +165,16 @@ ProcessStatus DefDevice::getLLint(int arg, long long *result, const char *msg)
 {
     if (FAIL_DATA == argCountCheck(arg,msg)) return(FAIL_DATA);
 
-    for (char *ptr = arglist[arg]; *ptr != '\0'; ptr++)
+    for (const char *ptr = arglist[arg].text; ptr < arglist[arg].text + arglist[arg].length; ptr++)
     {
         if (!isDigit(*ptr))
         {
-            sprintf(DataPacket.value, "ERR|%s|argument %d is not an unsigned int\n", msg, arg);
+            sprintf(argReply->value, "ERR|%s|argument %d is not an unsigned int\n", msg, arg);
             return (FAIL_DATA);
         }
     }
 
-    *result = strtoll(arglist[arg], nullptr, 10);
+    *result = strtoll(arglist[arg].text, nullptr, 10);
     return (SUCCESS_NODATA);
 }
 
@@ -189,16 +191,16 @@ ProcessStatus   DefDevice::getUint16(int arg, uint16_t *result, const char *msg)
    if (FAIL_DATA == argCountCheck(arg, msg))
         return (FAIL_DATA);
     
-    for (char *ptr = arglist[arg]; *ptr != '\0'; ptr++)
+    for (const char *ptr = arglist[arg].text; ptr < arglist[arg].text + arglist[arg].length; ptr++)
     {
         if (!isDigit(*ptr))
         {
-            sprintf(DataPacket.value, "ERR|%s|Argument %d is not an unsigned int\n", msg, arg);
+            sprintf(argReply->value, "ERR|%s|Argument %d is not an unsigned int\n", msg, arg);
             return (FAIL_DATA);
         }
     }
 
-    *result = strtol(arglist[arg], nullptr, 10);
+    *result = strtol(arglist[arg].text, nullptr, 10);
     return (SUCCESS_NODATA);
 }
 
@@ -208,7 +210,7 @@ ProcessStatus   DefDevice::getUint16(int arg, uint16_t *result, const char *msg)
  * @brief Get an unsigned int (32 bits)
  *    Must be all digits!
  * If an error is detected, a diagnostic
- * is queued in DataPacket.value
+ * is queued in the reply's value
  * 
  * @param arg        index of the argument to scan
  * @param result     where to store the result (if no error)
@@ -220,17 +222,17 @@ ProcessStatus DefDevice::getUint32(int arg, uint32_t *result, const char *msg)
     if (FAIL_DATA == argCountCheck(arg, msg))
         return (FAIL_DATA);
 
-    for (char *ptr = arglist[arg]; *ptr != '\0'; ptr++)
+    for (const char *ptr = arglist[arg].text; ptr < arglist[arg].text + arglist[arg].length; ptr++)
     {
         if (!isDigit(*ptr))
         {
-            sprintf(DataPacket.value, "ERR|%s|argument %d is not an unsigned int", msg, arg);
-            //Serial.printf("ERR|%s|Bad integer value for argument %d: '%s'", msg, arg, arglist[arg]);
+            sprintf(argReply->value, "ERR|%s|argument %d is not an unsigned int", msg, arg);
+            //Serial.printf("ERR|%s|Bad integer value for argument %d: '%.*s'", msg, arg, arglist[arg].length, arglist[arg].text);
             return (FAIL_DATA);
         }
     }
 
-    *result = strtol(arglist[arg], nullptr, 10);
+    *result = strtol(arglist[arg].text, nullptr, 10);
     return (SUCCESS_NODATA);
 }
 
@@ -249,16 +251,16 @@ ProcessStatus  DefDevice::getInt16  (int arg,  int16_t   *result,  const char *m
    if (FAIL_DATA == argCountCheck(arg, msg))
         return (FAIL_DATA);
     
-    for (char *ptr = arglist[arg]; *ptr != '\0'; ptr++)
+    for (const char *ptr = arglist[arg].text; ptr < arglist[arg].text + arglist[arg].length; ptr++)
     {
         if (!isDigit(*ptr) && (*ptr != '+') && (*ptr != '-'))
         {
-            sprintf(DataPacket.value, "Error:%s|Argument %d is not unsigned int\n", msg, arg);
+            sprintf(argReply->value, "Error:%s|Argument %d is not unsigned int\n", msg, arg);
             return (FAIL_DATA);
         }
     }
 
-    *result = strtol(arglist[arg], nullptr, 10);
+    *result = strtol(arglist[arg].text, nullptr, 10);
     return (SUCCESS_NODATA);
 }
 
@@ -279,16 +281,16 @@ ProcessStatus DefDevice::getInt32(int arg, int32_t *result, const char *msg)
     if (FAIL_DATA == argCountCheck(arg, msg))
         return (FAIL_DATA);
     
-    for (char *ptr = arglist[arg]; *ptr != '\0'; ptr++)
+    for (const char *ptr = arglist[arg].text; ptr < arglist[arg].text + arglist[arg].length; ptr++)
     {
         if (!isDigit(*ptr) && (*ptr != '+') && (*ptr != '-'))
         {
-            sprintf(DataPacket.value, "ERR|%s|Argument %d is not a int\n", msg, arg);
+            sprintf(argReply->value, "ERR|%s|Argument %d is not a int\n", msg, arg);
             return (FAIL_DATA);
         }
     }
 
-    *result = strtol(arglist[arg], nullptr, 10);
+    *result = strtol(arglist[arg].text, nullptr, 10);
     return (SUCCESS_NODATA);
 }
 
@@ -305,16 +307,16 @@ ProcessStatus  DefDevice::getInt  (int arg,  int   *result,  const char *msg)
    if (FAIL_DATA == argCountCheck(arg, msg))
         return (FAIL_DATA);
     
-    for (char *ptr = arglist[arg]; *ptr != '\0'; ptr++)
+    for (const char *ptr = arglist[arg].text; ptr < arglist[arg].text + arglist[arg].length; ptr++)
     {
         if (!isDigit(*ptr) && (*ptr != '+') && (*ptr != '-'))
         {
-            sprintf(DataPacket.value, "ERR|%s|Argument %d is not a int\n", msg, arg);
+            sprintf(argReply->value, "ERR|%s|Argument %d is not a int\n", msg, arg);
             return (FAIL_DATA);
         }
     }
 
-    *result = strtol(arglist[arg], nullptr, 10);
+    *result = strtol(arglist[arg].text, nullptr, 10);
     return (SUCCESS_NODATA);
 }
 
@@ -332,10 +334,10 @@ ProcessStatus DefDevice::getDouble(int arg, double *result, const char *msg)
    if (FAIL_DATA == argCountCheck(arg,msg)) return(FAIL_DATA);
 
     errno = 0;
-    double tmpVal =strtod(arglist[arg], nullptr);
+    double tmpVal =strtod(arglist[arg].text, nullptr);
     if (errno!=0)
         {
-            sprintf(DataPacket.value, "ERR|%s|Invalid double for argument no %d", msg, arg);
+            sprintf(argReply->value, "ERR|%s|Invalid double for argument no %d", msg, arg);
             return(FAIL_DATA);
         }
 
@@ -363,7 +365,7 @@ ProcessStatus DefDevice::getBool(int arg, bool *result, const char *msg)
         retval = FAIL_DATA;
 
     } else {
-        char firstChar = toupper(arglist[arg][0]); // Just use 1st char
+        char firstChar = toupper(arglist[arg].text[0]); // Just use 1st char
         if ((firstChar == '0') || (firstChar == 'N') || (firstChar == 'F'))
         {
             *result = false;
@@ -374,7 +376,7 @@ ProcessStatus DefDevice::getBool(int arg, bool *result, const char *msg)
         }
         else
         {
-            sprintf(DataPacket.value, "ERROR:%s Unknown boolean value for argument",
+            sprintf(argReply->value, "ERROR:%s Unknown boolean value for argument",
                     msg);
             retval = FAIL_DATA;
         }
@@ -19,6 +19,15 @@
 
 #include <Arduino.h>
 #include "Device.h"
+#include "Node.h"
+
+//--- onTaskWakeTimer -------------------------------------
+
+static void onTaskWakeTimer (void *arg)
+{
+  // esp_timer task: the deadline a Device task was sleeping for has come
+  xTaskNotifyGive (*(TaskHandle_t *) arg);
+}
 
 //--- Constructor -----------------------------------------
 
@@ -39,6 +48,8 @@ void Device::SetID (int inDeviceID)
   // Set the ID for this Device (00 - 99)
   if (inDeviceID > 99)
     inDeviceID = 99;
+  else if (inDeviceID < 0)
+    inDeviceID = 0;
 
   sprintf (deviceID, "%02d", inDeviceID);
 }
@@ -75,18 +86,62 @@ bool Device::IsPPEnabled ()
 
 unsigned long Device::GetRate ()
 {
-  return 3600000L / processPeriod;  // Calls to DoPeriodic() per hour
+  // Calls to DoPeriodic() per hour
+  return (unsigned long)((3600000000LL + processPeriodUs/2) / processPeriodUs);
 }
 
 //--- SetRate ---------------------------------------------
 
 void Device::SetRate (double newRate)
 {
-  // Do not allow zero rate
+  // Do not allow zero rate, nor more than MAX_PERIODIC_RATE_HZ
   if (newRate < 1.0)
     newRate = 1.0;
+  if (newRate > MAX_PERIODIC_RATE_HZ * 3600.0)
+    newRate = MAX_PERIODIC_RATE_HZ * 3600.0;
+
+  processPeriodUs = (int64_t)(3600000000.0/newRate + 0.5);
+}
+
+//--- GetRateHz -------------------------------------------
+
+double Device::GetRateHz ()
+{
+  return 1000000.0 / processPeriodUs;  // Calls to DoPeriodic() per second
+}
+
+//--- SetRateHz -------------------------------------------
+
+void Device::SetRateHz (double newRate)
+{
+  SetRate (newRate * 3600.0);
+}
+
+//--- SetSchedulePolicy -----------------------------------
+
+void Device::SetSchedulePolicy (SchedulePolicy policy)
+{
+  schedulePolicy = policy;
+}
+
+//--- GetTrafficClass / SetTrafficClass ------------------
 
-  processPeriod = (unsigned long)(3600000.0/newRate + 0.5);
+TrafficClass Device::GetTrafficClass ()
+{
+  return trafficClass;
+}
+
+void Device::SetTrafficClass (TrafficClass newClass)
+{
+  // Only command responses are TRAFFIC_RESPONSE
+  trafficClass = (newClass == TRAFFIC_STATUS) ? TRAFFIC_STATUS : TRAFFIC_TELEMETRY;
+}
+
+//--- ScheduledTimeUs -------------------------------------
+
+int64_t Device::ScheduledTimeUs ()
+{
+  return periodicDeadline;
 }
 
 //--- GetVersion ------------------------------------------
@@ -96,33 +151,401 @@ const char * Device::GetVersion ()
   return version;
 }
 
+//--- TxBackpressure --------------------------------------
+
+bool Device::TxBackpressure ()
+{
+  // Should an optional report be skipped? (see Node::TxBackpressure())
+  return Node::TxBackpressure (trafficClass);
+}
+
+//--- SubmitReport ----------------------------------------
+
+bool Device::SubmitReport (DPacket &packet)
+{
+  // Hand a report from any task to the Node, never waiting for room.
+  // Returns false if the Node's report queue was full.
+  memcpy (packet.deviceID, deviceID, ID_SIZE + 1);
+  return Node::SubmitReport (packet);
+}
+
+//--- SetScheduler ----------------------------------------
+
+void Device::SetScheduler (Scheduler *inScheduler)
+{
+  // Called by the Node when this Device is added
+  scheduler = inScheduler;
+
+  if (periodicEnabled)
+    scheduler->Add (this);
+}
+
+//--- RunOnTask -------------------------------------------
+
+void Device::RunOnTask (int core, UBaseType_t priority, uint32_t stackSize)
+{
+  // Run this Device's processes on its own task pinned to <core>.
+  // Must be called before the Device is added to its Node.
+  if (core < 0 || core >= portNUM_PROCESSORS || scheduler != NULL)
+    return;
+
+  taskCore      = core;
+  taskPriority  = priority;
+  taskStackSize = stackSize;
+}
+
+//--- IsOnTask --------------------------------------------
+
+bool Device::IsOnTask ()
+{
+  return taskCore >= 0;
+}
+
+//--- StartTask -------------------------------------------
+
+bool Device::StartTask ()
+{
+  // Called by the Node's first Run().  The task gets its own Scheduler.
+  // On failure, the Device stays on the Node's task.
+  esp_timer_create_args_t  timerArgs = {};
+  timerArgs.callback = onTaskWakeTimer;
+  timerArgs.arg      = &task;
+  timerArgs.name     = "DeviceWake";
+
+  if (taskLock == NULL)
+    taskLock = xSemaphoreCreateMutex ();
+
+  if (taskLock != NULL && esp_timer_create (&timerArgs, &taskTimer) == ESP_OK)
+  {
+    SetScheduler (new Scheduler ());
+
+    if (xTaskCreatePinnedToCore (TaskMain, name, taskStackSize, this, taskPriority, &task, taskCore) == pdPASS)
+      return true;
+
+    scheduler->Remove (this);
+    delete scheduler;
+    scheduler = NULL;
+    esp_timer_delete (taskTimer);
+    taskTimer = NULL;
+  }
+
+  // Back on the Node's task there is nothing to lock or notify
+  if (taskLock != NULL)
+  {
+    vSemaphoreDelete (taskLock);
+    taskLock = NULL;
+  }
+
+  taskCore = -1;
+  task     = NULL;
+  return false;
+}
+
+//--- LockTask / UnlockTask -------------------------------
+
+void Device::LockTask ()
+{
+  // Wait for the task to finish the process it is running
+  if (taskLock != NULL)
+    xSemaphoreTake (taskLock, portMAX_DELAY);
+}
+
+void Device::UnlockTask ()
+{
+  // Let the task go, and have it pick up any change a command made (rate, enables)
+  if (taskLock != NULL)
+  {
+    xSemaphoreGive (taskLock);
+    if (task != NULL)
+      xTaskNotifyGive (task);
+  }
+}
+
+//--- TaskMain --------------------------------------------
+
+void Device::TaskMain (void *arg)
+{
+  Device *device = (Device *) arg;
+
+  while (true)
+    device->RunTaskPass ();
+}
+
+//--- RunTaskPass -----------------------------------------
+
+void Device::RunTaskPass ()
+{
+  // Run the due processes, then sleep until the next deadline or a command
+  // (the Node notifies the task after each one).
+  // With Immediate Processing enabled, sleep one tick instead.
+  DPacket  packet;
+
+  xSemaphoreTake (taskLock, portMAX_DELAY);
+
+  if (immediateEnabled)
+  {
+    packet.numFields = 0;
+    QueueResult (RunImmediate (packet), packet);
+  }
+
+  int64_t  now = esp_timer_get_time ();
+  while (scheduler->NextDue (now) != NULL)
+  {
+    // Set the next deadline first, DoPeriodic() may reschedule itself
+    scheduler->Advance (this, now);
+
+    packet.numFields = 0;
+    QueueResult (RunPeriodic (packet), packet);
+  }
+
+  bool     immediate = immediateEnabled;
+  int64_t  deadline  = scheduler->NextDeadline ();
+
+  xSemaphoreGive (taskLock);
+
+  if (immediate)
+    vTaskDelay (1);
+  else if (deadline == INT64_MAX)
+    ulTaskNotifyTake (pdTRUE, portMAX_DELAY);
+  else
+  {
+    int64_t  waitUs = deadline - esp_timer_get_time ();
+    if (waitUs > 0)
+    {
+      esp_timer_start_once (taskTimer, waitUs);
+      ulTaskNotifyTake (pdTRUE, portMAX_DELAY);
+      esp_timer_stop (taskTimer);
+    }
+  }
+}
+
+//--- QueueResult -----------------------------------------
+
+void Device::QueueResult (ProcessStatus status, DPacket &packet)
+{
+  // Hand a process's report from the task to the Node
+  if (status != SUCCESS_DATA && status != FAIL_DATA)
+    return;
+
+  if (SubmitReport (packet))
+    ++taskResults;
+  else
+    ++taskDrops;
+}
+
+//--- GetTaskStats ----------------------------------------
+
+int Device::GetTaskStats (char *text)
+{
+  // DTASK=core|priority|free stack bytes|reports queued|reports dropped|periodic runs|max late uSecs
+  return sprintf (text, "DTASK=%d|%u|%u|%lu|%lu|%lu|%ld", taskCore, (unsigned) taskPriority,
+                  (task != NULL) ? (unsigned) uxTaskGetStackHighWaterMark (task) : 0u, taskResults, taskDrops,
+                  (scheduler != NULL) ? scheduler->runs : 0L, (long) ((scheduler != NULL) ? scheduler->maxLate : 0));
+}
+
+//--- RunImmediate ----------------------------------------
+
+IRAM_ATTR ProcessStatus Device::RunImmediate (DPacket &packet)
+{
+  int64_t        start  = esp_timer_get_time ();
+  ProcessStatus  status = DoImmediate (packet);
+
+  profiles[PROFILE_IMMEDIATE].Record (esp_timer_get_time () - start);
+  return status;
+}
+
 //--- RunPeriodic -----------------------------------------
 
-ProcessStatus Device::RunPeriodic ()
+IRAM_ATTR ProcessStatus Device::RunPeriodic (DPacket &packet)
 {
-  // Do not override this method.
-  // It is continually called by the Node to operate periodic processing.
+  // Do not build a report that would only be dropped
+  if (periodicReportOnly && TxBackpressure ())
+    return SUCCESS_NODATA;
+
+  int64_t        start  = esp_timer_get_time ();
+  ProcessStatus  status = DoPeriodic (packet);
 
-  // Is it time to do the periodic process?
-  now = millis();
-  if (now >= nextPeriodicTime)
+  profiles[PROFILE_PERIODIC].Record (esp_timer_get_time () - start);
+
+  // Report on change: drop a report that says nothing new (see SDBD)
+  if (status == SUCCESS_DATA && heartbeatMs > 0 && !ReportChanged (packet))
   {
-    nextPeriodicTime = now + processPeriod;
-    return DoPeriodic ();
+    ++reportsSuppressed;
+    status = SUCCESS_NODATA;
   }
 
-  return SUCCESS_NODATA;
+  return status;
+}
+
+//--- ReportChanged ---------------------------------------
+
+static double FieldNumber (const DField &field)
+{
+  switch (field.type)
+  {
+    case FIELD_INT32  : return field.i32;
+    case FIELD_UINT32 : return field.u32;
+    case FIELD_FLOAT  : return field.f32;
+    default           : return 0.0;
+  }
+}
+
+static uint32_t TextHash (const char *text)
+{
+  // FNV-1a, so a text field that is rewritten in place is still compared by content
+  uint32_t  hash = 2166136261UL;
+
+  while (text != NULL && *text != 0)
+    hash = (hash ^ (uint8_t) *text++) * 16777619UL;
+
+  return hash;
+}
+
+IRAM_ATTR bool Device::ReportChanged (const DPacket &packet)
+{
+  // Only typed fields can be compared, value strings are always sent
+  int64_t  now     = esp_timer_get_time ();
+  bool     changed = packet.numFields == 0 || packet.numFields != lastNumFields ||
+                     now - lastReportUs >= (int64_t) heartbeatMs * 1000;
+
+  for (int i=0; i<packet.numFields && !changed; i++)
+  {
+    const DField  &field = packet.fields[i];
+    const DField  &last  = lastFields[i];
+
+    if (field.type != last.type)
+      changed = true;
+    else if (field.type == FIELD_TEXT)
+      changed = TextHash (field.text) != last.u32;
+    else if (deadbands[i] >= 0.0f)
+      changed = fabs (FieldNumber (field) - FieldNumber (last)) > deadbands[i];
+  }
+
+  if (changed)
+  {
+    // Remember what was sent
+    for (int i=0; i<packet.numFields; i++)
+    {
+      lastFields[i] = packet.fields[i];
+      if (lastFields[i].type == FIELD_TEXT)
+        lastFields[i].u32 = TextHash (packet.fields[i].text);
+    }
+
+    lastNumFields = packet.numFields;
+    lastReportUs  = now;
+  }
+
+  return changed;
+}
+
+//--- RunCommand ------------------------------------------
+
+ProcessStatus Device::RunCommand (CPacket &command, DPacket &reply)
+{
+  // A Device on its own task is locked so the command never runs during one of its processes.
+  // The time spent waiting for the lock is not counted.
+  LockTask ();
+
+  int64_t        start  = esp_timer_get_time ();
+  ProcessStatus  status = ExecuteCommand (command, reply);
+
+  profiles[PROFILE_COMMAND].Record (esp_timer_get_time () - start);
+
+  UnlockTask ();
+  return status;
+}
+
+//--- RunSample -------------------------------------------
+
+bool Device::RunSample (int field, DPacket &packet)
+{
+  // Called by the Node for a subscription (SSUB).  Take the lock directly, so a
+  // Device on its own task is never sampled halfway through one of its processes;
+  // UnlockTask() would wake the task for nothing.
+  if (taskLock != NULL)
+    xSemaphoreTake (taskLock, portMAX_DELAY);
+
+  bool sampled = SampleField (field, packet);
+
+  if (taskLock != NULL)
+    xSemaphoreGive (taskLock);
+
+  return sampled;
+}
+
+//--- GetProfile ------------------------------------------
+
+int Device::GetProfile (ProfileKind kind, char *text)
+{
+  // DPROF=kind|count|minUs|avgUs|maxUs|h0|...|h15  (kind = I, P or C)
+  static const char  labels[NUM_PROFILE_KINDS] = { 'I', 'P', 'C' };
+  int                length = 0;
+
+  // Take the lock directly; UnlockTask() would wake the task for nothing
+  if (taskLock != NULL)
+    xSemaphoreTake (taskLock, portMAX_DELAY);
+
+  if (profiles[kind].count > 0)
+  {
+    length  = sprintf (text, "DPROF=%c|", labels[kind]);
+    length += profiles[kind].Format (text + length);
+  }
+
+  if (taskLock != NULL)
+    xSemaphoreGive (taskLock);
+
+  return length;
+}
+
+//--- ResetProfiles ---------------------------------------
+
+void Device::ResetProfiles ()
+{
+  if (taskLock != NULL)
+    xSemaphoreTake (taskLock, portMAX_DELAY);
+
+  for (int i=0; i<NUM_PROFILE_KINDS; i++)
+    profiles[i].Reset ();
+
+  if (taskLock != NULL)
+    xSemaphoreGive (taskLock);
+}
+
+//--- EnablePeriodic --------------------------------------
+
+void Device::EnablePeriodic (bool enable)
+{
+  // Start (from now) or stop Periodic Processing
+  periodicEnabled = enable;
+  lastNumFields   = -1;  // The first report after a restart always goes out
+
+  if (scheduler != NULL)
+  {
+    if (enable)
+      scheduler->Add (this);
+    else
+      scheduler->Remove (this);
+  }
+}
+
+//--- RestartPeriodic -------------------------------------
+
+void Device::RestartPeriodic ()
+{
+  // Start a new rate now
+  if (periodicEnabled && scheduler != NULL)
+    scheduler->Add (this);
 }
 
 //--- DoImmediate -----------------------------------------
 
-IRAM_ATTR ProcessStatus Device::DoImmediate ()
+IRAM_ATTR ProcessStatus Device::DoImmediate (DPacket &packet)
 {
   // Override this method in your child class to perform
   // a continuous (as fast as possible) process.
   //
-  // If there is data to return, then this method should populate this Device's
-  // timestamp and value strings of the global <DataPacket> structure
+  // If there is data to return, then this method should populate the
+  // timestamp and value strings (or typed fields) of <packet>
   // and return SUCCESS_DATA or FAIL_DATA.
 
   return SUCCESS_NODATA;
@@ -130,153 +553,276 @@ IRAM_ATTR ProcessStatus Device::DoImmediate ()
 
 //--- DoPeriodic ------------------------------------------
 
-IRAM_ATTR ProcessStatus Device::DoPeriodic ()
+IRAM_ATTR ProcessStatus Device::DoPeriodic (DPacket &packet)
 {
   // Override this method in your child class to perform
   // a timed periodic process.
   //
-  // If there is data to return, then this method should populate this Device's
-  // timestamp and value strings of the global <DataPacket> structure
+  // If there is data to return, then this method should populate the
+  // timestamp and value strings (or typed fields) of <packet>
   // and return SUCCESS_DATA or FAIL_DATA.
 
   return SUCCESS_NODATA;
 }
 
+//--- SampleField -----------------------------------------
+
+bool Device::SampleField (int field, DPacket &packet)
+{
+  // Override this method in your child class to let the Node sample
+  // single fields of your periodic report for subscriptions (SSUB).
+  //
+  // Add the current value of typed field <field> (its position in the
+  // DoPeriodic() report) to <packet> with one Add...Field() call and
+  // return true, or return false if there is no such field.
+  // Read the latest values, do not run the process.
+
+  return false;
+}
+
 //--- ExecuteCommand --------------------------------------
 
-ProcessStatus Device::ExecuteCommand ()
+ProcessStatus Device::ExecuteCommand (CPacket &command, DPacket &reply)
 {
   // If your child Device class needs to handle custom commands, then override this method:
   //
-  // The global <CommandPacket> will have the command definition.
+  // <command> has the command definition.
   // First call this base class method to handle the built-in Device commands:
   //
-  //   Device::ExecuteCommand ();
+  //   Device::ExecuteCommand (command, reply);
   //
   // If this call returns NOT_HANDLED, then your child class should handle the command.
   //
-  // If your ExecuteCommand() method has data to return, it should populate the
-  // global <DataPacket> and return an appropriate ProcessStatus.
+  // If your ExecuteCommand() method has data to return, it should populate
+  // <reply> and return an appropriate ProcessStatus.
   //
-  // When populating the global <DataPacket>, value strings that start with a dash or a digit
+  // When populating <reply>, value strings that start with a dash or a digit
   // will be interpreted by the Interface as periodic process data, say from a sensor reading.
 
-  // Initial Process Status
-  pStatus = NOT_HANDLED;
+  // Look up the built-in Device command (see <commandTable> in Device.h)
+  const CommandEntry<CommandHandler<Device>> *entry = FindCommand (commandTable, command.key);
+  if (entry == NULL)
+    return NOT_HANDLED;
 
-  //--- Get Device Name (GDNA) ------------------
-  if (strcmp (CommandPacket.command, "GDNA") == 0)
-  {
-    // Return Device's name
-    strcpy (DataPacket.value, "DENAME=");
-    strcat (DataPacket.value, name);
+  // Default the timestamp to now; handlers such as DOPP may set their own
+  reply.timestamp = millis();
+  pStatus = (this->*entry->handler) (command, reply);
 
-    pStatus = SUCCESS_DATA;
-  }
+  // Return the resulting ProcessStatus
+  return pStatus;
+}
 
-  //--- Set Device Name (SDNA) ------------------
-  else if (strcmp (CommandPacket.command, "SDNA") == 0)
-  {
-    // Set this Device's name
-    strncpy (name, CommandPacket.params, MAX_NAME_LENGTH-1);
-    name[MAX_NAME_LENGTH-1] = 0;
+//=========================================================
+//  Built-in Device Command Handlers
+//=========================================================
 
-    // Acknowledge new name
-    strcpy (DataPacket.value, "DENAME=");
-    strcat (DataPacket.value, name);
+//--- Get Device Name (GDNA) ------------------------------
 
-    pStatus = SUCCESS_DATA;
-  }
+ProcessStatus Device::CmdGetName (CPacket &command, DPacket &reply)
+{
+  // Return Device's name
+  strcpy (reply.value, "DENAME=");
+  strcat (reply.value, name);
 
-  //--- Enable Immediate Processing (ENIP) ------
-  else if (strcmp (CommandPacket.command, "ENIP") == 0)
-  {
-    immediateEnabled = true;
+  return SUCCESS_DATA;
+}
 
-    // Acknowledge
-    strcpy (DataPacket.value, "IP Enabled");
+//--- Set Device Name (SDNA) ------------------------------
 
-    pStatus = SUCCESS_DATA;
-  }
+ProcessStatus Device::CmdSetName (CPacket &command, DPacket &reply)
+{
+  // Set this Device's name
+  strncpy (name, command.params, MAX_NAME_LENGTH-1);
+  name[MAX_NAME_LENGTH-1] = 0;
 
-  //--- Disable Immediate Processing (DIIP) -----
-  else if (strcmp (CommandPacket.command, "DIIP") == 0)
-  {
-    immediateEnabled = false;
+  // Acknowledge new name
+  strcpy (reply.value, "DENAME=");
+  strcat (reply.value, name);
 
-    // Acknowledge
-    strcpy (DataPacket.value, "IP Disabled");
+  return SUCCESS_DATA;
+}
 
-    pStatus = SUCCESS_DATA;
-  }
+//--- Enable Immediate Processing (ENIP) ------------------
 
-  //--- Do Immediate Process one time (DOIP) ----
-  else if (strcmp (CommandPacket.command, "DOIP") == 0)
-    return DoImmediate ();
+ProcessStatus Device::CmdEnableImmediate (CPacket &command, DPacket &reply)
+{
+  immediateEnabled = true;
 
-  //--- Enable Periodic Processing (ENPP) -------
-  else if (strcmp (CommandPacket.command, "ENPP") == 0)
-  {
-    periodicEnabled = true;
-    nextPeriodicTime = millis();
+  // Acknowledge
+  strcpy (reply.value, "IP Enabled");
 
-    // Acknowledge
-    strcpy (DataPacket.value, "PP Enabled");
+  return SUCCESS_DATA;
+}
 
-    pStatus = SUCCESS_DATA;
-  }
+//--- Disable Immediate Processing (DIIP) -----------------
 
-  //--- Disable Periodic Processing (DIPP) ------
-  else if (strcmp (CommandPacket.command, "DIPP") == 0)
-  {
-    periodicEnabled = false;
+ProcessStatus Device::CmdDisableImmediate (CPacket &command, DPacket &reply)
+{
+  immediateEnabled = false;
 
-    // Acknowledge
-    strcpy (DataPacket.value, "PP Disabled");
+  // Acknowledge
+  strcpy (reply.value, "IP Disabled");
 
-    pStatus = SUCCESS_DATA;
-  }
+  return SUCCESS_DATA;
+}
 
-  //--- Do Periodic Process one time (DOPP) -----
-  else if (strcmp (CommandPacket.command, "DOPP") == 0)
-    return DoPeriodic ();
+//--- Do Immediate Process one time (DOIP) ----------------
 
-  //--- Get Rate (GRAT) -------------------------
-  else if (strcmp (CommandPacket.command, "GRAT") == 0)
-  {
-    // Return this Device's current periodic process rate (calls per hour)
-    strcpy (DataPacket.value, "RATE=");
-    ltoa (GetRate(), DataPacket.value + 5, 10);
+ProcessStatus Device::CmdDoImmediate (CPacket &command, DPacket &reply)
+{
+  return DoImmediate (reply);
+}
 
-    pStatus = SUCCESS_DATA;
-  }
+//--- Enable Periodic Processing (ENPP) -------------------
+
+ProcessStatus Device::CmdEnablePeriodic (CPacket &command, DPacket &reply)
+{
+  EnablePeriodic (true);
+
+  // Acknowledge
+  strcpy (reply.value, "PP Enabled");
+
+  return SUCCESS_DATA;
+}
+
+//--- Disable Periodic Processing (DIPP) ------------------
+
+ProcessStatus Device::CmdDisablePeriodic (CPacket &command, DPacket &reply)
+{
+  EnablePeriodic (false);
+
+  // Acknowledge
+  strcpy (reply.value, "PP Disabled");
+
+  return SUCCESS_DATA;
+}
+
+//--- Do Periodic Process one time (DOPP) -----------------
+
+ProcessStatus Device::CmdDoPeriodic (CPacket &command, DPacket &reply)
+{
+  periodicDeadline = esp_timer_get_time ();
+  return DoPeriodic (reply);
+}
+
+//--- Get Rate (GRAT) -------------------------------------
+
+ProcessStatus Device::CmdGetRate (CPacket &command, DPacket &reply)
+{
+  // Return this Device's current periodic process rate (calls per hour)
+  strcpy (reply.value, "RATE=");
+  ltoa (GetRate(), reply.value + 5, 10);
+
+  return SUCCESS_DATA;
+}
+
+//--- Set Rate (SRAT) -------------------------------------
+
+ProcessStatus Device::CmdSetRate (CPacket &command, DPacket &reply)
+{
+  // Set this Device's periodic process rate (calls per hour)
+  double newRate = atof (command.params);
+  SetRate (newRate);
+
+  // Acknowledge new periodic rate
+  strcpy (reply.value, "RATE=");
+  ltoa (GetRate(), reply.value + 5, 10);
+
+  RestartPeriodic ();
 
-  //--- Set Rate (SRAT) -------------------------
-  else if (strcmp (CommandPacket.command, "SRAT") == 0)
+  return SUCCESS_DATA;
+}
+
+//--- Get Rate in Hz (GRHZ) -------------------------------
+
+ProcessStatus Device::CmdGetRateHz (CPacket &command, DPacket &reply)
+{
+  // Return this Device's current periodic process rate (calls per second)
+  sprintf (reply.value, "RATEHZ=%.4f", GetRateHz());
+
+  return SUCCESS_DATA;
+}
+
+//--- Set Rate in Hz (SRHZ) -------------------------------
+
+ProcessStatus Device::CmdSetRateHz (CPacket &command, DPacket &reply)
+{
+  // Set this Device's periodic process rate (calls per second)
+  SetRateHz (atof (command.params));
+
+  // Acknowledge new periodic rate
+  sprintf (reply.value, "RATEHZ=%.4f", GetRateHz());
+
+  RestartPeriodic ();
+
+  return SUCCESS_DATA;
+}
+
+//--- Set Schedule Policy (SPOL) --------------------------
+
+ProcessStatus Device::CmdSetSchedulePolicy (CPacket &command, DPacket &reply)
+{
+  // SPOL|S skips missed periods, SPOL|C catches up (no params reports the policy)
+  switch (toupper (command.params[0]))
   {
-    // Set this Device's periodic process rate (calls per hour)
-    double newRate = atof (CommandPacket.params);
-    SetRate (newRate);
+    case 'S' : schedulePolicy = SCHEDULE_SKIP;      break;
+    case 'C' : schedulePolicy = SCHEDULE_CATCH_UP;  break;
+  }
 
-    // Acknowledge new periodic rate
-    strcpy (DataPacket.value, "RATE=");
-    ltoa (GetRate(), DataPacket.value + 5, 10);
+  sprintf (reply.value, "POLICY=%c", (schedulePolicy == SCHEDULE_CATCH_UP) ? 'C' : 'S');
 
-    nextPeriodicTime = millis();  // start new rate now
-    pStatus = SUCCESS_DATA;
+  return SUCCESS_DATA;
+}
+
+//--- Set Traffic Class (STCL) ----------------------------
+
+ProcessStatus Device::CmdSetTrafficClass (CPacket &command, DPacket &reply)
+{
+  // STCL|S sends this Device's reports as status, STCL|T as telemetry (no params reports the class)
+  switch (toupper (command.params[0]))
+  {
+    case 'S' : SetTrafficClass (TRAFFIC_STATUS);     break;
+    case 'T' : SetTrafficClass (TRAFFIC_TELEMETRY);  break;
   }
 
-  //--- Get Version (GDVR) ----------------------
-  else if (strcmp (CommandPacket.command, "GDVR") == 0)
+  sprintf (reply.value, "TCLASS=%c", (trafficClass == TRAFFIC_STATUS) ? 'S' : 'T');
+
+  return SUCCESS_DATA;
+}
+
+//--- Set Deadband (SDBD) ---------------------------------
+
+ProcessStatus Device::CmdSetDeadband (CPacket &command, DPacket &reply)
+{
+  // SDBD|heartbeatMs|deadband0|deadband1|...  (no params reports the settings)
+  if (command.numTokens > 0)
   {
-    sprintf (DataPacket.value, "DVER=%s", version);
-    pStatus = SUCCESS_DATA;
+    heartbeatMs = strtoul (command.tokens[0].text, NULL, 10);
+
+    for (int i=0; i<MAX_DATA_FIELDS; i++)
+    {
+      if (i + 1 < command.numTokens)
+        deadbands[i] = strtof (command.tokens[i + 1].text, NULL);
+      else
+        deadbands[i] = 0.0f;
+    }
+
+    lastNumFields     = -1;
+    reportsSuppressed = 0L;
   }
 
-  // Set timestamp if data to return
-  if (pStatus == SUCCESS_DATA || pStatus == FAIL_DATA)
-    DataPacket.timestamp = millis();
+  // DBAND=heartbeatMs|suppressed|deadband0|...|deadband7
+  int length = sprintf (reply.value, "DBAND=%lu|%lu", heartbeatMs, reportsSuppressed);
+  for (int i=0; i<MAX_DATA_FIELDS; i++)
+    length += sprintf (reply.value + length, "|%g", deadbands[i]);
 
-  // Return the resulting ProcessStatus
-  return pStatus;
+  return SUCCESS_DATA;
+}
+
+//--- Get Version (GDVR) ----------------------------------
+
+ProcessStatus Device::CmdGetVersion (CPacket &command, DPacket &reply)
+{
+  sprintf (reply.value, "DVER=%s", version);
+  return SUCCESS_DATA;
 }
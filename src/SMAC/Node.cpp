@@ -24,6 +24,8 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <esp_now.h>
+#include <esp_timer.h>
+#include <atomic>
 #include "Node.h"
 
 //--- Declarations ----------------------------------------
@@ -42,10 +44,70 @@
 // void onCommandReceived (const uint8_t *relayerMAC, const uint8_t *inCommandString, int commandlength);  // ESP-NOW v1
 void onCommandReceived (const esp_now_recv_info_t *info, const uint8_t *inCommandString, int commandlength);  // ESP-NOW v2
 
-// void onDataPacketSent  (const uint8_t *mac_addr, esp_now_send_status_t status);  // Not used in SMAC
+// The send callback changed in ESP-IDF v5.5 as well: it now receives a wifi_tx_info_t instead of the MAC address.
+#ifdef ESP_IDF_VERSION_VAL
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 5, 0)
+#define ESPNOW_SEND_TX_INFO
+#endif
+#endif
+
+#ifdef ESPNOW_SEND_TX_INFO
+void onDataPacketSent  (const wifi_tx_info_t *info, esp_now_send_status_t status);
+#else
+void onDataPacketSent  (const uint8_t *mac_addr, esp_now_send_status_t status);
+#endif
 
 extern bool  WaitingForRelayer;
 
+static TaskHandle_t volatile  RunTask     = NULL;  // The task that calls Node::Run()
+static QueueHandle_t          ReportQueue = NULL;  // DPackets from other tasks waiting for Run() to send them
+
+// Transmit pipeline, shared with the ESP-NOW send callback
+static QueueHandle_t          TxQueue             = NULL;  // Frames waiting for the sender task
+static SemaphoreHandle_t      TxSlots             = NULL;  // One count per frame ESP-NOW may hold (TX_MAX_IN_FLIGHT)
+static std::atomic<uint32_t>  TxDelivered         {0};     // Send callbacks with ESP_NOW_SEND_SUCCESS
+static std::atomic<uint32_t>  TxFailed            {0};     // Send callbacks with ESP_NOW_SEND_FAIL
+static std::atomic<uint32_t>  TxBackpressureSkips {0};     // Reports skipped because of TxBackpressure()
+
+// Outbound rate limits (SLIM), refilled and charged by the Run() task only
+static TokenBucket            ByteBucket;                  // Airtime bytes per second
+static TokenBucket            RecordBucket;                // Records per second
+static std::atomic<uint32_t>  LimitSkips          {0};     // Reports TxBackpressure() skipped for the rate limits
+
+// Transport selection, set only by SXPT, read by TransmitFrame()
+static std::atomic<int>       ActiveTransport     {TRANSPORT_ESPNOW};
+static portMUX_TYPE           CommandPushLock     = portMUX_INITIALIZER_UNLOCKED;  // ESP-NOW and the serial link both push commands
+
+//--- onWakeTimer -----------------------------------------
+
+static void onWakeTimer (void *arg)
+{
+  // esp_timer task: the deadline Node::Run() was sleeping for has come
+  Node::Wake ();
+}
+
+//--- Wake ------------------------------------------------
+
+void Node::Wake ()
+{
+  // Called by other tasks when they leave work for Run()
+  if (RunTask != NULL)
+    xTaskNotifyGive (RunTask);
+}
+
+//--- SubmitReport ----------------------------------------
+
+bool Node::SubmitReport (const DPacket &packet)
+{
+  // Called by tasks other than Run()'s: copy <packet> into <ReportQueue>
+  // without waiting for room, then wake Run() to send it.
+  if (ReportQueue == NULL || xQueueSend (ReportQueue, &packet, 0) != pdTRUE)
+    return false;
+
+  Wake ();
+  return true;
+}
+
 //--- Constructor -----------------------------------------
 
 Node::Node (const char *inName, int inNodeID)
@@ -62,6 +124,7 @@ Node::Node (const char *inName, int inNodeID)
   name[MAX_NAME_LENGTH-1] = 0;
 
   sprintf (nodeID, "%02d", inNodeID);
+  nodeNumber = inNodeID;
 
   strcpy (version, "2025.07.21b");  // no more than 11 chars
 
@@ -136,17 +199,108 @@ Node::Node (const char *inName, int inNodeID)
     Serial.println (ESPNOW_Result);
     return;
   }
+
+  // Register send event
+  ESPNOW_Result = esp_now_register_send_cb (onDataPacketSent);
+  if (ESPNOW_Result != ESP_OK)
+  {
+    Serial.print   ("ERROR: Unable to register ESP-NOW send handler: ");
+    Serial.println (ESPNOW_Result);
+    return;
+  }
+
+  // Reports from other tasks are sent by Run()
+  if (ReportQueue == NULL)
+    ReportQueue = xQueueCreate (REPORT_QUEUE_LENGTH, sizeof(DPacket));
+
+  // Start sending Data Strings from their own task
+  StartSender ();
+}
+
+//--- StartSender -----------------------------------------
+
+void Node::StartSender ()
+{
+  // Without the queue or the task, TransmitFrame() sends on the caller's task
+  TxSlots = xSemaphoreCreateCounting (TX_MAX_IN_FLIGHT, TX_MAX_IN_FLIGHT);
+  TxQueue = xQueueCreate (TX_QUEUE_LENGTH, sizeof(TxFrame));
+
+  if (TxSlots == NULL || TxQueue == NULL ||
+      xTaskCreatePinnedToCore (SenderMain, "NodeSender", TX_TASK_STACK, this, TX_TASK_PRIORITY, &txTask, TX_TASK_CORE) != pdPASS)
+  {
+    Serial.println ("ERROR: Unable to start the sender task, sending directly");
+
+    // Sending directly, nothing takes a slot, so none must be given back
+    if (TxQueue != NULL)
+      vQueueDelete (TxQueue);
+    if (TxSlots != NULL)
+      vSemaphoreDelete (TxSlots);
+    TxQueue = NULL;
+    TxSlots = NULL;
+    txTask  = NULL;
+  }
+}
+
+//--- SenderMain ------------------------------------------
+
+void Node::SenderMain (void *arg)
+{
+  // Body of the sender task: hand queued frames to ESP-NOW, keeping no more
+  // than TX_MAX_IN_FLIGHT of them waiting for their send callback
+  Node     *node = (Node *) arg;
+  TxFrame  txFrame;
+
+  while (true)
+  {
+    if (xQueueReceive (TxQueue, &txFrame, portMAX_DELAY) != pdTRUE)
+      continue;
+
+    // Never hand ESP-NOW more than TX_MAX_IN_FLIGHT frames.  A send callback later
+    // than TX_CALLBACK_TIMEOUT_MS is counted, and the frame keeps waiting: ESP-NOW
+    // calls back once for every frame it took, so the slot does come back.  Frames
+    // queued meanwhile raise TxBackpressure(), or are dropped when the queue is full.
+    while (xSemaphoreTake (TxSlots, pdMS_TO_TICKS (TX_CALLBACK_TIMEOUT_MS)) != pdTRUE)
+      ++node->txTimeouts;
+
+    node->SendFrame (txFrame.data, txFrame.length, txFrame.traces, txFrame.traceSerial, (Transport) txFrame.transport);
+  }
+}
+
+//--- TxBackpressure --------------------------------------
+
+bool Node::TxBackpressure (TrafficClass trafficClass)
+{
+  // Called before a Device's report is built (Device::RunPeriodic(), any task).
+  // true means the transmit queue is nearly full, or the rate limits
+  // would drop a report of <trafficClass>, so skip the report.
+  if (TxQueue != NULL && uxQueueMessagesWaiting (TxQueue) >= TX_BACKPRESSURE_LEVEL)
+  {
+    TxBackpressureSkips.fetch_add (1, std::memory_order_relaxed);
+    return true;
+  }
+
+  if (!ByteBucket.Admits (trafficClass) || !RecordBucket.Admits (trafficClass))
+  {
+    LimitSkips.fetch_add (1, std::memory_order_relaxed);
+    return true;
+  }
+
+  return false;
 }
 
 //--- AddDevice -------------------------------------------
 
 void Node::AddDevice (Device *device)
 {
-  if (numDevices < MAX_DEVICES)
+  if (numDevices < MAX_DEVICES && numDevices != NODE_DEVICE_ID)
   {
-    // Assign the next DeviceID to the Device (00-99)
+    // Assign the next DeviceID to the Device (00-98, NODE_DEVICE_ID is the Node's)
     device->SetID (numDevices);
 
+    // Hand it to the scheduler, unless it will run on its own task
+    if (!device->IsOnTask ())
+      device->SetScheduler (&scheduler);
+
     // Add Device to the devices array
     devices[numDevices++] = device;
 
@@ -156,315 +310,1703 @@ void Node::AddDevice (Device *device)
   }
 }
 
+//--- UseSerialLink ---------------------------------------
+
+void Node::UseSerialLink (SerialLink *link)
+{
+  serialLink = link;
+}
+
 //--- SendDataPacket --------------------------------------
 
-IRAM_ATTR void Node::SendDataPacket ()
+IRAM_ATTR void Node::SendDataPacket (DPacket &packet)
 {
-  // Convert the <DataPacket> to a Data string.
-  // The <DataPacket> structure must be populated with deviceID, timestamp and value fields.
-  //
-  // A Data string has four fields separated with the '|' char:
-  //
-  //   ┌──────────────────── 2-char nodeID (00-19)
-  //   │  ┌───────────────── 2-char deviceID (00-99)
-  //   │  │     ┌─────────── variable length timestamp (usually millis())
-  //   │  │     │        ┌── variable length value string (including NULL terminating char)
-  //   │  │     │        │   this can be a numerical value or a text message
-  //   │  │     │        │
-  //   nn|dd|timestamp|value
-  //
-  // Data Strings must be NULL terminated.
+  // Only the Run() task may call this; other tasks use SubmitReport().
+  SendRecord (packet, ClassOf (packet));
+}
 
-  // Build the Data String
-  memset (DataString + 2, '|', 4);
-  memcpy (DataString, nodeID, ID_SIZE);
-  memcpy (DataString + 3, DataPacket.deviceID, ID_SIZE);
-  ltoa   (DataPacket.timestamp, DataString + 6, 10);
-  strcat (DataString, "|");
-  strcat (DataString, DataPacket.value);
-
-  //=============================
-  // Send Data String to Relayer
-  //=============================                                                              ┌─ include string terminator
-  ESPNOW_Result = esp_now_send (RelayerMAC, (const uint8_t *) DataString, strlen(DataString) + 1);
-  if (ESPNOW_Result != ESP_OK)
-  {
-    Serial.print   ("ERROR: Unable to send Data String: ");
-    Serial.println (ESPNOW_Result);
-  }
+//--- ClassOf ---------------------------------------------
 
-  if (Debugging)
-  {
-    // Show the outgoing Data String
-    Serial.print   ("Node --> Relayer : ");
-    Serial.println (DataString);
-  }
+IRAM_ATTR TrafficClass Node::ClassOf (const DPacket &packet)
+{
+  // Anything sent while a command runs is its response,
+  // the rest belongs to its Device, or is the Node's own status
+  if (executingCommand)
+    return TRAFFIC_RESPONSE;
+
+  int index = 10*(packet.deviceID[0]-'0') + (packet.deviceID[1]-'0');
+  if (index >= 0 && index < numDevices)
+    return devices[index]->GetTrafficClass ();
+
+  return TRAFFIC_STATUS;
 }
 
-//=========================================================
-//  Run:
-//
-//  This method is called continuously in the loop function
-//  of the main.cpp file.
-//
-//  It calls the Run() method for all Devices
-//  and processes any Relayer/Interface commands.
-//=========================================================
+//--- SendRecord ------------------------------------------
 
-void Node::Run ()
+IRAM_ATTR void Node::SendRecord (DPacket &packet, TrafficClass trafficClass)
 {
-  //===================================
-  //  Run all Devices
-  //===================================
-  for (deviceIndex=0; deviceIndex<numDevices; deviceIndex++)
+  // Drop <packet> if the rate limits do not admit its class, before
+  // anything is formatted.  Otherwise convert it to a Data String
+  // (ASCII_FORMAT) or a binary Data Frame (BINARY_FORMAT), then send it
+  // to the Relayer right away or add it to the current batch.
+  int64_t  now = esp_timer_get_time ();
+
+  ByteBucket.Refill (now);
+  RecordBucket.Refill (now);
+
+  if (!ByteBucket.Admits (trafficClass) || !RecordBucket.Admits (trafficClass))
   {
-    //--- Immediate Processing ---
-    if (devices[deviceIndex]->IsIPEnabled ())
-    {
-      // Perform Immediate Processing
-      pStatus = devices[deviceIndex]->DoImmediate ();
+    ++limitDrops[trafficClass];
+    packet.numFields = 0;
+    return;
+  }
 
-      // Any data to send?
-      if (pStatus == SUCCESS_DATA || pStatus == FAIL_DATA)
-      {
-        // Populate DeviceID and send it
-        memcpy (DataPacket.deviceID, devices[deviceIndex]->GetID(), ID_SIZE);
-        SendDataPacket ();
-      }
-    }
+  ++limitSent[trafficClass];
+  RecordBucket.Charge (1.0f);
 
-    //--- Periodic Processing ---
-    if (devices[deviceIndex]->IsPPEnabled ())
-    {
-      // Perform Periodic Processing
-      pStatus = devices[deviceIndex]->RunPeriodic ();
+  int       length = (dataFormat == BINARY_FORMAT) ? EncodeBinary (packet) : EncodeAscii (packet);
+  uint16_t  traces = (currentTrace >= 0) ? (uint16_t)(1 << currentTrace) : 0;
 
-      // Any data to send?
-      if (pStatus == SUCCESS_DATA || pStatus == FAIL_DATA)
-      {
-        // Populate DeviceID and send it
-        memcpy (DataPacket.deviceID, devices[deviceIndex]->GetID(), ID_SIZE);
-        SendDataPacket ();
-      }
-    }
-  }
+  if (batchDeadlineUs == 0)
+    TransmitFrame ((const uint8_t *) dataString, length, 1, traces, traceSerial);
+  else
+    AddToBatch (length, traces, traceSerial);
 
-  //===================================
-  //  Check for any commands
-  //===================================
-  if (CommandBuffer->GetNumElements() < 1)
-    return;
+  // Typed fields are only good for one packet
+  packet.numFields = 0;
+}
 
-  //--- Process next command ---
-  commandString = CommandBuffer->PopString ();  // Remember to free() this "popped" string
+//--- AddToBatch ------------------------------------------
+
+IRAM_ATTR void Node::AddToBatch (int length, uint16_t traces, uint32_t traceSerial)
+{
+  // Append the record just encoded in <dataString> to <batchFrame>.
+  // The batch is flushed first if the record does not fit, or is in another format (SDPF).
+  // See DATA_BATCH_MARKER in common.h for the batched frame layouts.
+  bool  binary = (batchFormat == BINARY_FORMAT);
+  int   needed = binary ? length + 1 : length;  // ASCII: the record's NULL becomes the '\n' separator
 
-  if (commandString != NULL)
+  if (batchRecords > 0)
   {
-    if (Debugging)
+    if (batchFormat != dataFormat)
+      FlushBatch ();  // not a size flush: BSTAT does not count it
+    else if (batchLength + needed > MAX_MESSAGE_LENGTH)
     {
-      Serial.print   ("commandString=");
-      Serial.println (commandString);
+      ++sizeFlushes;
+      FlushBatch ();
     }
+  }
 
-    int cLength = strlen (commandString);
+  if (batchRecords == 0)
+  {
+    batchFormat = dataFormat;
+    binary      = (batchFormat == BINARY_FORMAT);
+    needed      = binary ? length + 1 : length;
+    batchLength = binary ? DATA_BATCH_HEADER_SIZE : 0;
 
-    // Check length
-    if (cLength < MIN_COMMAND_LENGTH)
-      Serial.println ("ERROR: Invalid command");
-    else
+    // A record too big to share a frame goes out on its own
+    if (batchLength + needed > MAX_MESSAGE_LENGTH)
     {
-      // Populate the global <CommandPacket>
-      CommandPacket.deviceIndex = deviceIndex = 10*((int)(commandString[0])-48) + ((int)(commandString[1])-48);
-
-      memcpy (CommandPacket.command, commandString + 3, COMMAND_SIZE);
-      CommandPacket.command[COMMAND_SIZE] = 0;
+      TransmitFrame ((const uint8_t *) dataString, length, 1, traces, traceSerial);
+      return;
+    }
 
-      if (cLength > MIN_COMMAND_LENGTH + 1)
-        strcpy (CommandPacket.params, commandString + 8);
-      else
-        CommandPacket.params[0] = 0;
+    batchStartUs = esp_timer_get_time ();
+  }
 
-      // Execute the command
-      pStatus = ExecuteCommand ();
+  if (binary)
+  {
+    batchFrame[batchLength++] = (uint8_t) length;
+    memcpy (batchFrame + batchLength, dataString, length);
+    batchLength += length;
+  }
+  else
+  {
+    if (batchRecords > 0)
+      batchFrame[batchLength - 1] = '\n';  // Replace the previous record's NULL terminator
 
-      // Check if command is still not handled
-      if (pStatus == NOT_HANDLED)
-      {
-        //=================================================
-        // Not a Node command, so pass to Device to handle
-        //=================================================
+    memcpy (batchFrame + batchLength, dataString, length);
+    batchLength += length;
+  }
 
-        // Check deviceIndex range
-        if (deviceIndex >= numDevices)
-        {
-          if (Debugging)
-          {
-            Serial.print ("Command targeted for unknown device: ");
-            Serial.print ("deviceIndex="); Serial.print (deviceIndex);
-            Serial.print (", numDevices="); Serial.println (numDevices);
-          }
-
-          strcpy (DataPacket.value, "ERROR: Command targeted for unknown device");
-          pStatus = FAIL_DATA;
-        }
-        else
-          pStatus = devices[deviceIndex]->ExecuteCommand ();
-      }
+  ++batchRecords;
+  if (traces != 0)
+  {
+    batchTraces     |= traces;
+    batchTraceSerial = traceSerial;
+  }
+}
 
-      // Any data to send?
-      if (pStatus == SUCCESS_DATA || pStatus == FAIL_DATA)
-      {
-        // Populate deviceID
-        memcpy (DataPacket.deviceID, commandString, ID_SIZE);
+//--- FlushBatch ------------------------------------------
 
-        SendDataPacket ();
-      }
-    }
+IRAM_ATTR void Node::FlushBatch ()
+{
+  // Send the batched records, if any
+  if (batchRecords == 0)
+    return;
 
-    //====================================
-    // Free the Popped string from buffer
-    //====================================
-    free (commandString);
+  if (batchFormat == BINARY_FORMAT)
+  {
+    batchFrame[0] = DATA_BATCH_MARKER;
+    batchFrame[1] = (uint8_t) batchRecords;
   }
+
+  TransmitFrame (batchFrame, batchLength, batchRecords, batchTraces, batchTraceSerial);
+
+  batchRecords = 0;
+  batchLength  = 0;
+  batchTraces  = 0;
 }
 
-//--- GetVersion ------------------------------------------
+//--- CheckBatchDeadline ----------------------------------
 
-const char * Node::GetVersion ()
+void Node::CheckBatchDeadline ()
 {
-  return version;
+  // Flush a partial batch once its oldest record has waited <batchDeadlineUs>
+  if (batchRecords > 0 && (esp_timer_get_time () - batchStartUs) >= (int64_t) batchDeadlineUs)
+  {
+    ++deadlineFlushes;
+    FlushBatch ();
+  }
 }
 
-//=========================================================
-//  ExecuteCommand:
-//
-//  This method handles the built-in Node commands and
-//  sets a ProcessStatus.  Override this method in your
-//  child Node class to handle custom Node commands.
-//  Your method should first call this base class method,
-//  then handle custom commands.
-//  If the command is not handled by the Node, then pass
-//  it to the Device's ExecuteCommand() method.
-//=========================================================
+//--- TransmitFrame ---------------------------------------
 
-ProcessStatus Node::ExecuteCommand ()
+IRAM_ATTR void Node::TransmitFrame (const uint8_t *frame, int length, int records, uint16_t traces, uint32_t traceSerial)
 {
-  // Init ProcessStatus
-  pStatus = NOT_HANDLED;
-
-  //--- Set Node Name (SNNA) ------------------------------
-  if (strncmp (CommandPacket.command, "SNNA", COMMAND_SIZE) == 0)
+  //===============================
+  // Queue the frame for the sender
+  //===============================
+  // Frames queued before an SXPT still go out on the transport they were made for
+  Transport  transport = (Transport) ActiveTransport.load (std::memory_order_relaxed);
+
+  if (TxQueue == NULL)
+    SendFrame (frame, length, traces, traceSerial, transport);
+  else
   {
-    // Set this Node's name
-    strncpy (name, CommandPacket.params, MAX_NAME_LENGTH-1);
-    name[MAX_NAME_LENGTH-1] = 0;
+    TxFrame  txFrame;
+    txFrame.length    = (uint8_t) length;
+    txFrame.transport = (uint8_t) transport;
+    txFrame.traces    = traces;
+    txFrame.traceSerial = traceSerial;
+    memcpy (txFrame.data, frame, length);
+
+    if (xQueueSend (TxQueue, &txFrame, 0) != pdTRUE)
+    {
+      ++txQueueFull;
 
-    // Acknowledge new name
-    strcpy (DataPacket.value, "NONAME=");
-    strcat (DataPacket.value, name);
+      if (Debugging)
+        Serial.println ("ERROR: Transmit queue full, frame dropped");
+      return;
+    }
 
-    pStatus = SUCCESS_DATA;
+    int depth = uxQueueMessagesWaiting (TxQueue);
+    if (depth > txQueueHighWater)
+      txQueueHighWater = depth;
   }
 
-  //--- Get Node Info (GNOI) ----------------------------
-  else if (strncmp (CommandPacket.command, "GNOI", COMMAND_SIZE) == 0)
-  {
-    // Send Node info
-    sprintf (DataPacket.value, "NOINFO=%s|%s|%s|%d", name, version, macAddressString, numDevices);
+  // Charge the airtime, whatever class its records are
+  ByteBucket.Charge ((float)(length + AIRTIME_FRAME_OVERHEAD));
+
+  // Statistics
+  ++txQueued;
+  ++framesSent;
+  recordsSent += records;
+  ++recordsPerFrame[(records < BATCH_HISTOGRAM_SIZE ? records : BATCH_HISTOGRAM_SIZE) - 1];
 
-    pStatus = SUCCESS_DATA;
+  if (Debugging)
+  {
+    // Show the outgoing Data String
+    Serial.print   ("Node --> Relayer : ");
+    if (frame[0] == DATA_FRAME_MARKER || frame[0] == DATA_BATCH_MARKER)
+      Serial.printf ("%d-byte binary frame, %d record(s)\n", length, records);
+    else
+      Serial.println ((const char *) frame);
   }
+}
 
-  //--- Get Device Info (GDEI) ----------------------------
-  else if (strncmp (CommandPacket.command, "GDEI", COMMAND_SIZE) == 0)
+//--- SendFrame -------------------------------------------
+
+IRAM_ATTR void Node::SendFrame (const uint8_t *frame, int length, uint16_t traces, uint32_t traceSerial, Transport transport)
+{
+  if (transport == TRANSPORT_SERIAL && serialLink != NULL)
   {
-    // For each Device, send a Device Data Packet with value = name|ipEnabled(Y/N)|ppEnabled(Y/N)|periodic data rate
-    for (int i=0; i<numDevices; i++)
+    //============================
+    // Write the frame to the host
+    //============================
+    // The frame is done when it is written, there is no send callback
+    if (serialLink->Send (SERIAL_FRAME_DATA, frame, length))
+      TxDelivered.fetch_add (1, std::memory_order_relaxed);
+    else
+      TxFailed.fetch_add (1, std::memory_order_relaxed);
+
+    if (TxSlots != NULL)
+      xSemaphoreGive (TxSlots);
+  }
+  else
+  {
+    //=============================
+    // Send Data String to Relayer
+    //=============================
+    esp_err_t  result = esp_now_send (RelayerMAC, frame, length);
+    if (result != ESP_OK)
     {
-      sprintf (DataPacket.deviceID, "%02d", i);
-      DataPacket.timestamp = millis ();
-      sprintf (DataPacket.value, "DEINFO=%s|%s|%c|%c|%lu|", devices[i]->GetName(), devices[i]->GetVersion(), devices[i]->IsIPEnabled() ? 'Y':'N', devices[i]->IsPPEnabled() ? 'Y':'N', devices[i]->GetRate());
-      SendDataPacket ();
+      // No send callback will come for this frame, so hand its slot back
+      ++txSendErrors;
+      if (TxSlots != NULL)
+        xSemaphoreGive (TxSlots);
+
+      Serial.print   ("ERROR: Unable to send Data String: ");
+      Serial.println (result);
+      return;
     }
 
-    // All Device data has been sent, no need to send anything else
-    pStatus = SUCCESS_NODATA;
+    if (TxSlots != NULL)
+    {
+      int inFlight = TX_MAX_IN_FLIGHT - (int) uxSemaphoreGetCount (TxSlots);
+      if (inFlight > txInFlightHighWater)
+        txInFlightHighWater = inFlight;
+    }
   }
 
-  //--- Ping (PING) ---------------------------------------
-  else if (strncmp (CommandPacket.command, "PING", COMMAND_SIZE) == 0)
+  // Stamp the traced commands this frame answers (the first frame of a response counts).
+  // By now StartTrace() may have given a slot to a newer command: its serial is then
+  // past the frame's <traceSerial>, and it is left alone.
+  if (traces != 0)
   {
-    // Got PINGed from Interface, Respond with PONG
-    strcpy (DataPacket.value, "PONG");
+    int64_t  now = esp_timer_get_time ();
+
+    for (int i=0; i<TRACE_LENGTH; i++)
+    {
+      CommandTrace  *trace = &this->traces[i];
+      uint32_t      serial = trace->serial.load (std::memory_order_acquire);
 
-    pStatus = SUCCESS_DATA;
+      if (!(traces & (1 << i)) || (int32_t)(serial - traceSerial) > 0)
+        continue;
+
+      uint32_t  sent     = (uint32_t)(now - trace->receivedUs);
+      uint32_t  expected = 0;
+      if (sent == 0)
+        sent = 1;
+
+      // Taken while it was stamped: undo it, unless StartTrace() already cleared it
+      if (trace->sentUs.compare_exchange_strong (expected, sent, std::memory_order_acq_rel)
+          && trace->serial.load (std::memory_order_acquire) != serial)
+        trace->sentUs.compare_exchange_strong (sent, 0, std::memory_order_acq_rel);
+    }
   }
+}
 
-  //--- Blink (BLIN) --------------------------------------
-  else if (strncmp (CommandPacket.command, "BLIN", COMMAND_SIZE) == 0)
+//--- EncodeAscii -----------------------------------------
+
+IRAM_ATTR int Node::EncodeAscii (const DPacket &packet)
+{
+  // A Data string has four fields separated with the '|' char:
+  //
+  //   ┌──────────────────── 2-char nodeID (00-19)
+  //   │  ┌───────────────── 2-char deviceID (00-99)
+  //   │  │     ┌─────────── variable length timestamp (usually millis())
+  //   │  │     │        ┌── variable length value string (including NULL terminating char)
+  //   │  │     │        │   this can be a numerical value or a text message
+  //   │  │     │        │   or the typed fields joined with '|'
+  //   │  │     │        │
+  //   nn|dd|timestamp|value
+  //
+  // Data Strings must be NULL terminated.
+  // Returns the length of the Data String including the NULL terminator.
+
+  memset (dataString + 2, '|', 4);
+  memcpy (dataString, nodeID, ID_SIZE);
+  memcpy (dataString + 3, packet.deviceID, ID_SIZE);
+  ultoa  (packet.timestamp, dataString + 6, 10);
+
+  char  *cursor = dataString + strlen (dataString);
+  char  *last   = dataString + MAX_MESSAGE_LENGTH - 1;  // Room for the NULL terminator
+  *cursor++ = '|';
+
+  if (packet.numFields == 0)
   {
-    // Blink the Status LED
-    for (int i=0; i<10; i++)
+    // Value string
+    int length = strnlen (packet.value, last - cursor);
+    memcpy (cursor, packet.value, length);
+    cursor += length;
+  }
+  else
+  {
+    // Typed fields
+    char  number[16];
+    for (int i=0; i<packet.numFields; i++)
     {
-      STATUS_LED_BAD;
-      delay (80);
+      const DField  *field = &packet.fields[i];
+      const char    *text  = number;
 
-      STATUS_LED_GOOD;
-      delay (20);
-    }
+      switch (field->type)
+      {
+        case FIELD_INT32  : ltoa  (field->i32, number, 10);                         break;
+        case FIELD_UINT32 : ultoa (field->u32, number, 10);                         break;
+        case FIELD_FLOAT  : snprintf (number, sizeof(number), "%f", field->f32);    break;
+        case FIELD_TEXT   : text = (field->text != NULL) ? field->text : "";        break;
+        default           : number[0] = 0;                                          break;
+      }
 
-    pStatus = SUCCESS_NODATA;
+      if (i > 0 && cursor < last)
+        *cursor++ = '|';
+
+      int length = strnlen (text, last - cursor);
+      memcpy (cursor, text, length);
+      cursor += length;
+    }
   }
 
-  //--- Get Version (GNVR) --------------------------------
-  else if (strncmp (CommandPacket.command, "GNVR", COMMAND_SIZE) == 0)
+  *cursor++ = 0;
+  return cursor - dataString;
+}
+
+//--- EncodeBinary ----------------------------------------
+
+IRAM_ATTR int Node::EncodeBinary (const DPacket &packet)
+{
+  // See DATA_FRAME_MARKER in common.h for the frame layout.
+  // Returns the length of the frame.
+
+  uint8_t  *frame  = (uint8_t *) dataString;
+  uint8_t  *cursor = frame + DATA_FRAME_HEADER_SIZE;
+  uint8_t  *end    = frame + MAX_MESSAGE_LENGTH;
+  uint32_t  word;
+
+  frame[0] = DATA_FRAME_MARKER;
+  frame[1] = (uint8_t) nodeNumber;
+  frame[2] = (uint8_t) (10*(packet.deviceID[0]-'0') + (packet.deviceID[1]-'0'));
+  frame[3] = 0;
+
+  word = (uint32_t) packet.timestamp;
+  frame[4] = word;  frame[5] = word >> 8;  frame[6] = word >> 16;  frame[7] = word >> 24;
+
+  if (packet.numFields == 0)
   {
-    sprintf (DataPacket.value, "NVER=%s", version);
-    pStatus = SUCCESS_DATA;
+    // Value string fills the rest of the frame (<value> holds at most MAX_VALUE_LENGTH chars)
+    int room   = end - cursor;
+    int length = strnlen (packet.value, room < MAX_VALUE_LENGTH ? room : MAX_VALUE_LENGTH);
+    memcpy (cursor, packet.value, length);
+    return DATA_FRAME_HEADER_SIZE + length;
   }
 
-  //--- Reset (RSET) --------------------------------------
-  else if (strncmp (CommandPacket.command, "RSET", COMMAND_SIZE) == 0)
+  for (int i=0; i<packet.numFields; i++)
   {
-    // Acknowledge Reset
-    Serial.println ("Resetting Node ... ");
+    const DField  *field = &packet.fields[i];
 
-    // Reset this Node
-    esp_restart();
-    // x x
-    //  o
-  }
-
-  // Populate timestamp if data to return
-  if (pStatus == SUCCESS_DATA || pStatus == FAIL_DATA)
-    DataPacket.timestamp = millis();
+    if (field->type == FIELD_TEXT)
+    {
+      const char *text = (field->text != NULL) ? field->text : "";
+      int length = strnlen (text, MAX_TEXT_FIELD_LENGTH);
+      if (cursor + 2 + length > end)
+        break;
+
+      *cursor++ = FIELD_TEXT;
+      *cursor++ = (uint8_t) length;
+      memcpy (cursor, text, length);
+      cursor += length;
+    }
+    else
+    {
+      if (cursor + 5 > end)
+        break;
 
-  // Return the resulting ProcessStatus
-  return pStatus;
-}
+      // i32, u32 and f32 share the same 4 bytes
+      memcpy (&word, &field->u32, sizeof(word));
+      *cursor++ = field->type;
+      *cursor++ = word;  *cursor++ = word >> 8;  *cursor++ = word >> 16;  *cursor++ = word >> 24;
+    }
 
+    frame[3]++;
+  }
 
+  return cursor - frame;
+}
 
 //=========================================================
-// External ESP-NOW "C" Functions
+//  Run:
+//
+//  This method is called continuously in the loop function
+//  of the main.cpp file.
+//
+//  It drains queued Relayer/Interface commands (within the
+//  drain policy limits) and then calls the Run() method for
+//  all Devices.  Commands go first so a burst of joystick
+//  commands is not held up behind the Device loop.
 //=========================================================
 
-//--- onCommandReceived -----------------------------------
-
-// void onCommandReceived (const uint8_t *relayerMAC, const uint8_t *commandString, int commandLength)  // ESP-NOW v1
-void onCommandReceived (const esp_now_recv_info_t *info, const uint8_t *commandString, int commandLength)  // ESP-NOW v2
+void Node::Run ()
 {
-  if (Debugging)
+  bool           anyImmediate = false;
+  DPacket        packet;  // This pass's process reports
+  ProcessStatus  pStatus;
+  int64_t        runStart = esp_timer_get_time ();
+
+  // Time from the last pass to this one
+  if (lastRunStartUs > 0)
+    loopProfile.Record (runStart - lastRunStartUs);
+  lastRunStartUs = runStart;
+
+  // Keep the rate limits current for the Device tasks' TxBackpressure()
+  ByteBucket.Refill (runStart);
+  RecordBucket.Refill (runStart);
+
+  // Remember which task runs the Node, so other tasks can wake it,
+  // then start the Device tasks
+  if (RunTask == NULL)
   {
-    // Show the incoming Command string
-    Serial.print   ("Node <-- Relayer : ");
-    Serial.println ((char *) commandString);
+    RunTask = xTaskGetCurrentTaskHandle ();
+    StartDeviceTasks ();
   }
 
-  // Check if Relayer responded to initial Node PING
-  if (strncmp ((char *) commandString, "PONG", 4) == 0)
-    WaitingForRelayer = false;
-  else
-    // Add this ESP-NOW message to the command buffer
-    CommandBuffer->PushString ((char *) commandString);
+  //===================================
+  //  Process queued commands
+  //===================================
+  RunCommands ();
+
+  //===================================
+  //  Send reports from Device tasks
+  //===================================
+  SendTaskResults ();
+
+  //===================================
+  //  Immediate Processing
+  //  (Devices on their own task
+  //   run their own)
+  //===================================
+  for (deviceIndex=0; deviceIndex<numDevices; deviceIndex++)
+  {
+    if (devices[deviceIndex]->IsIPEnabled () && !devices[deviceIndex]->IsOnTask ())
+    {
+      anyImmediate = true;
+
+      // Perform Immediate Processing
+      packet.numFields = 0;
+      pStatus = devices[deviceIndex]->RunImmediate (packet);
+
+      // Any data to send?
+      if (pStatus == SUCCESS_DATA || pStatus == FAIL_DATA)
+      {
+        // Populate DeviceID and send it
+        memcpy (packet.deviceID, devices[deviceIndex]->GetID(), ID_SIZE);
+        SendDataPacket (packet);
+      }
+    }
+  }
+
+  //===================================
+  //  Periodic Processing
+  //  (only the Devices that are due)
+  //===================================
+  int64_t  now = esp_timer_get_time ();
+  Device   *device;
+
+  while ((device = scheduler.NextDue (now)) != NULL)
+  {
+    // Set the next deadline first, DoPeriodic() may reschedule itself
+    scheduler.Advance (device, now);
+
+    // Perform Periodic Processing
+    packet.numFields = 0;
+    pStatus = device->RunPeriodic (packet);
+
+    // Any data to send?
+    if (pStatus == SUCCESS_DATA || pStatus == FAIL_DATA)
+    {
+      // Populate DeviceID and send it
+      memcpy (packet.deviceID, device->GetID(), ID_SIZE);
+      SendDataPacket (packet);
+    }
+  }
+
+  //===================================
+  //  Send a partial batch when due
+  //===================================
+  CheckBatchDeadline ();
+
+  //===================================
+  //  Send profiles when due (SPRF)
+  //===================================
+  CheckProfileReport ();
+
+  //===================================
+  //  Sample subscribed fields (SSUB)
+  //===================================
+  SendSubscriptions ();
+
+  busyProfile.Record (esp_timer_get_time () - runStart);
+
+  //===================================
+  //  Sleep until there is work to do
+  //===================================
+  if (!anyImmediate)
+    WaitForWork ();
+}
+
+//=========================================================
+//  StartDeviceTasks:
+//
+//  Start the task of each Device that asked for one with
+//  Device::RunOnTask().  A Device whose task cannot be
+//  started runs on the Node's task instead.
+//=========================================================
+
+void Node::StartDeviceTasks ()
+{
+  for (int i=0; i<numDevices; i++)
+  {
+    if (!devices[i]->IsOnTask ())
+      continue;
+
+    if (!devices[i]->StartTask ())
+    {
+      Serial.print   ("ERROR: Unable to start a task for ");
+      Serial.println (devices[i]->GetName());
+
+      devices[i]->SetScheduler (&scheduler);
+    }
+  }
+}
+
+//--- SendTaskResults -------------------------------------
+
+void Node::SendTaskResults ()
+{
+  // Send the reports other tasks have queued, in the order they were made
+  if (ReportQueue == NULL)
+    return;
+
+  DPacket  packet;
+
+  while (xQueueReceive (ReportQueue, &packet, 0) == pdTRUE)
+    SendDataPacket (packet);
+}
+
+//=========================================================
+//  SendProfiles:
+//
+//  Send one DPROF report for each kind of call each Device
+//  has made, then the Node's NPROF=L (Run() period) and
+//  NPROF=B (busy) reports as Device <index>.
+//=========================================================
+
+void Node::SendProfiles (int index)
+{
+  DPacket  packet;
+
+  packet.numFields = 0;
+
+  for (int i=0; i<numDevices; i++)
+  {
+    for (int kind=0; kind<NUM_PROFILE_KINDS; kind++)
+    {
+      if (devices[i]->GetProfile ((ProfileKind) kind, packet.value) > 0)
+      {
+        sprintf (packet.deviceID, "%02d", i);
+        packet.timestamp = millis ();
+        SendDataPacket (packet);
+      }
+    }
+  }
+
+  sprintf (packet.deviceID, "%02d", index);
+  packet.timestamp = millis ();
+
+  loopProfile.Format (packet.value + sprintf (packet.value, "NPROF=L|"));
+  SendDataPacket (packet);
+
+  busyProfile.Format (packet.value + sprintf (packet.value, "NPROF=B|"));
+  SendDataPacket (packet);
+}
+
+//--- CheckProfileReport ----------------------------------
+
+void Node::CheckProfileReport ()
+{
+  if (profileReportSecs == 0)
+    return;
+
+  int64_t  now = esp_timer_get_time ();
+  if (now < nextProfileReportUs)
+    return;
+
+  nextProfileReportUs = now + (int64_t) profileReportSecs * 1000000;
+  SendProfiles (NODE_DEVICE_ID);  // unrequested: tagged as the Node, not as any Device
+}
+
+//=========================================================
+//  SendSubscriptions:
+//
+//  Sample each subscribed field that is due and send the
+//  samples of each Device as SUBV records.  A field that
+//  fell a period or more behind skips the missed samples
+//  and stays on its period grid.  Nothing is sampled
+//  while telemetry would be dropped (TxBackpressure()).
+//=========================================================
+
+void Node::SendSubscriptions ()
+{
+  int64_t  now = esp_timer_get_time ();
+
+  if (now < nextSubscriptionUs)
+    return;
+
+  DPacket   packet;
+  int       index     = -1;  // Device of the record being built
+  uint32_t  fieldMask = 0;
+  bool      skip      = TxBackpressure (TRAFFIC_TELEMETRY);  // Do not even sample what would be dropped
+
+  packet.timestamp   = (unsigned long)(now / 1000);
+  packet.numFields   = 0;
+  nextSubscriptionUs = INT64_MAX;
+
+  for (int i=0; i<numSubscriptions; i++)
+  {
+    Subscription  *sub = &subscriptions[i];
+
+    if (sub->nextUs <= now)
+    {
+      if (!skip)
+      {
+        // A new Device, or a full record, starts a new record
+        if (sub->deviceIndex != index || packet.numFields >= MAX_DATA_FIELDS)
+        {
+          SendSamples (packet, index, fieldMask);
+
+          index     = sub->deviceIndex;
+          fieldMask = 0;
+          packet.AddTextField (SUBSCRIPTION_TAG);
+          packet.AddUIntField (0);  // The field mask, filled in by SendSamples()
+        }
+
+        if (devices[index]->RunSample (sub->field, packet))
+          fieldMask |= 1 << sub->field;
+      }
+
+      sub->nextUs += sub->periodUs;
+      if (sub->nextUs <= now)
+        sub->nextUs += ((now - sub->nextUs) / sub->periodUs + 1) * sub->periodUs;
+    }
+
+    if (sub->nextUs < nextSubscriptionUs)
+      nextSubscriptionUs = sub->nextUs;
+  }
+
+  SendSamples (packet, index, fieldMask);
+}
+
+//--- SendSamples -----------------------------------------
+
+void Node::SendSamples (DPacket &packet, int index, uint32_t fieldMask)
+{
+  // Send the SUBV record in <packet> if it holds any samples
+  if (packet.numFields > 2)
+  {
+    packet.fields[1].u32 = fieldMask;
+    sprintf (packet.deviceID, "%02d", index);
+
+    subscriptionSamples += packet.numFields - 2;
+    ++subscriptionRecords;
+
+    SendRecord (packet, TRAFFIC_TELEMETRY);
+  }
+
+  packet.numFields = 0;
+}
+
+//=========================================================
+//  WaitForWork:
+//
+//  Block the Run() task until the next periodic deadline,
+//  the batch deadline or the arrival of a command
+//  (onCommandReceived() notifies this task), but never
+//  longer than <maxIdleWaitMs> so loop() still gets to
+//  poll the Serial port.
+//
+//  The deadline is met to the microsecond by a one-shot
+//  esp_timer that notifies this task, rather than by
+//  rounding to RTOS ticks.
+//=========================================================
+
+void Node::WaitForWork ()
+{
+  if (maxIdleWaitMs == 0 || CommandBuffer->GetNumElements () > 0)
+    return;
+
+  if (ReportQueue != NULL && uxQueueMessagesWaiting (ReportQueue) > 0)
+    return;
+
+  int64_t  now    = esp_timer_get_time ();
+  int64_t  wakeAt = scheduler.NextDeadline ();
+
+  if (batchRecords > 0 && batchStartUs + (int64_t) batchDeadlineUs < wakeAt)
+    wakeAt = batchStartUs + batchDeadlineUs;
+
+  if (profileReportSecs > 0 && nextProfileReportUs < wakeAt)
+    wakeAt = nextProfileReportUs;
+
+  if (nextSubscriptionUs < wakeAt)
+    wakeAt = nextSubscriptionUs;
+
+  int64_t  waitUs = wakeAt - now;
+  if (waitUs < MIN_IDLE_WAIT_US)
+    return;  // Not worth sleeping for
+
+  if (waitUs > (int64_t) maxIdleWaitMs * 1000)
+    waitUs = (int64_t) maxIdleWaitMs * 1000;
+
+  if (wakeTimer == NULL)
+  {
+    esp_timer_create_args_t  timerArgs = {};
+    timerArgs.callback = onWakeTimer;
+    timerArgs.name     = "NodeWake";
+
+    if (esp_timer_create (&timerArgs, &wakeTimer) != ESP_OK)
+      return;
+  }
+
+  // A command that arrived after the check above has already
+  // left a notification, so this returns right away
+  ++idleWaits;
+  esp_timer_start_once (wakeTimer, waitUs);
+  ulTaskNotifyTake (pdTRUE, pdMS_TO_TICKS (maxIdleWaitMs) + 1);
+  esp_timer_stop (wakeTimer);
+
+  int64_t  wokeAt = esp_timer_get_time ();
+  if (wokeAt < now + waitUs)
+    ++notifyWakes;
+
+  idleUs += wokeAt - now;
+}
+
+//=========================================================
+//  RunCommands:
+//
+//  Execute queued commands until the buffer is empty,
+//  <maxCommandsPerRun> commands have run, or
+//  <commandBudgetUs> microseconds have passed (a limit
+//  of 0 means "no limit").  At least one command is
+//  always executed if one is waiting.
+//=========================================================
+
+void Node::RunCommands ()
+{
+  int depth = CommandBuffer->GetNumElements ();
+  if (depth < 1)
+    return;
+
+  int64_t  startTime = esp_timer_get_time ();
+  int      executed  = 0;
+
+  ++drainPasses;
+  if (depth > drainDepthHighWater)
+    drainDepthHighWater = depth;
+
+  while ((commandString = CommandBuffer->PeekString ()) != NULL)
+  {
+    ExecuteCommandString ();
+
+    // Hand the slot back to the producer
+    CommandBuffer->ReleaseString ();
+    ++executed;
+
+    // Check the drain policy
+    if (maxCommandsPerRun > 0 && executed >= maxCommandsPerRun)
+    {
+      if (CommandBuffer->GetNumElements () > 0)
+        ++drainLimitStops;
+      break;
+    }
+
+    if (commandBudgetUs > 0 && (esp_timer_get_time () - startTime) >= (int64_t) commandBudgetUs)
+    {
+      if (CommandBuffer->GetNumElements () > 0)
+        ++drainBudgetStops;
+      break;
+    }
+  }
+
+  if (executed > drainMaxPerPass)
+    drainMaxPerPass = executed;
+}
+
+//=========================================================
+//  ExecuteCommandString:
+//
+//  Parse <commandString> into a CPacket, execute it on
+//  the Node or the targeted Device and send any response.
+//  Both packets live on this call's stack.
+//=========================================================
+
+void Node::ExecuteCommandString ()
+{
+  int64_t   dequeuedAt = esp_timer_get_time ();
+  bool      traced     = false;
+  uint32_t  traceID    = 0;
+
+  if (Debugging)
+  {
+    Serial.print   ("commandString=");
+    Serial.println (commandString);
+  }
+
+  // An optional correlation ID comes first: #id|dd|CCCC|params
+  if (commandString[0] == '#')
+  {
+    char  *end;
+    traceID = strtoul (commandString + 1, &end, 10);
+    if (*end != '|')
+    {
+      Serial.println ("ERROR: Invalid correlation ID");
+      return;
+    }
+
+    commandString = end + 1;
+    traced        = true;
+  }
+
+  int cLength = strlen (commandString);
+
+  // Check length
+  if (cLength < MIN_COMMAND_LENGTH)
+  {
+    Serial.println ("ERROR: Invalid command");
+    return;
+  }
+
+  CPacket        command;
+  DPacket        reply;
+  ProcessStatus  pStatus;
+
+  // Populate <command>
+  command.deviceIndex = deviceIndex = 10*((int)(commandString[0])-48) + ((int)(commandString[1])-48);
+
+  memcpy (command.command, commandString + 3, COMMAND_SIZE);
+  command.command[COMMAND_SIZE] = 0;
+  command.key = CommandKey (command.command);
+
+  // The params stay in the CommandBuffer slot, only their token spans are recorded
+  command.params = (cLength > MIN_COMMAND_LENGTH + 1) ? commandString + 8 : "";
+  SplitParams (command);
+
+  // Start this command's trace (its response frames are stamped by SendFrame())
+  if (traced)
+    currentTrace = StartTrace (traceID, dequeuedAt);
+
+  // Execute the command
+  reply.timestamp  = millis ();
+  reply.numFields  = 0;
+  executingCommand = true;
+  pStatus = ExecuteCommand (command, reply);
+
+  // Check if command is still not handled
+  if (pStatus == NOT_HANDLED)
+  {
+    //=================================================
+    // Not a Node command, so pass to Device to handle
+    //=================================================
+
+    // Check deviceIndex range
+    if (deviceIndex >= numDevices)
+    {
+      if (Debugging)
+      {
+        Serial.print ("Command targeted for unknown device: ");
+        Serial.print ("deviceIndex="); Serial.print (deviceIndex);
+        Serial.print (", numDevices="); Serial.println (numDevices);
+      }
+
+      strcpy (reply.value, "ERROR: Command targeted for unknown device");
+      pStatus = FAIL_DATA;
+    }
+    else
+    {
+      // Timed, and locked if the Device runs on its own task
+      pStatus = devices[deviceIndex]->RunCommand (command, reply);
+    }
+  }
+
+  char  traceText[12];
+
+  if (currentTrace >= 0)
+  {
+    CommandTrace  *trace = &traces[currentTrace];
+    trace->doneUs = (uint32_t)(esp_timer_get_time () - trace->receivedUs);
+
+    traceProfiles[TRACE_QUEUE  ].Record (trace->dequeuedUs);
+    traceProfiles[TRACE_PARSE  ].Record (trace->dispatchedUs - trace->dequeuedUs);
+    traceProfiles[TRACE_HANDLER].Record (trace->doneUs - trace->dispatchedUs);
+
+    // Echo the correlation ID
+    sprintf (traceText, "#%lu", (unsigned long) traceID);
+    if (reply.numFields > 0)
+      reply.AddTextField (traceText);
+    else
+    {
+      int length = strnlen (reply.value, MAX_VALUE_LENGTH);
+      snprintf (reply.value + length, MAX_VALUE_LENGTH + 1 - length, "|%s", traceText);
+    }
+  }
+
+  // Any data to send?
+  if (pStatus == SUCCESS_DATA || pStatus == FAIL_DATA)
+  {
+    // Populate deviceID
+    memcpy (reply.deviceID, commandString, ID_SIZE);
+
+    SendDataPacket (reply);
+  }
+
+  currentTrace     = -1;
+  executingCommand = false;
+}
+
+//=========================================================
+//  SplitParams:
+//
+//  Point <command.tokens> at the '|' separated tokens of
+//  <command.params>, in place.  Empty tokens are kept so
+//  every param stays at its position.  If there are more
+//  than MAX_PARAM_TOKENS, the last one holds the rest of
+//  the params.
+//=========================================================
+
+void Node::SplitParams (CPacket &command)
+{
+  const char  *token = command.params;
+
+  command.numTokens = 0;
+  if (*token == 0)
+    return;
+
+  while (true)
+  {
+    ParamSpan  &span = command.tokens[command.numTokens++];
+    const char *end  = (command.numTokens < MAX_PARAM_TOKENS) ? strchr (token, '|') : NULL;
+
+    span.text   = token;
+    span.length = (end != NULL) ? end - token : strlen (token);
+
+    if (end == NULL)
+      break;
+
+    token = end + 1;
+  }
+}
+
+//=========================================================
+//  StartTrace:
+//
+//  Take the next CommandTrace slot for the command that
+//  was just dequeued, stamped with the time its string
+//  was pushed by onCommandReceived().
+//  A slot is reused after TRACE_LENGTH more traced
+//  commands, so its last transmit stamp is profiled
+//  first.
+//=========================================================
+
+int Node::StartTrace (uint32_t id, int64_t dequeuedAt)
+{
+  ProfileSentTraces ();
+
+  int           slot  = nextTrace;
+  CommandTrace  *trace = &traces[slot];
+  int64_t       received = CommandBuffer->PeekStamp ();
+
+  trace->serial.store (++traceSerial, std::memory_order_release);
+  trace->id           = id;
+  trace->receivedUs   = (received > 0 && received <= dequeuedAt) ? received : dequeuedAt;
+  trace->dequeuedUs   = (uint32_t)(dequeuedAt - trace->receivedUs);
+  trace->dispatchedUs = (uint32_t)(esp_timer_get_time () - trace->receivedUs);
+  trace->doneUs       = 0;
+  trace->profiled     = false;
+  trace->sentUs.store (0, std::memory_order_release);
+
+  nextTrace = (slot + 1) % TRACE_LENGTH;
+  if (numTraces < TRACE_LENGTH)
+    ++numTraces;
+
+  return slot;
+}
+
+//--- ProfileSentTraces -----------------------------------
+
+void Node::ProfileSentTraces ()
+{
+  // Run() task: the sender task only stamps <sentUs>, the Profiles are updated here
+  for (int i=0; i<numTraces; i++)
+  {
+    CommandTrace  *trace = &traces[i];
+    uint32_t      sent   = trace->sentUs.load (std::memory_order_acquire);
+
+    if (trace->profiled || sent == 0 || trace->doneUs == 0)
+      continue;
+
+    traceProfiles[TRACE_TRANSMIT].Record (sent > trace->doneUs ? sent - trace->doneUs : 0);
+    traceProfiles[TRACE_TOTAL   ].Record (sent);
+    trace->profiled = true;
+  }
+}
+
+//--- GetVersion ------------------------------------------
+
+const char * Node::GetVersion ()
+{
+  return version;
+}
+
+//=========================================================
+//  ExecuteCommand:
+//
+//  This method handles the built-in Node commands and
+//  sets a ProcessStatus.  Override this method in your
+//  child Node class to handle custom Node commands.
+//  Your method should first call this base class method,
+//  then handle custom commands.
+//  If the command is not handled by the Node, then pass
+//  it to the Device's ExecuteCommand() method.
+//=========================================================
+
+ProcessStatus Node::ExecuteCommand (CPacket &command, DPacket &reply)
+{
+  // Look up the built-in Node command (see <commandTable> in Node.h)
+  const CommandEntry<CommandHandler<Node>> *entry = FindCommand (commandTable, command.key);
+  if (entry == NULL)
+    return NOT_HANDLED;
+
+  // Default the timestamp to now
+  reply.timestamp = millis();
+
+  // Return the resulting ProcessStatus
+  return (this->*entry->handler) (command, reply);
+}
+
+//=========================================================
+//  Built-in Node Command Handlers
+//=========================================================
+
+//--- Set Node Name (SNNA) --------------------------------
+
+ProcessStatus Node::CmdSetNodeName (CPacket &command, DPacket &reply)
+{
+  // Set this Node's name
+  strncpy (name, command.params, MAX_NAME_LENGTH-1);
+  name[MAX_NAME_LENGTH-1] = 0;
+
+  // Acknowledge new name
+  strcpy (reply.value, "NONAME=");
+  strcat (reply.value, name);
+
+  return SUCCESS_DATA;
+}
+
+//--- Get Node Info (GNOI) --------------------------------
+
+ProcessStatus Node::CmdGetNodeInfo (CPacket &command, DPacket &reply)
+{
+  // Send Node info
+  sprintf (reply.value, "NOINFO=%s|%s|%s|%d", name, version, macAddressString, numDevices);
+
+  return SUCCESS_DATA;
+}
+
+//--- Get Device Info (GDEI) ------------------------------
+
+ProcessStatus Node::CmdGetDeviceInfo (CPacket &command, DPacket &reply)
+{
+  // For each Device, send a Device Data Packet with value = name|ipEnabled(Y/N)|ppEnabled(Y/N)|periodic data rate
+  for (int i=0; i<numDevices; i++)
+  {
+    memcpy (reply.deviceID, devices[i]->GetID (), ID_SIZE + 1);
+    reply.timestamp = millis ();
+    sprintf (reply.value, "DEINFO=%s|%s|%c|%c|%lu|", devices[i]->GetName(), devices[i]->GetVersion(), devices[i]->IsIPEnabled() ? 'Y':'N', devices[i]->IsPPEnabled() ? 'Y':'N', devices[i]->GetRate());
+    SendDataPacket (reply);
+  }
+
+  // All Device data has been sent, no need to send anything else
+  return SUCCESS_NODATA;
+}
+
+//--- Ping (PING) -----------------------------------------
+
+ProcessStatus Node::CmdPing (CPacket &command, DPacket &reply)
+{
+  // Got PINGed from Interface, Respond with PONG
+  strcpy (reply.value, "PONG");
+
+  return SUCCESS_DATA;
+}
+
+//--- Blink (BLIN) ----------------------------------------
+
+ProcessStatus Node::CmdBlink (CPacket &command, DPacket &reply)
+{
+  // Blink the Status LED
+  for (int i=0; i<10; i++)
+  {
+    STATUS_LED_BAD;
+    delay (80);
+
+    STATUS_LED_GOOD;
+    delay (20);
+  }
+
+  return SUCCESS_NODATA;
+}
+
+//--- Get Version (GNVR) ----------------------------------
+
+ProcessStatus Node::CmdGetVersion (CPacket &command, DPacket &reply)
+{
+  sprintf (reply.value, "NVER=%s", version);
+  return SUCCESS_DATA;
+}
+
+//--- Get Command Buffer Stats (GCBS) ---------------------
+
+ProcessStatus Node::CmdGetBufferStats (CPacket &command, DPacket &reply)
+{
+  // CBSTAT=depth|pushed|popped|overflow drops|oversize drops
+  sprintf (reply.value, "CBSTAT=%d|%lu|%lu|%lu|%lu", CommandBuffer->GetNumElements(),
+           (unsigned long) CommandBuffer->GetPushCount(),     (unsigned long) CommandBuffer->GetPopCount(),
+           (unsigned long) CommandBuffer->GetOverflowCount(), (unsigned long) CommandBuffer->GetOversizeCount());
+
+  return SUCCESS_DATA;
+}
+
+//--- Set Command Drain Policy (SCDP) ---------------------
+
+ProcessStatus Node::CmdSetDrainPolicy (CPacket &command, DPacket &reply)
+{
+  // SCDP|<max commands per pass>|<budget uSecs>  (0 = no limit, omitted = unchanged)
+  if (command.numTokens > 0)
+  {
+    maxCommandsPerRun = (int) strtol (command.tokens[0].text, NULL, 10);
+    if (maxCommandsPerRun < 0)
+      maxCommandsPerRun = 0;
+
+    if (command.numTokens > 1)
+      commandBudgetUs = strtoul (command.tokens[1].text, NULL, 10);
+  }
+
+  sprintf (reply.value, "CDRAIN=%d|%lu", maxCommandsPerRun, commandBudgetUs);
+  return SUCCESS_DATA;
+}
+
+//--- Get Command Drain Stats (GCDS) ----------------------
+
+ProcessStatus Node::CmdGetDrainStats (CPacket &command, DPacket &reply)
+{
+  // CDSTAT=max/pass|budget|passes|most run in one pass|depth high water (Run)|depth high water (receive)|limit stops|budget stops
+  sprintf (reply.value, "CDSTAT=%d|%lu|%lu|%d|%d|%lu|%lu|%lu", maxCommandsPerRun, commandBudgetUs,
+           drainPasses, drainMaxPerPass, drainDepthHighWater, (unsigned long) CommandBuffer->GetHighWater(),
+           drainLimitStops, drainBudgetStops);
+
+  // GCDS|R resets the statistics after reporting them
+  if (toupper (command.params[0]) == 'R')
+  {
+    drainPasses = drainLimitStops = drainBudgetStops = 0L;
+    drainMaxPerPass = drainDepthHighWater = 0;
+    CommandBuffer->ResetHighWater ();
+  }
+
+  return SUCCESS_DATA;
+}
+
+//--- Set Data Packet Format (SDPF) -----------------------
+
+ProcessStatus Node::CmdSetDataFormat (CPacket &command, DPacket &reply)
+{
+  // SDPF|A = ASCII Data Strings, SDPF|B = binary Data Frames, no params = report only.
+  // The acknowledgement is sent in the newly selected format.
+  FlushBatch ();
+  switch (toupper (command.params[0]))
+  {
+    case 'A' : dataFormat = ASCII_FORMAT;   break;
+    case 'B' : dataFormat = BINARY_FORMAT;  break;
+    case 0   : break;
+    default  :
+      strcpy (reply.value, "ERROR: Data format must be A or B");
+      return FAIL_DATA;
+  }
+
+  strcpy (reply.value, (dataFormat == BINARY_FORMAT) ? "DPFMT=B" : "DPFMT=A");
+  return SUCCESS_DATA;
+}
+
+//--- Set Batching (SBAT) ---------------------------------
+
+ProcessStatus Node::CmdSetBatching (CPacket &command, DPacket &reply)
+{
+  // SBAT|<deadline uSecs>  (0 = off, send every record in its own frame; omitted = unchanged)
+  if (command.params[0] != 0)
+  {
+    FlushBatch ();
+    batchDeadlineUs = strtoul (command.params, NULL, 10);
+  }
+
+  sprintf (reply.value, "BATCH=%lu", batchDeadlineUs);
+  return SUCCESS_DATA;
+}
+
+//--- Get Batch Stats (GBST) ------------------------------
+
+ProcessStatus Node::CmdGetBatchStats (CPacket &command, DPacket &reply)
+{
+  // BSTAT=frames|records|size flushes|deadline flushes|frames with 1|2|...|BATCH_HISTOGRAM_SIZE or more records
+  int length = sprintf (reply.value, "BSTAT=%lu|%lu|%lu|%lu", framesSent, recordsSent, sizeFlushes, deadlineFlushes);
+  for (int i=0; i<BATCH_HISTOGRAM_SIZE; i++)
+    length += sprintf (reply.value + length, "|%lu", recordsPerFrame[i]);
+
+  // GBST|R resets the statistics after reporting them
+  if (toupper (command.params[0]) == 'R')
+  {
+    framesSent = recordsSent = sizeFlushes = deadlineFlushes = 0L;
+    memset (recordsPerFrame, 0, sizeof(recordsPerFrame));
+  }
+
+  return SUCCESS_DATA;
+}
+
+//--- Set Idle Wait (SIDL) --------------------------------
+
+ProcessStatus Node::CmdSetIdleWait (CPacket &command, DPacket &reply)
+{
+  // SIDL|<max sleep mSecs>  (0 = never sleep, omitted = unchanged)
+  if (command.params[0] != 0)
+    maxIdleWaitMs = strtoul (command.params, NULL, 10);
+
+  sprintf (reply.value, "IDLE=%lu", maxIdleWaitMs);
+  return SUCCESS_DATA;
+}
+
+//--- Get Scheduler Stats (GSCH) --------------------------
+
+ProcessStatus Node::CmdGetSchedulerStats (CPacket &command, DPacket &reply)
+{
+  // SCHED=scheduled devices|runs|avg late uSecs|max late uSecs|overruns|idle waits|command wakes|idle mSecs
+  sprintf (reply.value, "SCHED=%d|%lu|%ld|%ld|%lu|%lu|%lu|%lu", scheduler.GetNumScheduled(), scheduler.runs,
+           (long) (scheduler.runs > 0 ? scheduler.totalLate / (int64_t) scheduler.runs : 0), (long) scheduler.maxLate,
+           scheduler.overruns, idleWaits, notifyWakes, (unsigned long) (idleUs / 1000));
+
+  // GSCH|R resets the statistics after reporting them
+  if (toupper (command.params[0]) == 'R')
+  {
+    scheduler.ResetStats ();
+    idleWaits = notifyWakes = 0L;
+    idleUs = 0;
+  }
+
+  return SUCCESS_DATA;
+}
+
+//--- Get Task Stats (GTSK) -------------------------------
+
+ProcessStatus Node::CmdGetTaskStats (CPacket &command, DPacket &reply)
+{
+  // For each Device on its own task, send a Device Data Packet with value = DTASK=...
+  for (int i=0; i<numDevices; i++)
+  {
+    if (devices[i]->IsOnTask ())
+    {
+      sprintf (reply.deviceID, "%02d", i);
+      reply.timestamp = millis ();
+      devices[i]->GetTaskStats (reply.value);
+      SendDataPacket (reply);
+    }
+  }
+
+  // All task data has been sent, no need to send anything else
+  return SUCCESS_NODATA;
+}
+
+//--- Get Transmit Stats (GTXS) ---------------------------
+
+ProcessStatus Node::CmdGetTxStats (CPacket &command, DPacket &reply)
+{
+  // TXSTAT=queued|delivered|failed|send errors|queue full drops|callback timeouts|in flight high water|
+  //        queue high water|backpressure skips
+  sprintf (reply.value, "TXSTAT=%lu|%lu|%lu|%lu|%lu|%lu|%d|%d|%lu", txQueued,
+           (unsigned long) TxDelivered.load (), (unsigned long) TxFailed.load (), txSendErrors, txQueueFull,
+           txTimeouts, txInFlightHighWater, txQueueHighWater, (unsigned long) TxBackpressureSkips.load ());
+
+  // GTXS|R resets the statistics after reporting them
+  if (toupper (command.params[0]) == 'R')
+  {
+    txQueued = txSendErrors = txQueueFull = txTimeouts = 0L;
+    txInFlightHighWater = txQueueHighWater = 0;
+    TxDelivered = TxFailed = TxBackpressureSkips = 0;
+  }
+
+  return SUCCESS_DATA;
+}
+
+//--- Set Transport (SXPT) --------------------------------
+
+ProcessStatus Node::CmdSetTransport (CPacket &command, DPacket &reply)
+{
+  // SXPT|E = ESP-NOW, SXPT|S = serial link, SXPT|R resets the serial link counts, no params = report only.
+  // The acknowledgement is sent on the newly selected transport.
+  char  select = toupper (command.params[0]);
+
+  if (select == 'S' && serialLink == NULL)
+  {
+    strcpy (reply.value, "ERROR: No serial link");
+    return FAIL_DATA;
+  }
+
+  FlushBatch ();
+  switch (select)
+  {
+    case 'E' : ActiveTransport = TRANSPORT_ESPNOW;  break;
+    case 'S' : ActiveTransport = TRANSPORT_SERIAL;  break;
+    case 'R' : if (serialLink != NULL) serialLink->ResetStats ();  break;
+    case 0   : break;
+    default  :
+      strcpy (reply.value, "ERROR: Transport must be E or S");
+      return FAIL_DATA;
+  }
+
+  // XPORT=E or S|frames in|frames out|bad frames|write errors
+  sprintf (reply.value, "XPORT=%c|%lu|%lu|%lu|%lu", (ActiveTransport == TRANSPORT_SERIAL) ? 'S' : 'E',
+           serialLink ? serialLink->framesIn    : 0L, serialLink ? serialLink->framesOut   : 0L,
+           serialLink ? serialLink->badFrames   : 0L, serialLink ? serialLink->writeErrors : 0L);
+
+  return SUCCESS_DATA;
+}
+
+//--- Set Rate Limits (SLIM) ------------------------------
+
+ProcessStatus Node::CmdSetRateLimits (CPacket &command, DPacket &reply)
+{
+  // SLIM|<airtime bytes per second>|<records per second>  (0 = no limit, omitted = unchanged)
+  if (command.numTokens > 0)
+  {
+    limitBytesPerSec = strtoul (command.tokens[0].text, NULL, 10);
+    ByteBucket.SetRate (limitBytesPerSec);
+  }
+
+  if (command.numTokens > 1)
+  {
+    limitRecordsPerSec = strtoul (command.tokens[1].text, NULL, 10);
+    RecordBucket.SetRate (limitRecordsPerSec);
+  }
+
+  sprintf (reply.value, "RLIM=%lu|%lu", limitBytesPerSec, limitRecordsPerSec);
+  return SUCCESS_DATA;
+}
+
+//--- Get Rate Limit Stats (GLIM) -------------------------
+
+ProcessStatus Node::CmdGetLimitStats (CPacket &command, DPacket &reply)
+{
+  // LSTAT=byteTokens|recordTokens|sentR|sentS|sentT|droppedR|droppedS|droppedT|skipped
+  sprintf (reply.value, "LSTAT=%.0f|%.1f|%lu|%lu|%lu|%lu|%lu|%lu|%lu", ByteBucket.tokens, RecordBucket.tokens,
+           limitSent[TRAFFIC_RESPONSE], limitSent[TRAFFIC_STATUS], limitSent[TRAFFIC_TELEMETRY],
+           limitDrops[TRAFFIC_RESPONSE], limitDrops[TRAFFIC_STATUS], limitDrops[TRAFFIC_TELEMETRY],
+           (unsigned long) LimitSkips.load ());
+
+  // GLIM|R resets the statistics after reporting them
+  if (toupper (command.params[0]) == 'R')
+  {
+    for (int i=0; i<NUM_TRAFFIC_CLASSES; i++)
+      limitSent[i] = limitDrops[i] = 0L;
+
+    LimitSkips = 0;
+  }
+
+  return SUCCESS_DATA;
+}
+
+//--- Get Profiles (GPRF) ---------------------------------
+
+ProcessStatus Node::CmdGetProfiles (CPacket &command, DPacket &reply)
+{
+  SendProfiles (command.deviceIndex);
+
+  // GPRF|R resets the profiles after reporting them
+  if (toupper (command.params[0]) == 'R')
+  {
+    for (int i=0; i<numDevices; i++)
+      devices[i]->ResetProfiles ();
+
+    loopProfile.Reset ();
+    busyProfile.Reset ();
+    lastRunStartUs = 0;
+  }
+
+  // All profiles have been sent, no need to send anything else
+  return SUCCESS_NODATA;
+}
+
+//--- Set Profile Reporting (SPRF) ------------------------
+
+ProcessStatus Node::CmdSetProfileReport (CPacket &command, DPacket &reply)
+{
+  // SPRF|seconds sends the GPRF reports every <seconds> (0 = off)
+  if (command.params[0] != 0)
+  {
+    profileReportSecs   = strtoul (command.params, NULL, 10);
+    nextProfileReportUs = esp_timer_get_time () + (int64_t) profileReportSecs * 1000000;
+  }
+
+  sprintf (reply.value, "PROFRPT=%lu", profileReportSecs);
+
+  return SUCCESS_DATA;
+}
+
+//--- Subscribe (SSUB) ------------------------------------
+
+ProcessStatus Node::CmdSubscribe (CPacket &command, DPacket &reply)
+{
+  // SSUB|dd|field|rateHz subscribes (rateHz 0 unsubscribes),
+  // SSUB|dd unsubscribes all fields of Device dd, SSUB alone unsubscribes everything
+  int     index = (command.numTokens > 0) ? (int) strtol (command.tokens[0].text, NULL, 10) : -1;
+  int     field = (command.numTokens > 1) ? (int) strtol (command.tokens[1].text, NULL, 10) : -1;
+  double  rate  = (command.numTokens > 2) ? strtod (command.tokens[2].text, NULL) : 0.0;
+
+  if (command.numTokens > 0 && (index < 0 || index >= numDevices))
+  {
+    sprintf (reply.value, "ERR|SSUB|Unknown device %d", index);
+    return FAIL_DATA;
+  }
+
+  if (command.numTokens > 1 && field < 0)
+  {
+    sprintf (reply.value, "ERR|SSUB|Device %d has no field %d", index, field);
+    return FAIL_DATA;
+  }
+
+  // Check the new subscription before touching the old ones, so a bad SSUB changes nothing
+  bool  subscribe = (command.numTokens > 1 && rate > 0.0);
+  if (subscribe)
+  {
+    DPacket  sample;
+
+    sample.numFields = 0;
+    if (field >= MAX_DATA_FIELDS || !devices[index]->RunSample (field, sample))
+    {
+      sprintf (reply.value, "ERR|SSUB|Device %d has no field %d", index, field);
+      return FAIL_DATA;
+    }
+  }
+
+  // Keep the subscriptions this command doesn't replace, in order
+  Subscription  kept[MAX_SUBSCRIPTIONS];
+  int           numKept = 0;
+  for (int i=0; i<numSubscriptions; i++)
+  {
+    Subscription  *sub = &subscriptions[i];
+
+    if (command.numTokens == 0 || (sub->deviceIndex == index && (command.numTokens == 1 || sub->field == field)))
+      continue;
+
+    kept[numKept++] = *sub;
+  }
+
+  if (subscribe && numKept >= MAX_SUBSCRIPTIONS)
+  {
+    sprintf (reply.value, "ERR|SSUB|No free subscription (%d)", MAX_SUBSCRIPTIONS);
+    return FAIL_DATA;
+  }
+
+  memcpy (subscriptions, kept, numKept * sizeof (Subscription));
+  numSubscriptions = numKept;
+
+  if (subscribe)
+  {
+    if (rate > MAX_PERIODIC_RATE_HZ)
+      rate = MAX_PERIODIC_RATE_HZ;
+
+    // Insert in Device then field order, so each Device's samples share a record
+    int slot = numSubscriptions++;
+    while (slot > 0 && (subscriptions[slot-1].deviceIndex > index ||
+                        (subscriptions[slot-1].deviceIndex == index && subscriptions[slot-1].field > field)))
+    {
+      subscriptions[slot] = subscriptions[slot-1];
+      --slot;
+    }
+
+    subscriptions[slot].deviceIndex = index;
+    subscriptions[slot].field       = field;
+    subscriptions[slot].periodUs    = (int64_t)(1000000.0 / rate + 0.5);
+    subscriptions[slot].nextUs      = esp_timer_get_time ();
+  }
+
+  nextSubscriptionUs = INT64_MAX;
+  for (int i=0; i<numSubscriptions; i++)
+    if (subscriptions[i].nextUs < nextSubscriptionUs)
+      nextSubscriptionUs = subscriptions[i].nextUs;
+
+  sprintf (reply.value, "SUBS=%d|%lu|%lu", numSubscriptions, subscriptionRecords, subscriptionSamples);
+  return SUCCESS_DATA;
+}
+
+//--- Get Subscriptions (GSUB) ----------------------------
+
+ProcessStatus Node::CmdGetSubscriptions (CPacket &command, DPacket &reply)
+{
+  // One SUB report per subscription
+  for (int i=0; i<numSubscriptions; i++)
+  {
+    sprintf (reply.value, "SUB=%02d|%d|%.4f", subscriptions[i].deviceIndex, subscriptions[i].field,
+             1000000.0 / subscriptions[i].periodUs);
+
+    sprintf (reply.deviceID, "%02d", command.deviceIndex);
+    reply.timestamp = millis ();
+    SendDataPacket (reply);
+  }
+
+  sprintf (reply.value, "SUBS=%d|%lu|%lu", numSubscriptions, subscriptionRecords, subscriptionSamples);
+
+  // GSUB|R clears the statistics after reporting them
+  if (toupper (command.params[0]) == 'R')
+  {
+    subscriptionRecords = 0L;
+    subscriptionSamples = 0L;
+  }
+
+  return SUCCESS_DATA;
+}
+
+//--- Get Command Traces (GTRC) ---------------------------
+
+ProcessStatus Node::CmdGetTraces (CPacket &command, DPacket &reply)
+{
+  static const char  stageNames[NUM_TRACE_STAGES] = { 'Q', 'P', 'H', 'T', 'E' };
+
+  ProfileSentTraces ();
+
+  // One TRACE report per kept trace, oldest first (not this GTRC's own)
+  for (int i=0; i<numTraces; i++)
+  {
+    int           slot  = (nextTrace - numTraces + i + TRACE_LENGTH) % TRACE_LENGTH;
+    CommandTrace  *trace = &traces[slot];
+    uint32_t      sent   = trace->sentUs.load (std::memory_order_acquire);
+
+    if (slot == currentTrace)
+      continue;
+
+    int length = sprintf (reply.value, "TRACE=%lu|%lu|%lu|%lu|", (unsigned long) trace->id, (unsigned long) trace->dequeuedUs,
+                          (unsigned long)(trace->dispatchedUs - trace->dequeuedUs), (unsigned long)(trace->doneUs - trace->dispatchedUs));
+    if (sent == 0)
+      strcpy (reply.value + length, "-|-");
+    else
+      sprintf (reply.value + length, "%lu|%lu", (unsigned long)(sent > trace->doneUs ? sent - trace->doneUs : 0), (unsigned long) sent);
+
+    sprintf (reply.deviceID, "%02d", command.deviceIndex);
+    reply.timestamp = millis ();
+    SendDataPacket (reply);
+  }
+
+  // Then the profile of each stage
+  for (int stage=0; stage<NUM_TRACE_STAGES; stage++)
+  {
+    traceProfiles[stage].Format (reply.value + sprintf (reply.value, "TRSTG=%c|", stageNames[stage]));
+
+    sprintf (reply.deviceID, "%02d", command.deviceIndex);
+    reply.timestamp = millis ();
+    SendDataPacket (reply);
+  }
+
+  // GTRC|R clears the traces and the stage profiles after reporting them
+  if (toupper (command.params[0]) == 'R')
+  {
+    numTraces = 0;
+    nextTrace = 0;
+
+    for (int stage=0; stage<NUM_TRACE_STAGES; stage++)
+      traceProfiles[stage].Reset ();
+  }
+
+  // All traces have been sent, no need to send anything else
+  return SUCCESS_NODATA;
+}
+
+//--- Reset (RSET) ----------------------------------------
+
+ProcessStatus Node::CmdReset (CPacket &command, DPacket &reply)
+{
+  // Acknowledge Reset
+  Serial.println ("Resetting Node ... ");
+
+  // Reset this Node
+  esp_restart();
+  // x x
+  //  o
+
+  return SUCCESS_NODATA;
+}
+
+
+
+//=========================================================
+// External ESP-NOW "C" Functions
+//=========================================================
+
+//--- onDataPacketSent ------------------------------------
+
+#ifdef ESPNOW_SEND_TX_INFO
+void onDataPacketSent (const wifi_tx_info_t *info, esp_now_send_status_t status)
+#else
+void onDataPacketSent (const uint8_t *mac_addr, esp_now_send_status_t status)
+#endif
+{
+  // This runs in the WiFi task when ESP-NOW is done with a frame:
+  // count the outcome and let the sender task hand over another frame
+  if (status == ESP_NOW_SEND_SUCCESS)
+    TxDelivered.fetch_add (1, std::memory_order_relaxed);
+  else
+    TxFailed.fetch_add (1, std::memory_order_relaxed);
+
+  if (TxSlots != NULL)
+    xSemaphoreGive (TxSlots);
+}
+
+//--- onCommandReceived -----------------------------------
+
+// void onCommandReceived (const uint8_t *relayerMAC, const uint8_t *commandString, int commandLength)  // ESP-NOW v1
+void onCommandReceived (const esp_now_recv_info_t *info, const uint8_t *commandString, int commandLength)  // ESP-NOW v2
+{
+  // This runs in the WiFi task
+  Node::CommandReceived (commandString, commandLength, TRANSPORT_ESPNOW);
+}
+
+
+//=========================================================
+// Command Receiving (any transport)
+//=========================================================
+
+//--- CommandReceived -------------------------------------
+
+void Node::CommandReceived (const uint8_t *commandString, int commandLength, Transport source)
+{
+  // This runs in the WiFi task or the serial link's reader task.
+  // The message is not guaranteed to be NULL terminated, so always honor <commandLength>.
+  if (Debugging)
+  {
+    // Show the incoming Command string
+    Serial.printf ("Node <-- %s : %.*s\n", (source == TRANSPORT_SERIAL) ? "Serial" : "Relayer", commandLength, (const char *) commandString);
+  }
+
+  // Check if Relayer responded to initial Node PING
+  if (commandLength >= 4 && strncmp ((const char *) commandString, "PONG", 4) == 0)
+    WaitingForRelayer = false;
+  else
+  {
+    // Copy this message into the next free command slot (no heap use).
+    // <CommandBuffer> takes one producer, so the two receive paths take turns.
+    portENTER_CRITICAL (&CommandPushLock);
+    bool pushed = CommandBuffer->PushString ((const char *) commandString, commandLength, esp_timer_get_time ());
+    portEXIT_CRITICAL (&CommandPushLock);
+
+    if (!pushed)
+    {
+      if (Debugging)
+        Serial.println ("ERROR: Command dropped (buffer full or message too long)");
+    }
+    else
+      Node::Wake ();  // Wake Node::Run() if it is sleeping
+  }
 }
@@ -0,0 +1,71 @@
+//=========================================================
+//
+//     FILE : Profile.cpp
+//
+//  PROJECT : SMAC Framework
+//              │
+//              └── Firmware
+//                    │
+//                    └── Node
+//
+//    NOTES : Hot-path timing statistics.
+//            See Profile.h for the rules.
+//
+//   AUTHOR : Bill Daniels
+//            Copyright 2021-2025, D+S Tech Labs, Inc.
+//            All Rights Reserved
+//
+//=========================================================
+
+//--- Includes --------------------------------------------
+
+#include <Arduino.h>
+#include "Profile.h"
+
+//--- Record ----------------------------------------------
+
+IRAM_ATTR void Profile::Record (int64_t us)
+{
+  uint32_t  duration = (us < 0) ? 0 : (us > UINT32_MAX) ? UINT32_MAX : (uint32_t) us;
+
+  ++count;
+  totalUs += duration;
+  if (duration < minUs)
+    minUs = duration;
+  if (duration > maxUs)
+    maxUs = duration;
+
+  // Bucket = index of the highest set bit, so one count-leading-zeros instruction
+  int bucket = (duration < 2) ? 0 : 31 - __builtin_clz (duration);
+  if (bucket >= PROFILE_HISTOGRAM_SIZE)
+    bucket = PROFILE_HISTOGRAM_SIZE - 1;
+
+  ++histogram[bucket];
+}
+
+//--- Reset -----------------------------------------------
+
+void Profile::Reset ()
+{
+  count   = 0L;
+  minUs   = UINT32_MAX;
+  maxUs   = 0;
+  totalUs = 0;
+
+  for (int i=0; i<PROFILE_HISTOGRAM_SIZE; i++)
+    histogram[i] = 0L;
+}
+
+//--- Format ----------------------------------------------
+
+int Profile::Format (char *text)
+{
+  // count|minUs|avgUs|maxUs|h0|h1|...|h15
+  int length = sprintf (text, "%lu|%lu|%lu|%lu", count, (count > 0) ? (unsigned long) minUs : 0L,
+                        (count > 0) ? (unsigned long) (totalUs / count) : 0L, (unsigned long) maxUs);
+
+  for (int i=0; i<PROFILE_HISTOGRAM_SIZE; i++)
+    length += sprintf (text + length, "|%lu", histogram[i]);
+
+  return length;
+}
@@ -4,7 +4,9 @@
 //
 //  PROJECT : Any
 //
-//    NOTES : Implements a LIFO or Circular FIFO Stack.
+//    NOTES : Implements a lock-free, allocation-free
+//            single-producer/single-consumer Circular FIFO.
+//            See RingBuffer.h for the rules.
 //
 //   AUTHOR : Bill Daniels
 //            Copyright 1992-2025, D+S Tech Labs, Inc.
@@ -20,79 +22,114 @@
 
 //--- Constructor -----------------------------------------
 
-RingBuffer::RingBuffer (BufferType inBufferType)
+RingBuffer::RingBuffer ()
 {
-  bufferType  = inBufferType;
-  numElements = headIndex = tailIndex = 0;
-}
-
-//--- Destructor ------------------------------------------
-
-RingBuffer::~RingBuffer ()
-{
-  // Free all elements
-  for (int i=numElements-1; i>=0; i--)
-    free (elements[i]);
+  headIndex     = 0;
+  tailIndex     = 0;
+  pushCount     = 0;
+  overflowCount = 0;
+  oversizeCount = 0;
+  popCount      = 0;
+  highWater     = 0;
 }
 
 //--- GetNumElements --------------------------------------
 
 int RingBuffer::GetNumElements ()
 {
-  return numElements;
+  // Indexes are free-running, so unsigned subtraction is wrap-safe
+  return (int)(tailIndex.load (std::memory_order_acquire) - headIndex.load (std::memory_order_acquire));
 }
 
 //--- PushString ------------------------------------------
 
-void RingBuffer::PushString (const char *element)
+IRAM_ATTR bool RingBuffer::PushString (const char *element, int length, int64_t stamp)
 {
-  // Push a new string into the ring
-  if (numElements < MAX_ELEMENTS)
+  // Called by the producer only.
+  // <length> need not include a NULL terminator; the copy stops at the first NULL or <length>.
+  int elementLength = strnlen (element, length);
+
+  if (elementLength > ELEMENT_SIZE - 1)
+  {
+    oversizeCount.fetch_add (1, std::memory_order_relaxed);
+    return false;
+  }
+
+  uint32_t tail = tailIndex.load (std::memory_order_relaxed);
+  if (tail - headIndex.load (std::memory_order_acquire) >= MAX_ELEMENTS)
   {
-    // Allocate space and copy data
-    int  elementSize = strlen (element) + 1;  // include NULL terminator
-    char *newElement = (char *) malloc (elementSize);
-    memcpy (newElement, element, elementSize);
-
-    if (bufferType == FIFO)
-    {
-      // FIFO
-      elements[tailIndex] = newElement;
-      tailIndex = (tailIndex + 1) % MAX_ELEMENTS;
-    }
-    else
-    {
-      // LIFO
-      elements[numElements] = newElement;
-    }
-
-    ++numElements;
+    overflowCount.fetch_add (1, std::memory_order_relaxed);
+    return false;
   }
+
+  // Copy into the preallocated slot, then publish it
+  char *slot = elements[tail & (MAX_ELEMENTS - 1)];
+  memcpy (slot, element, elementLength);
+  slot[elementLength] = 0;
+  stamps[tail & (MAX_ELEMENTS - 1)] = stamp;
+
+  tailIndex.store (tail + 1, std::memory_order_release);
+  pushCount.fetch_add (1, std::memory_order_relaxed);
+
+  // Track the deepest the buffer has been
+  uint32_t depth = tail + 1 - headIndex.load (std::memory_order_relaxed);
+  if (depth > highWater.load (std::memory_order_relaxed))
+    highWater.store (depth, std::memory_order_relaxed);
+
+  return true;
 }
 
-//--- PopString -------------------------------------------
+//--- PeekString ------------------------------------------
 
-char *RingBuffer::PopString ()
+const char *RingBuffer::PeekString ()
 {
-  char *element = NULL;
+  // Called by the consumer only.
+  // Returns the oldest string, in place, or NULL if the buffer is empty.
+  uint32_t head = headIndex.load (std::memory_order_relaxed);
+  if (head == tailIndex.load (std::memory_order_acquire))
+    return NULL;
 
-  // Pop a string out of the Ring
-  if (numElements > 0)
-  {
-    if (bufferType == FIFO)
-    {
-      // FIFO
-      element = elements[headIndex];
-      headIndex = (headIndex + 1) % MAX_ELEMENTS;
-    }
-    else
-    {
-      // LIFO
-      element = elements[numElements-1];
-    }
-
-    --numElements;
-  }
+  return elements[head & (MAX_ELEMENTS - 1)];
+}
 
-  return element;  // User must free this memory when done !!!  free (element);
+//--- PeekStamp -------------------------------------------
+
+int64_t RingBuffer::PeekStamp ()
+{
+  // Called by the consumer only: the stamp pushed with the oldest string (0 if empty)
+  uint32_t head = headIndex.load (std::memory_order_relaxed);
+  if (head == tailIndex.load (std::memory_order_acquire))
+    return 0;
+
+  return stamps[head & (MAX_ELEMENTS - 1)];
+}
+
+//--- ReleaseString ---------------------------------------
+
+void RingBuffer::ReleaseString ()
+{
+  // Called by the consumer only, when done with the string from PeekString()
+  uint32_t head = headIndex.load (std::memory_order_relaxed);
+  if (head == tailIndex.load (std::memory_order_acquire))
+    return;
+
+  headIndex.store (head + 1, std::memory_order_release);
+  popCount.fetch_add (1, std::memory_order_relaxed);
+}
+
+//--- Statistics ------------------------------------------
+
+uint32_t RingBuffer::GetPushCount     () { return pushCount.load     (std::memory_order_relaxed); }
+uint32_t RingBuffer::GetPopCount      () { return popCount.load      (std::memory_order_relaxed); }
+uint32_t RingBuffer::GetOverflowCount () { return overflowCount.load (std::memory_order_relaxed); }
+uint32_t RingBuffer::GetOversizeCount () { return oversizeCount.load (std::memory_order_relaxed); }
+uint32_t RingBuffer::GetHighWater     () { return highWater.load     (std::memory_order_relaxed); }
+
+//--- ResetHighWater --------------------------------------
+
+void RingBuffer::ResetHighWater ()
+{
+  // Called by the consumer.  A push racing with this may restore
+  // a slightly stale value, which is harmless for a statistic.
+  highWater.store (0, std::memory_order_relaxed);
 }
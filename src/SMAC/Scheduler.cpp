@@ -0,0 +1,195 @@
+//=========================================================
+//
+//     FILE : Scheduler.cpp
+//
+//  PROJECT : SMAC Framework
+//              │
+//              └── Firmware
+//                    │
+//                    └── Node
+//
+//    NOTES : Periodic Device scheduler (min-heap of deadlines).
+//            See Scheduler.h for the rules.
+//
+//   AUTHOR : Bill Daniels
+//            Copyright 2021-2025, D+S Tech Labs, Inc.
+//            All Rights Reserved
+//
+//=========================================================
+
+//--- Includes --------------------------------------------
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "Scheduler.h"
+#include "Device.h"
+
+//--- Place -----------------------------------------------
+
+void Scheduler::Place (Device *device, int index)
+{
+  heap[index] = device;
+  device->heapIndex = index;
+}
+
+//--- SiftUp ----------------------------------------------
+
+void Scheduler::SiftUp (int index)
+{
+  Device *device = heap[index];
+
+  while (index > 0)
+  {
+    int parent = (index - 1) / 2;
+    if (heap[parent]->nextPeriodicTime <= device->nextPeriodicTime)
+      break;
+
+    Place (heap[parent], index);
+    index = parent;
+  }
+
+  Place (device, index);
+}
+
+//--- SiftDown --------------------------------------------
+
+void Scheduler::SiftDown (int index)
+{
+  Device *device = heap[index];
+
+  while (true)
+  {
+    int child = 2*index + 1;
+    if (child >= heapSize)
+      break;
+
+    // Pick the earlier of the two children
+    if (child + 1 < heapSize && heap[child+1]->nextPeriodicTime < heap[child]->nextPeriodicTime)
+      ++child;
+
+    if (device->nextPeriodicTime <= heap[child]->nextPeriodicTime)
+      break;
+
+    Place (heap[child], index);
+    index = child;
+  }
+
+  Place (device, index);
+}
+
+//--- Add -------------------------------------------------
+
+void Scheduler::Add (Device *device)
+{
+  // (Re)schedule <device> to run right away
+  device->nextPeriodicTime = esp_timer_get_time ();
+
+  if (device->heapIndex < 0)
+  {
+    if (heapSize >= MAX_DEVICES)
+      return;
+
+    Place (device, heapSize++);
+  }
+
+  // The new deadline can only be earlier than or equal to the old one
+  SiftUp (device->heapIndex);
+}
+
+//--- Remove ----------------------------------------------
+
+void Scheduler::Remove (Device *device)
+{
+  int index = device->heapIndex;
+  if (index < 0)
+    return;
+
+  device->heapIndex = -1;
+
+  // Fill the hole with the last Device and restore the heap
+  if (--heapSize > index)
+  {
+    Device *moved = heap[heapSize];
+
+    Place  (moved, index);
+    SiftUp (index);
+    if (moved->heapIndex == index)
+      SiftDown (index);
+  }
+}
+
+//--- NextDue ---------------------------------------------
+
+Device * Scheduler::NextDue (int64_t now)
+{
+  while (heapSize > 0)
+  {
+    Device *device = heap[0];
+
+    // Drop Devices that turned off Periodic Processing on their own
+    if (!device->periodicEnabled)
+    {
+      Remove (device);
+      continue;
+    }
+
+    return (device->nextPeriodicTime <= now) ? device : NULL;
+  }
+
+  return NULL;
+}
+
+//--- Advance ---------------------------------------------
+
+void Scheduler::Advance (Device *device, int64_t now)
+{
+  int64_t  period = device->processPeriodUs;
+  int64_t  late   = now - device->nextPeriodicTime;
+
+  // The deadline of the call about to be made (see Device::ScheduledTimeUs())
+  device->periodicDeadline = device->nextPeriodicTime;
+
+  // Statistics
+  ++runs;
+  totalLate += late;
+  if (late > maxLate)
+    maxLate = late;
+
+  // Next deadline is one period after the last one (drift-free)
+  device->nextPeriodicTime += period;
+
+  // A full period or more behind?
+  if (device->nextPeriodicTime <= now)
+  {
+    ++overruns;
+
+    // Skip to the next deadline on the grid, unless catching up (and not too far behind)
+    if (device->schedulePolicy != SCHEDULE_CATCH_UP || now - device->nextPeriodicTime >= MAX_CATCH_UP_PERIODS * period)
+      device->nextPeriodicTime += ((now - device->nextPeriodicTime) / period + 1) * period;
+  }
+
+  if (device->heapIndex >= 0)
+    SiftDown (device->heapIndex);
+}
+
+//--- NextDeadline ----------------------------------------
+
+int64_t Scheduler::NextDeadline ()
+{
+  return (heapSize > 0) ? heap[0]->nextPeriodicTime : INT64_MAX;
+}
+
+//--- GetNumScheduled -------------------------------------
+
+int Scheduler::GetNumScheduled ()
+{
+  return heapSize;
+}
+
+//--- ResetStats ------------------------------------------
+
+void Scheduler::ResetStats ()
+{
+  runs = overruns = 0L;
+  totalLate = maxLate = 0;
+}
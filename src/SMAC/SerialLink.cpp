@@ -0,0 +1,268 @@
+//=========================================================
+//
+//     FILE : SerialLink.cpp
+//
+//  PROJECT : SMAC Framework
+//              │
+//              └── Firmware
+//                    │
+//                    └── Node
+//
+//    NOTES : Framed SMAC transport over the Serial port.
+//            See SerialLink.h for the frame format.
+//
+//   AUTHOR : Bill Daniels
+//            Copyright 2021-2025, D+S Tech Labs, Inc.
+//            All Rights Reserved
+//
+//=========================================================
+
+//--- Includes --------------------------------------------
+
+#include <Arduino.h>
+#include "SerialLink.h"
+#include "Node.h"
+
+//--- Declarations ----------------------------------------
+
+// CRC-16/CCITT-FALSE, one nibble at a time (a 32-byte table instead of 512)
+static const uint16_t  CrcNibbles[16] =
+{
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+//--- Start -----------------------------------------------
+
+bool SerialLink::Start (TextHandler handler)
+{
+  textHandler = handler;
+
+  if (readerTask == NULL &&
+      xTaskCreatePinnedToCore (ReaderMain, "SerialLink", SERIAL_LINK_TASK_STACK, this, SERIAL_LINK_TASK_PRIORITY, &readerTask, SERIAL_LINK_TASK_CORE) != pdPASS)
+  {
+    Serial.println ("ERROR: Unable to start the serial link task");
+    readerTask = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+//--- ReaderMain ------------------------------------------
+
+void SerialLink::ReaderMain (void *arg)
+{
+  // Body of the reader task: take whatever is waiting in one read
+  SerialLink  *link = (SerialLink *) arg;
+  uint8_t     bytes[SERIAL_LINK_READ_SIZE];
+
+  while (true)
+  {
+    int waiting = Serial.available ();
+    if (waiting <= 0)
+    {
+      vTaskDelay (pdMS_TO_TICKS (SERIAL_LINK_POLL_MS));
+      continue;
+    }
+
+    int count = Serial.read (bytes, (waiting < SERIAL_LINK_READ_SIZE) ? waiting : SERIAL_LINK_READ_SIZE);
+    if (count > 0)
+      link->Receive (bytes, count);
+  }
+}
+
+//--- Receive ---------------------------------------------
+
+void SerialLink::Receive (const uint8_t *bytes, int count)
+{
+  for (int i=0; i<count; i++)
+  {
+    uint8_t  b = bytes[i];
+
+    if (!inFrame)
+    {
+      // Console text until a 0x00 opens a frame
+      if (b == 0)
+      {
+        inFrame    = true;
+        rxLength   = 0;
+        rxOverflow = false;
+      }
+      else
+        ReceiveText ((char) b);
+    }
+    else if (b != 0)
+    {
+      if (rxLength < SERIAL_FRAME_MAX_ENCODED)
+        rxFrame[rxLength++] = b;
+      else
+        rxOverflow = true;
+    }
+    else if (rxLength > 0 || rxOverflow)
+    {
+      // The closing 0x00 (an empty frame is just back to back delimiters)
+      if (rxOverflow)
+        ++badFrames;
+      else
+        ReceiveFrame ();
+
+      inFrame = false;
+    }
+  }
+}
+
+//--- ReceiveText -----------------------------------------
+
+void SerialLink::ReceiveText (char c)
+{
+  if (c == '\r')  // ignore CR's
+    return;
+
+  if (c == '\n')
+  {
+    // Line is ready, terminate and hand it over
+    textLine[textLength] = 0;
+    textLength = 0;
+
+    if (textHandler != NULL)
+      textHandler (textLine);
+  }
+  else if (textLength < SERIAL_MAX_LENGTH - 1)
+    textLine[textLength++] = c;
+  else
+  {
+    Serial.println ("ERROR: Serial message is too long.");
+
+    // Ignore and start new line
+    textLength = 0;
+  }
+}
+
+//--- ReceiveFrame ----------------------------------------
+
+void SerialLink::ReceiveFrame ()
+{
+  uint8_t  frame[SERIAL_FRAME_MAX_ENCODED];
+  int      length = Decode (rxFrame, rxLength, frame);
+
+  // type + at least one payload byte + CRC
+  if (length < 4 || length > SERIAL_FRAME_MAX_LENGTH)
+  {
+    ++badFrames;
+    return;
+  }
+
+  length -= 2;
+  if (Crc16 (frame, length) != (uint16_t)(frame[length] | (frame[length+1] << 8)) || frame[0] != SERIAL_FRAME_COMMAND)
+  {
+    ++badFrames;
+    return;
+  }
+
+  ++framesIn;
+  Node::CommandReceived (frame + 1, length - 1, TRANSPORT_SERIAL);
+}
+
+//--- Send ------------------------------------------------
+
+bool SerialLink::Send (uint8_t type, const uint8_t *payload, int length)
+{
+  uint8_t  frame[SERIAL_FRAME_MAX_LENGTH];
+
+  if (length < 1 || length > MAX_MESSAGE_LENGTH)
+    return false;
+
+  // type | payload | CRC
+  frame[0] = type;
+  memcpy (frame + 1, payload, length);
+
+  uint16_t  crc = Crc16 (frame, length + 1);
+  frame[length+1] = (uint8_t) crc;
+  frame[length+2] = (uint8_t)(crc >> 8);
+
+  // 0x00 | COBS | 0x00 in one write
+  int encoded = 1 + Encode (frame, length + 3, txFrame + 1);
+  txFrame[0] = 0;
+  txFrame[encoded++] = 0;
+
+  if ((int) Serial.write (txFrame, encoded) != encoded)
+  {
+    ++writeErrors;
+    return false;
+  }
+
+  ++framesOut;
+  return true;
+}
+
+//--- ResetStats ------------------------------------------
+
+void SerialLink::ResetStats ()
+{
+  framesIn = framesOut = badFrames = writeErrors = 0L;
+}
+
+//--- Crc16 -----------------------------------------------
+
+uint16_t SerialLink::Crc16 (const uint8_t *data, int length, uint16_t crc)
+{
+  for (int i=0; i<length; i++)
+  {
+    crc = (uint16_t)(crc << 4) ^ CrcNibbles[(crc >> 12) ^ (data[i] >> 4)];
+    crc = (uint16_t)(crc << 4) ^ CrcNibbles[(crc >> 12) ^ (data[i] & 0x0F)];
+  }
+
+  return crc;
+}
+
+//--- Encode ----------------------------------------------
+
+int SerialLink::Encode (const uint8_t *data, int length, uint8_t *encoded)
+{
+  // Each code byte says how far it is to the next 0x00 (0xFF = 254 bytes with no 0x00)
+  int      codeIndex = 0;
+  int      out       = 1;
+  uint8_t  code      = 1;
+
+  for (int i=0; i<length; i++)
+  {
+    if (data[i] != 0)
+    {
+      encoded[out++] = data[i];
+      if (++code < 0xFF)
+        continue;
+    }
+
+    encoded[codeIndex] = code;
+    codeIndex = out++;
+    code      = 1;
+  }
+
+  encoded[codeIndex] = code;
+  return out;
+}
+
+//--- Decode ----------------------------------------------
+
+int SerialLink::Decode (const uint8_t *encoded, int length, uint8_t *data)
+{
+  int  in  = 0;
+  int  out = 0;
+
+  while (in < length)
+  {
+    uint8_t  code = encoded[in++];
+    if (code == 0 || in + code - 1 > length)
+      return -1;
+
+    for (int i=1; i<code; i++)
+      data[out++] = encoded[in++];
+
+    // A code under 0xFF stands for a 0x00, except at the end
+    if (code < 0xFF && in < length)
+      data[out++] = 0;
+  }
+
+  return out;
+}
@@ -0,0 +1,77 @@
+//=========================================================
+//
+//     FILE : TokenBucket.cpp
+//
+//  PROJECT : SMAC Framework
+//              │
+//              └── Firmware
+//                    │
+//                    └── Node
+//
+//    NOTES : Outbound rate limiting.
+//            See TokenBucket.h for the rules.
+//
+//   AUTHOR : Bill Daniels
+//            Copyright 2021-2025, D+S Tech Labs, Inc.
+//            All Rights Reserved
+//
+//=========================================================
+
+//--- Includes --------------------------------------------
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "TokenBucket.h"
+
+//--- SetRate ---------------------------------------------
+
+void TokenBucket::SetRate (unsigned long perSecond)
+{
+  rate     = perSecond;
+  capacity = (float) perSecond * LIMIT_BURST_MS / 1000.0f;
+  tokens   = capacity;
+  lastUs   = esp_timer_get_time ();
+}
+
+//--- Refill ----------------------------------------------
+
+IRAM_ATTR void TokenBucket::Refill (int64_t nowUs)
+{
+  if (rate == 0 || nowUs <= lastUs)
+    return;
+
+  float  level = tokens + (float)(nowUs - lastUs) * rate / 1000000.0f;
+
+  tokens = (level > capacity) ? capacity : level;
+  lastUs = nowUs;
+}
+
+//--- Admits ----------------------------------------------
+
+IRAM_ATTR bool TokenBucket::Admits (TrafficClass trafficClass) const
+{
+  if (rate == 0)
+    return true;
+
+  switch (trafficClass)
+  {
+    case TRAFFIC_RESPONSE  : return true;
+    case TRAFFIC_STATUS    : return tokens > 0.0f;
+    default                : return tokens > capacity * TELEMETRY_RESERVE_PERCENT / 100.0f;
+  }
+}
+
+//--- Charge ----------------------------------------------
+
+IRAM_ATTR void TokenBucket::Charge (float used)
+{
+  if (rate == 0)
+    return;
+
+  // The floor is one charge below -capacity: when a frame costs more than the
+  // whole bucket (a slow limit), its debt must still be paid back in full
+  float  floor = -(capacity + used);
+  float  level = tokens - used;
+
+  tokens = (level < floor) ? floor : level;
+}
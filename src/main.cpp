@@ -17,6 +17,7 @@
 #include "freertos/semphr.h"
 #include "driver/gpio.h"
 #include "Node.h"
+#include "SerialLink.h"
 #include "DEV_Driver.h"
 #include "DEV_INA3221.h"
 
@@ -25,9 +26,6 @@
 //--- Globals ---------------------------------------------
 
 bool         Debugging = true;  // ((( Set to false for production builds )))
-char         Serial_Message[SERIAL_MAX_LENGTH];
-char         Serial_NextChar;
-int          Serial_Length = 0;
 esp_err_t    ESPNOW_Result;
 Preferences  MCUPreferences;  // Non-volatile memory
 uint8_t      RelayerMAC[MAC_SIZE];  // MAC Address of the Relayer Module stored in non-volatile memory.
@@ -35,9 +33,7 @@ uint8_t      RelayerMAC[MAC_SIZE];  // MAC Address of the Relayer Module stored
                                     // { 0x7C, 0xDF, 0xA1, 0xE0, 0x92, 0x98 }
 bool         WaitingForRelayer = true;
 RingBuffer   *CommandBuffer;
-DPacket      DataPacket;
-CPacket      CommandPacket;
-char         DataString[MAX_MESSAGE_LENGTH];
+SerialLink   USBLink;  // Console text and, on the bench, the framed SMAC protocol over USB
 
 Node      *ThisNode;  // The Node for this example
 DEV_Driver   *myDriver;
@@ -54,8 +50,7 @@ xSemaphoreHandle I2CMutex=xSemaphoreCreateMutex();
 //xSemmaphoreGive(I2CMutex);
 //--- Declarations ----------------------------------------
 
-void Serial_CheckInput     ();
-void Serial_ProcessMessage ();
+void Serial_ProcessMessage (const char *message);
 
 
 //=========================================================
@@ -69,7 +64,6 @@ void setup()
   STATUS_LED_BAD;
 
   // Init serial comms
-  Serial_Message[0] = 0;
   Serial.begin (SERIAL_BAUDRATE);
 
   Serial.println ("--- Program Start ----------------------");
@@ -101,7 +95,7 @@ void setup()
     RelayerMAC[3],RelayerMAC[4], RelayerMAC[5]);
 
 // Init Command buffer (a circular FIFO buffer)
-  CommandBuffer = new RingBuffer (FIFO);
+  CommandBuffer = new RingBuffer ();
 
   Serial.println("Starting the Node ...");
 
@@ -157,25 +151,30 @@ void setup()
     ThisNode->AddDevice(myIna3221Device);
   #endif
 
-  // PING the Relayer once per second until it responds with PONG
+  // Listen on the Serial port: text lines for the Set MAC Tool, frames from a USB host
+  ThisNode->UseSerialLink (&USBLink);
+  USBLink.Start (Serial_ProcessMessage);
+
+  // PING the Relayer once per second until it (or a USB host) responds with PONG
   Serial.println ("PINGing Relayer ...");
-  strcpy (DataPacket.deviceID, "00");
-  strcpy (DataPacket.value, "PING");
+  DPacket  pingPacket = {};
+  strcpy (pingPacket.deviceID, "00");
+  strcpy (pingPacket.value, "PING");
   unsigned long  nowSec, lastSec = 0L;
   WaitingForRelayer = true;
   while (WaitingForRelayer)
   {
-    DataPacket.timestamp = millis ();
-    nowSec = DataPacket.timestamp / 1000L;
+    pingPacket.timestamp = millis ();
+    nowSec = pingPacket.timestamp / 1000L;
 
     if (nowSec > lastSec)
     {
-      ThisNode->SendDataPacket ();
+      ThisNode->SendDataPacket (pingPacket);
       lastSec = nowSec;
     }
 
-    // Check for Set MAC Tool
-    Serial_CheckInput ();
+    // The serial link's task handles the Set MAC Tool meanwhile
+    delay (10);
   }
 
 
@@ -195,49 +194,6 @@ void loop()
 {
   // Keep the Node running
   ThisNode->Run ();
-
-  // Check for serial chars
-  Serial_CheckInput ();
-}
-
-
-//=========================================================
-//  Serial_CheckInput
-//  NO NEED TO CHANGE THIS CODE
-//=========================================================
-
-void Serial_CheckInput ()
-{
-  // Check serial port for characters
-  while (Serial.available ())
-  {
-    Serial_NextChar = (char) Serial.read ();
-    if (Serial_NextChar != '\r')  // ignore CR's
-    {
-      if (Serial_NextChar == '\n')
-      {
-        // Message is ready, terminate string and process it
-        Serial_Message[Serial_Length] = 0;
-        Serial_ProcessMessage ();
-
-        // Start new message
-        Serial_Length = 0;
-      }
-      else
-      {
-        // Add char to end of buffer
-        if (Serial_Length < SERIAL_MAX_LENGTH - 1)
-          Serial_Message[Serial_Length++] = Serial_NextChar;
-        else  // too long
-        {
-          Serial.println ("ERROR: Serial message is too long.");
-
-          // Ignore and start new message
-          Serial_Length = 0;
-        }
-      }
-    }
-  }
 }
 
 
@@ -246,29 +202,32 @@ void Serial_CheckInput ()
 //  NO NEED TO CHANGE THIS CODE
 //=========================================================
 
-void Serial_ProcessMessage ()
+void Serial_ProcessMessage (const char *message)
 {
+  // Called by the serial link task with each console text line
   // Check if using <Set MAC> tool
-  if (strcmp (Serial_Message, "SetRelayerMAC") == 0)
+  if (strcmp (message, "SetRelayerMAC") == 0)
   {
     // Send current setting
-    sprintf (DataString, "CurrentMAC=%02x:%02x:%02x:%02x:%02x:%02x", RelayerMAC[0], RelayerMAC[1], RelayerMAC[2], RelayerMAC[3], RelayerMAC[4], RelayerMAC[5]);
-    Serial.println (DataString);
+    char  macString[32];
+    sprintf (macString, "CurrentMAC=%02x:%02x:%02x:%02x:%02x:%02x", RelayerMAC[0], RelayerMAC[1], RelayerMAC[2], RelayerMAC[3], RelayerMAC[4], RelayerMAC[5]);
+    Serial.println (macString);
   }
-  else if (strncmp (Serial_Message, "NewMAC=", 7) == 0)
+  else if (strncmp (message, "NewMAC=", 7) == 0)
   {
-    if (strlen (Serial_Message) < 24)  // NewMAC=xx:xx:xx:xx:xx:xx
+    if (strlen (message) < 24)  // NewMAC=xx:xx:xx:xx:xx:xx
     {
       Serial.print   ("Invalid MAC Address: ");
-      Serial.println (Serial_Message);
+      Serial.println (message);
     }
     else
     {
       // Parse and set new MAC Address (xx:xx:xx:xx:xx:xx)
-      for (int i=7, j=0; j<sizeof(RelayerMAC); i+=3, j++)
+      for (int i=7, j=0; j<(int)sizeof(RelayerMAC); i+=3, j++)
       {
-        strncpy (DataString, Serial_Message+i, 2);  DataString[2] = 0;
-        sscanf  (DataString, "%02x", RelayerMAC+j);
+        char  hexByte[3];
+        strncpy (hexByte, message+i, 2);  hexByte[2] = 0;
+        sscanf  (hexByte, "%2hhx", RelayerMAC+j);
       }
 
       // Store new network credentials in non-volatile <preferences.h>
@@ -0,0 +1,220 @@
+/**
+ * @file test_main.cpp
+ * @author Doug Fajardo
+ * @brief Host unit tests for the control code, run with:  pio test -e native
+ * @version 0.1
+ * @date 2025-09-20
+ *
+ * @copyright Copyright (c) 2025
+ *
+ * These build the firmware sources against lib/NativeShim (test_build_src),
+ * so they also show that the native environment compiles the whole tree.
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include "PIDX.h"
+#include "Observer.h"
+#include "Capture.h"
+#include "RingBuffer.h"
+#include "TokenBucket.h"
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+
+// - - - - - - - - - - PIDX - - - - - - - - - -
+void test_pidx_proportional()
+{
+    double input = 10, output = 0, setpoint = 30;
+    PIDX pid(&input, &output, &setpoint, 2.0, 0.0, 0.0, P_ON_E, DIRECT);
+    pid.SetOutputLimits(-100, 100);
+    pid.SetMode(AUTOMATIC);
+
+    pid.ComputeFromTimer();
+    TEST_ASSERT_EQUAL_DOUBLE(40.0, output);
+
+    setpoint = 200;   // clamped to the output limits
+    pid.ComputeFromTimer();
+    TEST_ASSERT_EQUAL_DOUBLE(100.0, output);
+}
+
+
+void test_pidx_integral_follows_sample_time()
+{
+    double input = 0, output = 0, setpoint = 1;
+    PIDX pid(&input, &output, &setpoint, 0.0, 10.0, 0.0, P_ON_E, DIRECT);
+    pid.SetOutputLimits(-100, 100);
+    pid.SetSampleTimeUs(2500);   // Ki is per second: 10 * 0.0025 per sample
+    pid.SetMode(AUTOMATIC);
+
+    pid.ComputeFromTimer();
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 0.025, output);
+    TEST_ASSERT_EQUAL_DOUBLE(10.0, pid.GetKi());
+}
+
+
+// - - - - - - - - - - Observer - - - - - - - - - -
+void test_observer_tracks_constant_velocity()
+{
+    Observer obs(1.0e5, 1.0 / 12.0);
+    obs.reset(0);
+
+    // 400 counts/sec, a count reading every mSec
+    for (int ms = 1; ms <= 1000; ms++)
+    {
+        obs.update(floor(0.4 * ms) + 0.5, 0.001);
+    }
+    TEST_ASSERT_DOUBLE_WITHIN(4.0, 400.0, obs.velocity());
+    TEST_ASSERT_DOUBLE_WITHIN(1.0, 400.5, obs.position());
+}
+
+
+void test_observer_limit_velocity()
+{
+    Observer obs(1.0e5, 1.0 / 12.0);
+    obs.reset(0);
+    for (int ms = 1; ms <= 200; ms++)
+    {
+        obs.update(-1.0 * ms, 0.001);
+    }
+    obs.limitVelocity(50.0);
+    TEST_ASSERT_EQUAL_DOUBLE(-50.0, obs.velocity());
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, obs.acceleration());
+}
+
+
+// - - - - - - - - - - Capture - - - - - - - - - -
+void test_capture_base64()
+{
+    char text[16];
+    TEST_ASSERT_EQUAL_INT(4, Capture::encodeBase64((const uint8_t *)"Man", 3, text));
+    TEST_ASSERT_EQUAL_STRING("TWFu", text);
+    Capture::encodeBase64((const uint8_t *)"Ma", 2, text);
+    TEST_ASSERT_EQUAL_STRING("TWE=", text);
+    Capture::encodeBase64((const uint8_t *)"M", 1, text);
+    TEST_ASSERT_EQUAL_STRING("TQ==", text);
+}
+
+
+void test_capture_keeps_pre_trigger_samples()
+{
+    Capture cap;
+    Capture::Record rec = {};
+    Capture::Record out[8];
+
+    TEST_ASSERT_TRUE(cap.allocate());
+    TEST_ASSERT_TRUE(cap.arm(Capture::TRIGGER_MOTION, 1, 3, 4));
+
+    // 10 samples before the motion command: only the latest 3 are kept
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_TRUE(cap.sampleDue());
+        rec.timeUs = i;
+        cap.add(rec);
+    }
+    cap.triggerOnMotion();
+    for (uint32_t i = 10; i < 14; i++)
+    {
+        TEST_ASSERT_TRUE(cap.sampleDue());
+        rec.timeUs = i;
+        cap.add(rec);
+    }
+    TEST_ASSERT_FALSE(cap.sampleDue());
+
+    Capture::Status st = cap.getStatus();
+    TEST_ASSERT_EQUAL_INT(Capture::CAPTURE_DONE, st.state);
+    TEST_ASSERT_EQUAL_UINT32(7, st.records);
+    TEST_ASSERT_EQUAL_UINT32(3, st.triggerIndex);
+    TEST_ASSERT_EQUAL_UINT32(10, st.triggerUs);
+
+    TEST_ASSERT_EQUAL_INT(7, cap.read(0, out, 8));
+    for (int i = 0; i < 7; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(7 + i, out[i].timeUs);
+    }
+    TEST_ASSERT_EQUAL_INT(0, cap.read(7, out, 8));
+}
+
+
+// - - - - - - - - - - RingBuffer - - - - - - - - - -
+void test_ringbuffer_fifo_and_overflow()
+{
+    RingBuffer ring;
+
+    TEST_ASSERT_NULL(ring.PeekString());
+    TEST_ASSERT_TRUE(ring.PushString("one", 3, 11));
+    TEST_ASSERT_TRUE(ring.PushString("two", 3, 22));
+    TEST_ASSERT_EQUAL_STRING("one", ring.PeekString());
+    TEST_ASSERT_EQUAL_INT64(11, ring.PeekStamp());
+    ring.ReleaseString();
+    TEST_ASSERT_EQUAL_STRING("two", ring.PeekString());
+    ring.ReleaseString();
+    TEST_ASSERT_NULL(ring.PeekString());
+
+    // A full buffer drops the push and counts it
+    for (int i = 0; i < MAX_ELEMENTS; i++)
+    {
+        TEST_ASSERT_TRUE(ring.PushString("x", 1));
+    }
+    TEST_ASSERT_FALSE(ring.PushString("y", 1));
+    TEST_ASSERT_EQUAL_UINT32(1, ring.GetOverflowCount());
+    TEST_ASSERT_EQUAL_INT(MAX_ELEMENTS, ring.GetNumElements());
+}
+
+
+// - - - - - - - - - - TokenBucket - - - - - - - - - -
+// Offer a frame of <cost> every millisecond for <seconds>, like Run() does
+static int admitted(unsigned long perSecond, float cost, TrafficClass trafficClass, int seconds)
+{
+    TokenBucket bucket;
+    int         count = 0;
+
+    bucket.SetRate(perSecond);
+    bucket.lastUs = 0;
+    for (int64_t nowUs = 0; nowUs < seconds * 1000000LL; nowUs += 1000)
+    {
+        bucket.Refill(nowUs);
+        if (bucket.Admits(trafficClass))
+        {
+            bucket.Charge(cost);
+            count++;
+        }
+    }
+    return(count);
+}
+
+void test_tokenbucket_holds_the_rate_when_a_charge_exceeds_capacity()
+{
+    // 5 records/s holds half a record and 2000 B/s 200 B, less than one charge.
+    // Over 10 s, only the bucket it starts with (and one charge of debt) may go
+    // above the rate.
+    TEST_ASSERT_INT_WITHIN(1, 50, admitted(5, 1.0f, TRAFFIC_STATUS, 10));
+    TEST_ASSERT_INT_WITHIN(1, 50, admitted(5, 1.0f, TRAFFIC_TELEMETRY, 10));
+    TEST_ASSERT_INT_WITHIN(1, (200 + 2000 * 10) / 300, admitted(2000, 300.0f, TRAFFIC_STATUS, 10));
+    TEST_ASSERT_INT_WITHIN(1, (200 + 2000 * 10) / 300, admitted(2000, 300.0f, TRAFFIC_TELEMETRY, 10));
+
+    // Responses are never held back
+    TEST_ASSERT_EQUAL_INT(10000, admitted(5, 1.0f, TRAFFIC_RESPONSE, 10));
+}
+
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_pidx_proportional);
+    RUN_TEST(test_pidx_integral_follows_sample_time);
+    RUN_TEST(test_observer_tracks_constant_velocity);
+    RUN_TEST(test_observer_limit_velocity);
+    RUN_TEST(test_capture_base64);
+    RUN_TEST(test_capture_keeps_pre_trigger_samples);
+    RUN_TEST(test_ringbuffer_fifo_and_overflow);
+    RUN_TEST(test_tokenbucket_holds_the_rate_when_a_charge_exceeds_capacity);
+    return(UNITY_END());
+}